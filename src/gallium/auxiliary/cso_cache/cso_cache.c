@@ -30,59 +30,110 @@
 
 #include "util/u_debug.h"
 
+#include "util/u_math.h"
 #include "util/u_memory.h"
+#include "util/hash_table.h"
 
 #include "cso_cache.h"
-#include "cso_hash.h"
 
 
+/* Smallest non-empty table, in slots. */
+#define CSO_TABLE_MIN_SIZE 16
+
+/* Marks a slot whose state was removed.  Lookups have to probe past it,
+ * inserts may reuse it.
+ */
+static char cso_deleted_state;
+#define CSO_DELETED ((void *)&cso_deleted_state)
+
+struct cso_table_entry {
+   unsigned hash_key;
+   void *state;         /**< NULL if the slot was never used */
+};
+
+/**
+ * Open-addressing (linear probing) table.  The table always keeps at least
+ * a quarter of its slots NULL so that probe sequences terminate.
+ */
+struct cso_table {
+   struct cso_table_entry *entries;
+   unsigned size;       /**< number of slots, a power of two (or zero) */
+   unsigned count;      /**< live states */
+   unsigned used;       /**< live states plus deleted slots */
+};
+
 struct cso_cache {
-   struct cso_hash hashes[CSO_CACHE_MAX];
+   struct cso_table tables[CSO_CACHE_MAX];
    int    max_size;
 
    cso_sanitize_callback sanitize_cb;
    void                 *sanitize_data;
 };
 
-#if 1
-static unsigned hash_key(const void *key, unsigned key_size)
+unsigned cso_construct_key(void *item, int item_size)
 {
-   unsigned *ikey = (unsigned *)key;
-   unsigned hash = 0, i;
-
-   assert(key_size % 4 == 0);
-
-   /* I'm sure this can be improved on:
-    */
-   for (i = 0; i < key_size/4; i++)
-      hash ^= ikey[i];
+   return _mesa_hash_data(item, item_size);
+}
 
-   return hash;
+static inline struct cso_table *_cso_table_for_type(struct cso_cache *sc, enum cso_cache_type type)
+{
+   return &sc->tables[type];
 }
-#else
-static unsigned hash_key(const unsigned char *p, int n)
+
+static inline boolean
+cso_table_entry_is_live(const struct cso_table_entry *entry)
 {
-   unsigned h = 0;
-   unsigned g;
-
-   while (n--) {
-      h = (h << 4) + *p++;
-      if ((g = (h & 0xf0000000)) != 0)
-         h ^= g >> 23;
-      h &= ~g;
-   }
-   return h;
+   return entry->state && entry->state != CSO_DELETED;
 }
-#endif
 
-unsigned cso_construct_key(void *item, int item_size)
+static void
+cso_table_insert_entry(struct cso_table *table, unsigned hash_key, void *state)
 {
-   return hash_key((item), item_size);
+   unsigned mask = table->size - 1;
+   unsigned i = hash_key & mask;
+
+   while (cso_table_entry_is_live(&table->entries[i]))
+      i = (i + 1) & mask;
+
+   if (!table->entries[i].state)
+      table->used++;
+   table->entries[i].hash_key = hash_key;
+   table->entries[i].state = state;
+   table->count++;
 }
 
-static inline struct cso_hash *_cso_hash_for_type(struct cso_cache *sc, enum cso_cache_type type)
+/**
+ * Reallocate the table so that it is at most half full once one more state
+ * has been added.  This also drops all deleted slots.  The stored hashes
+ * are reused, the states themselves are not touched.
+ */
+static boolean
+cso_table_resize(struct cso_table *table)
 {
-   return &sc->hashes[type];
+   struct cso_table_entry *old_entries = table->entries;
+   unsigned old_size = table->size;
+   unsigned size = MAX2(util_next_power_of_two((table->count + 1) * 2),
+                        CSO_TABLE_MIN_SIZE);
+   unsigned i;
+
+   table->entries = CALLOC(size, sizeof(*table->entries));
+   if (!table->entries) {
+      table->entries = old_entries;
+      return FALSE;
+   }
+
+   table->size = size;
+   table->count = 0;
+   table->used = 0;
+
+   for (i = 0; i < old_size; i++) {
+      if (cso_table_entry_is_live(&old_entries[i]))
+         cso_table_insert_entry(table, old_entries[i].hash_key,
+                                old_entries[i].state);
+   }
+
+   FREE(old_entries);
+   return TRUE;
 }
 
 static void delete_blend_state(void *state, UNUSED void *data)
@@ -125,7 +176,8 @@ static void delete_velements(void *state, UNUSED void *data)
    FREE(state);
 }
 
-static inline void delete_cso(void *state, enum cso_cache_type type)
+static inline boolean delete_cso(void *state, enum cso_cache_type type,
+                                 UNUSED void *user_data)
 {
    switch (type) {
    case CSO_BLEND:
@@ -147,111 +199,135 @@ static inline void delete_cso(void *state, enum cso_cache_type type)
       assert(0);
       FREE(state);
    }
+   return TRUE;
 }
 
 
 static inline void sanitize_hash(struct cso_cache *sc,
-                                 struct cso_hash *hash,
                                  enum cso_cache_type type,
                                  int max_size)
 {
    if (sc->sanitize_cb)
-      sc->sanitize_cb(hash, type, max_size, sc->sanitize_data);
+      sc->sanitize_cb(sc, type, max_size, sc->sanitize_data);
 }
 
 
-static inline void sanitize_cb(struct cso_hash *hash, enum cso_cache_type type,
+static inline void sanitize_cb(struct cso_cache *sc, enum cso_cache_type type,
 			       int max_size, UNUSED void *user_data)
 {
    /* if we're approach the maximum size, remove fourth of the entries
     * otherwise every subsequent call will go through the same */
-   int hash_size = cso_hash_size(hash);
+   int hash_size = cso_cache_size(sc, type);
    int max_entries = (max_size > hash_size) ? max_size : hash_size;
    int to_remove =  (max_size < max_entries) * max_entries/4;
    if (hash_size > max_size)
       to_remove += hash_size - max_size;
-   while (to_remove) {
-      /*remove elements until we're good */
-      /*fixme: currently we pick the nodes to remove at random*/
-      struct cso_hash_iter iter = cso_hash_first_node(hash);
-      void  *cso = cso_hash_take(hash, cso_hash_iter_key(iter));
-      delete_cso(cso, type);
-      --to_remove;
-   }
+   /*fixme: currently we pick the entries to remove at random*/
+   cso_evict_states(sc, type, to_remove, delete_cso, NULL);
 }
 
-struct cso_hash_iter
+boolean
 cso_insert_state(struct cso_cache *sc,
                  unsigned hash_key, enum cso_cache_type type,
                  void *state)
 {
-   struct cso_hash *hash = _cso_hash_for_type(sc, type);
-   sanitize_hash(sc, hash, type, sc->max_size);
+   struct cso_table *table = _cso_table_for_type(sc, type);
+   sanitize_hash(sc, type, sc->max_size);
+
+   if ((table->used + 1) * 4 > table->size * 3 &&
+       !cso_table_resize(table))
+      return FALSE;
 
-   return cso_hash_insert(hash, hash_key, state);
+   cso_table_insert_entry(table, hash_key, state);
+   return TRUE;
 }
 
-struct cso_hash_iter
-cso_find_state(struct cso_cache *sc,
-               unsigned hash_key, enum cso_cache_type type)
+
+/**
+ * Return the cached state whose first \p size bytes match \p templ, or
+ * NULL.  Only slots with a matching hash are compared.
+ */
+void *
+cso_find_state_template(struct cso_cache *sc,
+                        unsigned hash_key, enum cso_cache_type type,
+                        const void *templ, unsigned size)
 {
-   struct cso_hash *hash = _cso_hash_for_type(sc, type);
+   const struct cso_table *table = _cso_table_for_type(sc, type);
+   unsigned mask = table->size - 1;
+   unsigned i;
 
-   return cso_hash_find(hash, hash_key);
-}
+   if (!table->count)
+      return NULL;
 
+   for (i = hash_key & mask; table->entries[i].state; i = (i + 1) & mask) {
+      const struct cso_table_entry *entry = &table->entries[i];
 
-void *cso_hash_find_data_from_template( struct cso_hash *hash,
-				        unsigned hash_key, 
-				        void *templ,
-				        int size )
-{
-   struct cso_hash_iter iter = cso_hash_find(hash, hash_key);
-   while (!cso_hash_iter_is_null(iter)) {
-      void *iter_data = cso_hash_iter_data(iter);
-      if (!memcmp(iter_data, templ, size)) {
-	 /* We found a match
-	  */
-         return iter_data;
-      }
-      iter = cso_hash_iter_next(iter);
+      if (entry->hash_key == hash_key && entry->state != CSO_DELETED &&
+          !memcmp(entry->state, templ, size))
+         return entry->state;
    }
    return NULL;
 }
 
+/**
+ * Remove \p state from the cache without deleting it.
+ */
+boolean cso_take_state(struct cso_cache *sc, unsigned hash_key,
+                       enum cso_cache_type type, void *state)
+{
+   struct cso_table *table = _cso_table_for_type(sc, type);
+   unsigned mask = table->size - 1;
+   unsigned i;
+
+   if (!table->count)
+      return FALSE;
+
+   for (i = hash_key & mask; table->entries[i].state; i = (i + 1) & mask) {
+      if (table->entries[i].state == state) {
+         table->entries[i].state = CSO_DELETED;
+         table->count--;
+         return TRUE;
+      }
+   }
+   return FALSE;
+}
 
-struct cso_hash_iter cso_find_state_template(struct cso_cache *sc,
-                                             unsigned hash_key, enum cso_cache_type type,
-                                             void *templ, unsigned size)
+/**
+ * Offer up to \p count states of the given type to \p func and drop those
+ * it destroyed.  Returns the number of states removed.
+ */
+int cso_evict_states(struct cso_cache *sc, enum cso_cache_type type,
+                     int count, cso_evict_callback func, void *user_data)
 {
-   struct cso_hash_iter iter = cso_find_state(sc, hash_key, type);
-   while (!cso_hash_iter_is_null(iter)) {
-      void *iter_data = cso_hash_iter_data(iter);
-      if (!memcmp(iter_data, templ, size))
-         return iter;
-      iter = cso_hash_iter_next(iter);
+   struct cso_table *table = _cso_table_for_type(sc, type);
+   int removed = 0;
+   unsigned i;
+
+   for (i = 0; i < table->size && removed < count; i++) {
+      struct cso_table_entry *entry = &table->entries[i];
+
+      if (cso_table_entry_is_live(entry) &&
+          func(entry->state, type, user_data)) {
+         entry->state = CSO_DELETED;
+         table->count--;
+         removed++;
+      }
    }
-   return iter;
+   return removed;
 }
 
-void * cso_take_state(struct cso_cache *sc,
-                      unsigned hash_key, enum cso_cache_type type)
+int cso_cache_size(const struct cso_cache *sc, enum cso_cache_type type)
 {
-   struct cso_hash *hash = _cso_hash_for_type(sc, type);
-   return cso_hash_take(hash, hash_key);
+   return sc->tables[type].count;
 }
 
 struct cso_cache *cso_cache_create(void)
 {
-   struct cso_cache *sc = MALLOC_STRUCT(cso_cache);
-   int i;
+   struct cso_cache *sc = CALLOC_STRUCT(cso_cache);
    if (!sc)
       return NULL;
 
    sc->max_size           = 4096;
-   for (i = 0; i < CSO_CACHE_MAX; i++)
-      cso_hash_init(&sc->hashes[i]);
-
    sc->sanitize_cb        = sanitize_cb;
    sc->sanitize_data      = 0;
 
@@ -261,16 +337,12 @@ struct cso_cache *cso_cache_create(void)
 void cso_for_each_state(struct cso_cache *sc, enum cso_cache_type type,
                         cso_state_callback func, void *user_data)
 {
-   struct cso_hash *hash = _cso_hash_for_type(sc, type);
-   struct cso_hash_iter iter;
-
-   iter = cso_hash_first_node(hash);
-   while (!cso_hash_iter_is_null(iter)) {
-      void *state = cso_hash_iter_data(iter);
-      iter = cso_hash_iter_next(iter);
-      if (state) {
-         func(state, user_data);
-      }
+   struct cso_table *table = _cso_table_for_type(sc, type);
+   unsigned i;
+
+   for (i = 0; i < table->size; i++) {
+      if (cso_table_entry_is_live(&table->entries[i]))
+         func(table->entries[i].state, user_data);
    }
 }
 
@@ -290,7 +362,7 @@ void cso_cache_delete(struct cso_cache *sc)
    cso_for_each_state(sc, CSO_VELEMENTS, delete_velements, 0);
 
    for (i = 0; i < CSO_CACHE_MAX; i++)
-      cso_hash_deinit(&sc->hashes[i]);
+      FREE(sc->tables[i].entries);
 
    FREE(sc);
 }
@@ -302,7 +374,7 @@ void cso_set_maximum_cache_size(struct cso_cache *sc, int number)
    sc->max_size = number;
 
    for (i = 0; i < CSO_CACHE_MAX; i++)
-      sanitize_hash(sc, &sc->hashes[i], i, sc->max_size);
+      sanitize_hash(sc, i, sc->max_size);
 }
 
 int cso_maximum_cache_size(const struct cso_cache *sc)
@@ -317,4 +389,3 @@ void cso_cache_set_sanitize_callback(struct cso_cache *sc,
    sc->sanitize_cb   = cb;
    sc->sanitize_data = user_data;
 }
-
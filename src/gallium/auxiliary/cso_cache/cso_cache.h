@@ -45,6 +45,10 @@
   * driver look a lot neater, plus it avoids all the redundant state
   * translations on every frame.
   *
+  * The states of each type live in an open-addressing hash table whose
+  * slots keep the precomputed hash next to the state pointer, so a lookup
+  * only dereferences (and memcmp's) states whose hash matches.
+  *
   * Currently our constant state objects are:
   * - alpha test
   * - blend
@@ -76,10 +80,6 @@
 #include "pipe/p_context.h"
 #include "pipe/p_state.h"
 
-/* cso_hash.h is necessary for cso_hash_iter, as MSVC requires structures
- * returned by value to be fully defined */
-#include "cso_hash.h"
-
 
 #ifdef	__cplusplus
 extern "C" {
@@ -96,12 +96,20 @@ enum cso_cache_type {
 
 typedef void (*cso_state_callback)(void *ctx, void *obj);
 
-typedef void (*cso_sanitize_callback)(struct cso_hash *hash,
+struct cso_cache;
+
+typedef void (*cso_sanitize_callback)(struct cso_cache *sc,
                                       enum cso_cache_type type,
                                       int max_size,
                                       void *user_data);
 
-struct cso_cache;
+/**
+ * Called by cso_evict_states() for candidate entries.  Returns true if the
+ * state was destroyed and its entry should be dropped from the cache.
+ */
+typedef boolean (*cso_evict_callback)(void *state,
+                                      enum cso_cache_type type,
+                                      void *user_data);
 
 struct cso_blend {
    struct pipe_blend_state state;
@@ -129,7 +137,6 @@ struct cso_sampler {
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
-   unsigned hash_key;
 };
 
 struct cso_velems_state {
@@ -153,18 +160,19 @@ void cso_cache_set_sanitize_callback(struct cso_cache *sc,
                                      cso_sanitize_callback cb,
                                      void *user_data);
 
-struct cso_hash_iter cso_insert_state(struct cso_cache *sc,
-                                      unsigned hash_key, enum cso_cache_type type,
-                                      void *state);
-struct cso_hash_iter cso_find_state(struct cso_cache *sc,
-                                    unsigned hash_key, enum cso_cache_type type);
-struct cso_hash_iter cso_find_state_template(struct cso_cache *sc,
-                                             unsigned hash_key, enum cso_cache_type type,
-                                             void *templ, unsigned size);
+boolean cso_insert_state(struct cso_cache *sc,
+                         unsigned hash_key, enum cso_cache_type type,
+                         void *state);
+void *cso_find_state_template(struct cso_cache *sc,
+                              unsigned hash_key, enum cso_cache_type type,
+                              const void *templ, unsigned size);
 void cso_for_each_state(struct cso_cache *sc, enum cso_cache_type type,
                         cso_state_callback func, void *user_data);
-void * cso_take_state(struct cso_cache *sc, unsigned hash_key,
-                      enum cso_cache_type type);
+boolean cso_take_state(struct cso_cache *sc, unsigned hash_key,
+                       enum cso_cache_type type, void *state);
+int cso_evict_states(struct cso_cache *sc, enum cso_cache_type type,
+                     int count, cso_evict_callback func, void *user_data);
+int cso_cache_size(const struct cso_cache *sc, enum cso_cache_type type);
 
 void cso_set_maximum_cache_size(struct cso_cache *sc, int number);
 int cso_maximum_cache_size(const struct cso_cache *sc);
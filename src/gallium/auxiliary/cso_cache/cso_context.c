@@ -46,7 +46,6 @@
 
 #include "cso_cache/cso_context.h"
 #include "cso_cache/cso_cache.h"
-#include "cso_cache/cso_hash.h"
 #include "cso_context.h"
 
 
@@ -163,9 +162,30 @@ static boolean delete_depth_stencil_state(struct cso_context *ctx, void *state)
    return TRUE;
 }
 
-static boolean delete_sampler_state(UNUSED struct cso_context *ctx, void *state)
+static boolean sampler_is_bound(const struct sampler_info *info,
+                                const struct cso_sampler *cso)
+{
+   unsigned i;
+
+   for (i = 0; i < PIPE_MAX_SAMPLERS; i++) {
+      if (info->cso_samplers[i] == cso)
+         return TRUE;
+   }
+   return FALSE;
+}
+
+static boolean delete_sampler_state(struct cso_context *ctx, void *state)
 {
    struct cso_sampler *cso = (struct cso_sampler *)state;
+   unsigned i;
+
+   for (i = 0; i < PIPE_SHADER_TYPES; i++) {
+      if (sampler_is_bound(&ctx->samplers[i], cso))
+         return FALSE;
+   }
+   if (sampler_is_bound(&ctx->fragment_samplers_saved, cso))
+      return FALSE;
+
    if (cso->delete_state)
       cso->delete_state(cso->context, cso->data);
    FREE(state);
@@ -199,9 +219,11 @@ static boolean delete_vertex_elements(struct cso_context *ctx,
 }
 
 
-static inline boolean delete_cso(struct cso_context *ctx,
-                                 void *state, enum cso_cache_type type)
+static boolean delete_cso(void *state, enum cso_cache_type type,
+                          void *user_data)
 {
+   struct cso_context *ctx = (struct cso_context *)user_data;
+
    switch (type) {
    case CSO_BLEND:
       return delete_blend_state(ctx, state);
@@ -221,18 +243,14 @@ static inline boolean delete_cso(struct cso_context *ctx,
 }
 
 static inline void
-sanitize_hash(struct cso_hash *hash, enum cso_cache_type type,
+sanitize_hash(struct cso_cache *cache, enum cso_cache_type type,
               int max_size, void *user_data)
 {
-   struct cso_context *ctx = (struct cso_context *)user_data;
    /* if we're approach the maximum size, remove fourth of the entries
     * otherwise every subsequent call will go through the same */
-   int hash_size = cso_hash_size(hash);
+   int hash_size = cso_cache_size(cache, type);
    int max_entries = (max_size > hash_size) ? max_size : hash_size;
    int to_remove =  (max_size < max_entries) * max_entries/4;
-   struct cso_hash_iter iter;
-   struct cso_sampler **samplers_to_restore = NULL;
-   unsigned to_restore = 0;
 
    if (hash_size > max_size)
       to_remove += hash_size - max_size;
@@ -240,51 +258,10 @@ sanitize_hash(struct cso_hash *hash, enum cso_cache_type type,
    if (to_remove == 0)
       return;
 
-   if (type == CSO_SAMPLER) {
-      int i, j;
-
-      samplers_to_restore = MALLOC(PIPE_SHADER_TYPES * PIPE_MAX_SAMPLERS *
-                                   sizeof(*samplers_to_restore));
-
-      /* Temporarily remove currently bound sampler states from the hash
-       * table, to prevent them from being deleted
-       */
-      for (i = 0; i < PIPE_SHADER_TYPES; i++) {
-         for (j = 0; j < PIPE_MAX_SAMPLERS; j++) {
-            struct cso_sampler *sampler = ctx->samplers[i].cso_samplers[j];
-
-            if (sampler && cso_hash_take(hash, sampler->hash_key))
-               samplers_to_restore[to_restore++] = sampler;
-         }
-      }
-   }
-
-   iter = cso_hash_first_node(hash);
-   while (to_remove) {
-      /*remove elements until we're good */
-      /*fixme: currently we pick the nodes to remove at random*/
-      void *cso = cso_hash_iter_data(iter);
-
-      if (!cso)
-         break;
-
-      if (delete_cso(ctx, cso, type)) {
-         iter = cso_hash_erase(hash, iter);
-         --to_remove;
-      } else
-         iter = cso_hash_iter_next(iter);
-   }
-
-   if (type == CSO_SAMPLER) {
-      /* Put currently bound sampler states back into the hash table */
-      while (to_restore--) {
-         struct cso_sampler *sampler = samplers_to_restore[to_restore];
-
-         cso_hash_insert(hash, sampler->hash_key, sampler);
-      }
-
-      FREE(samplers_to_restore);
-   }
+   /* Currently bound states are skipped by delete_cso().
+    * fixme: currently we pick the states to remove at random
+    */
+   cso_evict_states(cache, type, to_remove, delete_cso, user_data);
 }
 
 static void cso_init_vbuf(struct cso_context *cso, unsigned flags)
@@ -466,18 +443,18 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
                               const struct pipe_blend_state *templ)
 {
    unsigned key_size, hash_key;
-   struct cso_hash_iter iter;
+   struct cso_blend *cso;
    void *handle;
 
    key_size = templ->independent_blend_enable ?
       sizeof(struct pipe_blend_state) :
       (char *)&(templ->rt[1]) - (char *)templ;
    hash_key = cso_construct_key((void*)templ, key_size);
-   iter = cso_find_state_template(ctx->cache, hash_key, CSO_BLEND,
-                                  (void*)templ, key_size);
+   cso = cso_find_state_template(ctx->cache, hash_key, CSO_BLEND,
+                                 templ, key_size);
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_blend *cso = MALLOC(sizeof(struct cso_blend));
+   if (!cso) {
+      cso = MALLOC(sizeof(struct cso_blend));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -487,17 +464,12 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
       cso->delete_state = (cso_state_callback)ctx->pipe->delete_blend_state;
       cso->context = ctx->pipe;
 
-      iter = cso_insert_state(ctx->cache, hash_key, CSO_BLEND, cso);
-      if (cso_hash_iter_is_null(iter)) {
+      if (!cso_insert_state(ctx->cache, hash_key, CSO_BLEND, cso)) {
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_blend *)cso_hash_iter_data(iter))->data;
    }
+   handle = cso->data;
 
    if (ctx->blend != handle) {
       ctx->blend = handle;
@@ -531,15 +503,13 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
 {
    unsigned key_size = sizeof(struct pipe_depth_stencil_alpha_state);
    unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_DEPTH_STENCIL_ALPHA,
-                                                       (void*)templ, key_size);
+   struct cso_depth_stencil_alpha *cso =
+      cso_find_state_template(ctx->cache, hash_key, CSO_DEPTH_STENCIL_ALPHA,
+                              templ, key_size);
    void *handle;
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_depth_stencil_alpha *cso =
-         MALLOC(sizeof(struct cso_depth_stencil_alpha));
+   if (!cso) {
+      cso = MALLOC(sizeof(struct cso_depth_stencil_alpha));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -550,19 +520,13 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
          (cso_state_callback)ctx->pipe->delete_depth_stencil_alpha_state;
       cso->context = ctx->pipe;
 
-      iter = cso_insert_state(ctx->cache, hash_key,
-                              CSO_DEPTH_STENCIL_ALPHA, cso);
-      if (cso_hash_iter_is_null(iter)) {
+      if (!cso_insert_state(ctx->cache, hash_key,
+                            CSO_DEPTH_STENCIL_ALPHA, cso)) {
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_depth_stencil_alpha *)
-                cso_hash_iter_data(iter))->data;
    }
+   handle = cso->data;
 
    if (ctx->depth_stencil != handle) {
       ctx->depth_stencil = handle;
@@ -596,10 +560,9 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
 {
    unsigned key_size = sizeof(struct pipe_rasterizer_state);
    unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_RASTERIZER,
-                                                       (void*)templ, key_size);
+   struct cso_rasterizer *cso =
+      cso_find_state_template(ctx->cache, hash_key, CSO_RASTERIZER,
+                              templ, key_size);
    void *handle = NULL;
 
    /* We can't have both point_quad_rasterization (sprites) and point_smooth
@@ -607,8 +570,8 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
     */
    assert(!(templ->point_quad_rasterization && templ->point_smooth));
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_rasterizer *cso = MALLOC(sizeof(struct cso_rasterizer));
+   if (!cso) {
+      cso = MALLOC(sizeof(struct cso_rasterizer));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -618,17 +581,12 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
          (cso_state_callback)ctx->pipe->delete_rasterizer_state;
       cso->context = ctx->pipe;
 
-      iter = cso_insert_state(ctx->cache, hash_key, CSO_RASTERIZER, cso);
-      if (cso_hash_iter_is_null(iter)) {
+      if (!cso_insert_state(ctx->cache, hash_key, CSO_RASTERIZER, cso)) {
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_rasterizer *)cso_hash_iter_data(iter))->data;
    }
+   handle = cso->data;
 
    if (ctx->rasterizer != handle) {
       ctx->rasterizer = handle;
@@ -1009,7 +967,7 @@ cso_set_vertex_elements_direct(struct cso_context *ctx,
                                const struct cso_velems_state *velems)
 {
    unsigned key_size, hash_key;
-   struct cso_hash_iter iter;
+   struct cso_velements *cso;
    void *handle;
 
    /* Need to include the count into the stored state data too.
@@ -1020,11 +978,11 @@ cso_set_vertex_elements_direct(struct cso_context *ctx,
    key_size = sizeof(struct pipe_vertex_element) * velems->count +
               sizeof(unsigned);
    hash_key = cso_construct_key((void*)velems, key_size);
-   iter = cso_find_state_template(ctx->cache, hash_key, CSO_VELEMENTS,
-                                  (void*)velems, key_size);
+   cso = cso_find_state_template(ctx->cache, hash_key, CSO_VELEMENTS,
+                                 velems, key_size);
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_velements *cso = MALLOC(sizeof(struct cso_velements));
+   if (!cso) {
+      cso = MALLOC(sizeof(struct cso_velements));
       if (!cso)
          return;
 
@@ -1036,17 +994,12 @@ cso_set_vertex_elements_direct(struct cso_context *ctx,
          (cso_state_callback) ctx->pipe->delete_vertex_elements_state;
       cso->context = ctx->pipe;
 
-      iter = cso_insert_state(ctx->cache, hash_key, CSO_VELEMENTS, cso);
-      if (cso_hash_iter_is_null(iter)) {
+      if (!cso_insert_state(ctx->cache, hash_key, CSO_VELEMENTS, cso)) {
          FREE(cso);
          return;
       }
-
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_velements *)cso_hash_iter_data(iter))->data;
    }
+   handle = cso->data;
 
    if (ctx->velements != handle) {
       ctx->velements = handle;
@@ -1235,15 +1188,22 @@ cso_single_sampler(struct cso_context *ctx, enum pipe_shader_type shader_stage,
                    unsigned idx, const struct pipe_sampler_state *templ)
 {
    if (templ) {
+      struct cso_sampler *cso = ctx->samplers[shader_stage].cso_samplers[idx];
+
+      /* Most slots keep their state from one call to the next.  Comparing
+       * with the bound state is much cheaper than hashing it.
+       */
+      if (cso && !memcmp(&cso->state, templ, sizeof(*templ))) {
+         ctx->max_sampler_seen = MAX2(ctx->max_sampler_seen, (int)idx);
+         return;
+      }
+
       unsigned key_size = sizeof(struct pipe_sampler_state);
       unsigned hash_key = cso_construct_key((void*)templ, key_size);
-      struct cso_sampler *cso;
-      struct cso_hash_iter iter =
-         cso_find_state_template(ctx->cache,
-                                 hash_key, CSO_SAMPLER,
-                                 (void *) templ, key_size);
 
-      if (cso_hash_iter_is_null(iter)) {
+      cso = cso_find_state_template(ctx->cache, hash_key, CSO_SAMPLER,
+                                    templ, key_size);
+      if (!cso) {
          cso = MALLOC(sizeof(struct cso_sampler));
          if (!cso)
             return;
@@ -1253,17 +1213,12 @@ cso_single_sampler(struct cso_context *ctx, enum pipe_shader_type shader_stage,
          cso->delete_state =
             (cso_state_callback) ctx->pipe->delete_sampler_state;
          cso->context = ctx->pipe;
-         cso->hash_key = hash_key;
 
-         iter = cso_insert_state(ctx->cache, hash_key, CSO_SAMPLER, cso);
-         if (cso_hash_iter_is_null(iter)) {
+         if (!cso_insert_state(ctx->cache, hash_key, CSO_SAMPLER, cso)) {
             FREE(cso);
             return;
          }
       }
-      else {
-         cso = cso_hash_iter_data(iter);
-      }
 
       ctx->samplers[shader_stage].cso_samplers[idx] = cso;
       ctx->samplers[shader_stage].samplers[idx] = cso->data;
@@ -1740,6 +1695,28 @@ cso_draw_vbo(struct cso_context *cso,
    }
 }
 
+void
+cso_multi_draw(struct cso_context *cso,
+               const struct pipe_draw_info *info,
+               const struct pipe_draw_start_count *draws,
+               unsigned num_draws)
+{
+   struct u_vbuf *vbuf = cso->vbuf_current;
+
+   assert(info->indirect == NULL && info->count_from_stream_output == NULL);
+
+   if (vbuf) {
+      u_vbuf_multi_draw(vbuf, info, draws, num_draws);
+   } else {
+      struct pipe_context *pipe = cso->pipe;
+
+      if (pipe->multi_draw)
+         pipe->multi_draw(pipe, info, draws, num_draws);
+      else
+         util_draw_multi(pipe, info, draws, num_draws);
+   }
+}
+
 void
 cso_draw_arrays(struct cso_context *cso, uint mode, uint start, uint count)
 {
@@ -105,10 +105,11 @@ static boolean TAG(do_cliptest)( struct pt_post_vs *pvs,
          /* Do the hardwired planes first:
           */
          if (flags & DO_CLIP_XY_GUARD_BAND) {
-            if (!(-0.50 * position[0] + position[3] >= 0)) mask |= (1<<0);
-            if (!( 0.50 * position[0] + position[3] >= 0)) mask |= (1<<1);
-            if (!(-0.50 * position[1] + position[3] >= 0)) mask |= (1<<2);
-            if (!( 0.50 * position[1] + position[3] >= 0)) mask |= (1<<3);
+            float (*plane)[4] = pvs->draw->plane;
+            if (!(plane[0][0] * position[0] + position[3] >= 0)) mask |= (1<<0);
+            if (!(plane[1][0] * position[0] + position[3] >= 0)) mask |= (1<<1);
+            if (!(plane[2][1] * position[1] + position[3] >= 0)) mask |= (1<<2);
+            if (!(plane[3][1] * position[1] + position[3] >= 0)) mask |= (1<<3);
          }
          else if (flags & DO_CLIP_XY) {
             if (!(-position[0] + position[3] >= 0)) mask |= (1<<0);
@@ -158,6 +158,8 @@ boolean draw_init(struct draw_context *draw)
    ASSIGN_4V( draw->plane[5],  0,  0, -1, 1 ); /* mesa's a bit wonky */
    draw->clip_xy = TRUE;
    draw->clip_z = TRUE;
+   draw->driver.guard_band[0] = 2.0f;
+   draw->driver.guard_band[1] = 2.0f;
 
    draw->pt.user.planes = (float (*) [DRAW_TOTAL_CLIP_PLANES][4]) &(draw->plane[0]);
    draw->pt.user.eltMax = ~0;
@@ -295,6 +297,8 @@ draw_update_clip_flags(struct draw_context *draw)
                                 (draw->driver.bypass_clip_points &&
                                 (draw->rasterizer &&
                                  draw->rasterizer->point_tri_clip));
+   draw->guard_band_lines_xy = draw->guard_band_xy &&
+                               !draw->driver.clip_lines_xy;
 }
 
 
@@ -351,6 +355,45 @@ void draw_set_driver_clipping( struct draw_context *draw,
 }
 
 
+/**
+ * Set the size of the x/y guard band, as a multiple of the viewport
+ * extent, for drivers which enabled it with draw_set_driver_clipping().
+ * Primitives which stay within it are not clipped in x/y.
+ */
+void draw_set_guard_band( struct draw_context *draw,
+                          float scale_x,
+                          float scale_y )
+{
+   scale_x = MAX2(scale_x, 1.0f);
+   scale_y = MAX2(scale_y, 1.0f);
+
+   if (draw->driver.guard_band[0] != scale_x ||
+       draw->driver.guard_band[1] != scale_y) {
+      draw_do_flush( draw, DRAW_FLUSH_STATE_CHANGE );
+
+      draw->driver.guard_band[0] = scale_x;
+      draw->driver.guard_band[1] = scale_y;
+   }
+}
+
+
+/**
+ * With a guard band lines aren't clipped to the viewport in x/y either.
+ * Drivers which only scissor triangles to the viewport can ask for lines
+ * to be clipped to it regardless, wide lines must not be cut off there.
+ */
+void draw_set_clip_lines_xy( struct draw_context *draw,
+                             boolean clip_lines_xy )
+{
+   if (draw->driver.clip_lines_xy != clip_lines_xy) {
+      draw_do_flush( draw, DRAW_FLUSH_STATE_CHANGE );
+
+      draw->driver.clip_lines_xy = clip_lines_xy;
+      draw_update_clip_flags(draw);
+   }
+}
+
+
 /** 
  * Plug in the primitive rendering/rasterization stage (which is the last
  * stage in the drawing pipeline).
@@ -1353,6 +1396,28 @@ draw_set_disk_cache_callbacks(struct draw_context *draw,
    draw->disk_cache_cookie = data_cookie;
 }
 
+/**
+ * Let the draw module shade the vertices of large draws on a driver
+ * provided thread pool.  run_tasks must call func(data, i) for each i in
+ * [0, count) on up to num_threads threads, and return once all calls
+ * are done.
+ */
+void
+draw_set_task_callback(struct draw_context *draw,
+                       void *data_cookie,
+                       unsigned num_threads,
+                       void (*run_tasks)(void *cookie,
+                                         draw_task_func func,
+                                         void *data,
+                                         unsigned count))
+{
+   draw_do_flush(draw, DRAW_FLUSH_STATE_CHANGE);
+
+   draw->run_tasks = run_tasks;
+   draw->num_task_threads = run_tasks ? num_threads : 0;
+   draw->task_cookie = data_cookie;
+}
+
 void draw_set_constant_buffer_stride(struct draw_context *draw, unsigned num_bytes)
 {
    draw->constant_buffer_stride = num_bytes;
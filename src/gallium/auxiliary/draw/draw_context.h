@@ -325,6 +325,11 @@ draw_set_mapped_so_targets(struct draw_context *draw,
 void draw_vbo(struct draw_context *draw,
               const struct pipe_draw_info *info);
 
+void draw_multi_draw(struct draw_context *draw,
+                     const struct pipe_draw_info *info,
+                     const struct pipe_draw_start_count *draws,
+                     unsigned num_draws);
+
 
 /*******************************************************************************
  * Driver backend interface 
@@ -339,6 +344,13 @@ void draw_set_driver_clipping( struct draw_context *draw,
                                boolean guard_band_xy,
                                boolean bypass_clip_points);
 
+void draw_set_guard_band( struct draw_context *draw,
+                          float scale_x,
+                          float scale_y );
+
+void draw_set_clip_lines_xy( struct draw_context *draw,
+                             boolean clip_lines_xy );
+
 void draw_set_force_passthrough( struct draw_context *draw, 
                                  boolean enable );
 
@@ -379,4 +391,15 @@ draw_set_disk_cache_callbacks(struct draw_context *draw,
                               void (*insert_shader)(void *cookie,
                                                     struct lp_cached_code *cache,
                                                     unsigned char ir_sha1_cache_key[20]));
+
+typedef void (*draw_task_func)(void *data, unsigned index);
+
+void
+draw_set_task_callback(struct draw_context *draw,
+                       void *data_cookie,
+                       unsigned num_threads,
+                       void (*run_tasks)(void *cookie,
+                                         draw_task_func func,
+                                         void *data,
+                                         unsigned count));
 #endif /* DRAW_CONTEXT_H */
@@ -54,6 +54,7 @@
 #include "gallivm/lp_bld_misc.h"
 #include "tgsi/tgsi_exec.h"
 #include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_parse.h"
 
 #include "util/u_math.h"
 #include "util/u_pointer.h"
@@ -823,29 +824,36 @@ draw_llvm_destroy(struct draw_llvm *llvm)
    FREE(llvm);
 }
 
+/**
+ * Compute the disk cache key of a variant from its shader's IR, which may
+ * be either NIR or TGSI, and its variant key.
+ */
 static void
-draw_get_ir_cache_key(struct nir_shader *nir,
+draw_get_ir_cache_key(const struct pipe_shader_state *state,
                       const void *key, size_t key_size,
                       uint32_t val_32bit,
                       unsigned char ir_sha1_cache_key[20])
 {
-   struct blob blob = { 0 };
-   unsigned ir_size;
-   void *ir_binary;
-
-   blob_init(&blob);
-   nir_serialize(&blob, nir, true);
-   ir_binary = blob.data;
-   ir_size = blob.size;
-
    struct mesa_sha1 ctx;
+
    _mesa_sha1_init(&ctx);
    _mesa_sha1_update(&ctx, key, key_size);
-   _mesa_sha1_update(&ctx, ir_binary, ir_size);
+
+   if (state->type == PIPE_SHADER_IR_NIR) {
+      struct blob blob = { 0 };
+
+      blob_init(&blob);
+      nir_serialize(&blob, state->ir.nir, true);
+      _mesa_sha1_update(&ctx, blob.data, blob.size);
+      blob_finish(&blob);
+   } else {
+      _mesa_sha1_update(&ctx, state->tokens,
+                        tgsi_num_tokens(state->tokens) *
+                        sizeof(struct tgsi_token));
+   }
+
    _mesa_sha1_update(&ctx, &val_32bit, 4);
    _mesa_sha1_final(&ctx, ir_sha1_cache_key);
-
-   blob_finish(&blob);
 }
 
 /**
@@ -877,8 +885,8 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
    snprintf(module_name, sizeof(module_name), "draw_llvm_vs_variant%u",
             variant->shader->variants_cached);
 
-   if (shader->base.state.ir.nir && llvm->draw->disk_cache_cookie) {
-      draw_get_ir_cache_key(shader->base.state.ir.nir,
+   if (llvm->draw->disk_cache_cookie) {
+      draw_get_ir_cache_key(&shader->base.state,
                             key,
                             shader->variant_key_size,
                             num_inputs,
@@ -1547,32 +1555,55 @@ generate_clipmask(struct draw_llvm *llvm,
     * comparisons here).
     */
    /* Cliptest, for hardwired planes */
-   /*
-    * XXX should take guardband into account (currently not in key).
-    * Otherwise might run the draw pipeline stages for nothing.
-    */
    if (key->clip_xy) {
+      LLVMValueRef clip_x = pos_x, clip_y = pos_y;
+
+      if (key->guard_band_xy) {
+         /*
+          * Test against the guard band rather than the viewport, the x/y
+          * planes hold the inverse guard band size.
+          */
+         LLVMValueRef planes_ptr = draw_jit_context_planes(gallivm, context_ptr);
+         LLVMTypeRef vs_type_llvm = lp_build_vec_type(gallivm, vs_type);
+         LLVMValueRef indices[3];
+
+         indices[0] = lp_build_const_int32(gallivm, 0);
+         indices[1] = lp_build_const_int32(gallivm, 1);
+         indices[2] = lp_build_const_int32(gallivm, 0);
+         plane_ptr = LLVMBuildGEP(builder, planes_ptr, indices, 3, "");
+         plane1 = LLVMBuildLoad(builder, plane_ptr, "guard_band_x");
+         planes = lp_build_broadcast(gallivm, vs_type_llvm, plane1);
+         clip_x = LLVMBuildFMul(builder, planes, pos_x, "");
+
+         indices[1] = lp_build_const_int32(gallivm, 3);
+         indices[2] = lp_build_const_int32(gallivm, 1);
+         plane_ptr = LLVMBuildGEP(builder, planes_ptr, indices, 3, "");
+         plane1 = LLVMBuildLoad(builder, plane_ptr, "guard_band_y");
+         planes = lp_build_broadcast(gallivm, vs_type_llvm, plane1);
+         clip_y = LLVMBuildFMul(builder, planes, pos_y, "");
+      }
+
       /* plane 1 */
-      test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER, pos_x , pos_w);
+      test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER, clip_x , pos_w);
       temp = shift;
       test = LLVMBuildAnd(builder, test, temp, "");
       mask = test;
 
       /* plane 2 */
-      test = LLVMBuildFAdd(builder, pos_x, pos_w, "");
+      test = LLVMBuildFAdd(builder, clip_x, pos_w, "");
       test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER, zero, test);
       temp = LLVMBuildShl(builder, temp, shift, "");
       test = LLVMBuildAnd(builder, test, temp, "");
       mask = LLVMBuildOr(builder, mask, test, "");
 
       /* plane 3 */
-      test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER, pos_y, pos_w);
+      test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER, clip_y, pos_w);
       temp = LLVMBuildShl(builder, temp, shift, "");
       test = LLVMBuildAnd(builder, test, temp, "");
       mask = LLVMBuildOr(builder, mask, test, "");
 
       /* plane 4 */
-      test = LLVMBuildFAdd(builder, pos_y, pos_w, "");
+      test = LLVMBuildFAdd(builder, clip_y, pos_w, "");
       test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER, zero, test);
       temp = LLVMBuildShl(builder, temp, shift, "");
       test = LLVMBuildAnd(builder, test, temp, "");
@@ -2362,6 +2393,7 @@ draw_llvm_make_variant_key(struct draw_llvm *llvm, char *store)
 
    /* will have to rig this up properly later */
    key->clip_xy = llvm->draw->clip_xy;
+   key->guard_band_xy = llvm->draw->clip_xy && llvm->draw->guard_band_xy;
    key->clip_z = llvm->draw->clip_z;
    key->clip_user = llvm->draw->clip_user;
    key->bypass_viewport = llvm->draw->bypass_viewport;
@@ -2444,6 +2476,7 @@ draw_llvm_dump_variant_key(struct draw_llvm_variant_key *key)
    struct draw_image_static_state *image = draw_llvm_variant_key_images(key);
    debug_printf("clamp_vertex_color = %u\n", key->clamp_vertex_color);
    debug_printf("clip_xy = %u\n", key->clip_xy);
+   debug_printf("guard_band_xy = %u\n", key->guard_band_xy);
    debug_printf("clip_z = %u\n", key->clip_z);
    debug_printf("clip_user = %u\n", key->clip_user);
    debug_printf("bypass_viewport = %u\n", key->bypass_viewport);
@@ -2911,8 +2944,8 @@ draw_gs_llvm_create_variant(struct draw_llvm *llvm,
 
    memcpy(&variant->key, key, shader->variant_key_size);
 
-   if (shader->base.state.ir.nir && llvm->draw->disk_cache_cookie) {
-      draw_get_ir_cache_key(shader->base.state.ir.nir,
+   if (llvm->draw->disk_cache_cookie) {
+      draw_get_ir_cache_key(&shader->base.state,
                             key,
                             shader->variant_key_size,
                             num_outputs,
@@ -3539,8 +3572,8 @@ draw_tcs_llvm_create_variant(struct draw_llvm *llvm,
 
    memcpy(&variant->key, key, shader->variant_key_size);
 
-   if (shader->base.state.ir.nir && llvm->draw->disk_cache_cookie) {
-      draw_get_ir_cache_key(shader->base.state.ir.nir,
+   if (llvm->draw->disk_cache_cookie) {
+      draw_get_ir_cache_key(&shader->base.state,
                             key,
                             shader->variant_key_size,
                             num_outputs,
@@ -4037,8 +4070,8 @@ draw_tes_llvm_create_variant(struct draw_llvm *llvm,
             variant->shader->variants_cached);
 
    memcpy(&variant->key, key, shader->variant_key_size);
-   if (shader->base.state.ir.nir && llvm->draw->disk_cache_cookie) {
-      draw_get_ir_cache_key(shader->base.state.ir.nir,
+   if (llvm->draw->disk_cache_cookie) {
+      draw_get_ir_cache_key(&shader->base.state,
                             key,
                             shader->variant_key_size,
                             num_outputs,
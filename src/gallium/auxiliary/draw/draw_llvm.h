@@ -472,6 +472,7 @@ struct draw_llvm_variant_key
    unsigned nr_images:8;
    unsigned clamp_vertex_color:1;
    unsigned clip_xy:1;
+   unsigned guard_band_xy:1;
    unsigned clip_z:1;
    unsigned clip_user:1;
    unsigned clip_halfz:1;
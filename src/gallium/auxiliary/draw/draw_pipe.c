@@ -34,6 +34,7 @@
 #include "draw/draw_pipe.h"
 #include "util/u_debug.h"
 #include "util/u_math.h"
+#include "util/u_sse.h"
 
 
 
@@ -171,6 +172,167 @@ static void do_triangle( struct draw_context *draw,
 }
 
 
+/**
+ * Test and cull a batch of up to four triangles at once.
+ *
+ * The vertex shader already computed each vertex's clipmask against the
+ * frustum, guard band and user planes, so combining the masks is enough
+ * to find the triangles which are trivially accepted or rejected.  The
+ * accepted ones are face culled here and the survivors go straight to the
+ * stage after clip and cull.  Only triangles which straddle a plane run
+ * through the whole pipeline, i.e. the polygon clipper.
+ */
+static void
+pipe_run_tri_batch(struct draw_context *draw,
+                   struct prim_header *prims,
+                   unsigned n)
+{
+   const unsigned pos = draw_current_shader_position_output(draw);
+   const unsigned cull_face = draw->pipeline.batch_cull_face;
+   struct draw_stage *next = draw->pipeline.batch_next;
+   struct draw_stage *first = draw->pipeline.first;
+   unsigned accept_mask, reject_mask, cull_mask;
+   float det[4];
+   unsigned i;
+
+#if defined(PIPE_ARCH_SSE)
+   {
+      union m128i clip[3], x[3], y[3];
+      __m128 ex, ey, fx, fy, d, zero = _mm_setzero_ps();
+      __m128i or_mask, and_mask, izero = _mm_setzero_si128();
+      unsigned front, back;
+
+      for (i = 0; i < 4; i++) {
+         unsigned k;
+         for (k = 0; k < 3; k++) {
+            const struct vertex_header *v = prims[MIN2(i, n - 1)].v[k];
+            clip[k].ui[i] = v->clipmask;
+            x[k].ui[i] = fui(v->data[pos][0]);
+            y[k].ui[i] = fui(v->data[pos][1]);
+         }
+      }
+
+      or_mask = _mm_or_si128(_mm_or_si128(clip[0].m, clip[1].m), clip[2].m);
+      and_mask = _mm_and_si128(_mm_and_si128(clip[0].m, clip[1].m), clip[2].m);
+      accept_mask = _mm_movemask_ps(_mm_castsi128_ps(
+                                       _mm_cmpeq_epi32(or_mask, izero)));
+      reject_mask = ~_mm_movemask_ps(_mm_castsi128_ps(
+                                        _mm_cmpeq_epi32(and_mask, izero)));
+
+      /* edge vectors: e = v0 - v2, f = v1 - v2, det = cross(e,f).z */
+      ex = _mm_sub_ps(_mm_castsi128_ps(x[0].m), _mm_castsi128_ps(x[2].m));
+      ey = _mm_sub_ps(_mm_castsi128_ps(y[0].m), _mm_castsi128_ps(y[2].m));
+      fx = _mm_sub_ps(_mm_castsi128_ps(x[1].m), _mm_castsi128_ps(x[2].m));
+      fy = _mm_sub_ps(_mm_castsi128_ps(y[1].m), _mm_castsi128_ps(y[2].m));
+      d = _mm_sub_ps(_mm_mul_ps(ex, fy), _mm_mul_ps(ey, fx));
+      _mm_storeu_ps(det, d);
+
+      /* same facing rules as the cull stage, zero area is back facing */
+      if (draw->pipeline.batch_front_ccw)
+         front = _mm_movemask_ps(_mm_cmplt_ps(d, zero));
+      else
+         front = _mm_movemask_ps(_mm_andnot_ps(_mm_cmplt_ps(d, zero),
+                                               _mm_cmpneq_ps(d, zero)));
+      back = ~front;
+
+      cull_mask = ((cull_face & PIPE_FACE_FRONT) ? front : 0) |
+                  ((cull_face & PIPE_FACE_BACK) ? back : 0);
+   }
+#else
+   accept_mask = reject_mask = cull_mask = 0;
+   for (i = 0; i < n; i++) {
+      const struct vertex_header *v0 = prims[i].v[0];
+      const struct vertex_header *v1 = prims[i].v[1];
+      const struct vertex_header *v2 = prims[i].v[2];
+      const float ex = v0->data[pos][0] - v2->data[pos][0];
+      const float ey = v0->data[pos][1] - v2->data[pos][1];
+      const float fx = v1->data[pos][0] - v2->data[pos][0];
+      const float fy = v1->data[pos][1] - v2->data[pos][1];
+      unsigned face;
+
+      if ((v0->clipmask | v1->clipmask | v2->clipmask) == 0)
+         accept_mask |= 1 << i;
+      if (v0->clipmask & v1->clipmask & v2->clipmask)
+         reject_mask |= 1 << i;
+
+      det[i] = ex * fy - ey * fx;
+      if (det[i] != 0)
+         face = ((det[i] < 0) == draw->pipeline.batch_front_ccw) ?
+                PIPE_FACE_FRONT : PIPE_FACE_BACK;
+      else
+         face = PIPE_FACE_BACK;
+      if (face & cull_face)
+         cull_mask |= 1 << i;
+   }
+#endif
+
+   if (!draw->pipeline.batch_clip) {
+      accept_mask = ~0;
+      reject_mask = 0;
+   }
+
+   for (i = 0; i < n; i++) {
+      if (accept_mask & (1 << i)) {
+         if (!(cull_mask & (1 << i))) {
+            prims[i].det = det[i];
+            next->tri(next, &prims[i]);
+         }
+      }
+      else if (!(reject_mask & (1 << i))) {
+         first->tri(first, &prims[i]);
+      }
+   }
+}
+
+
+/**
+ * Run a triangle list, in batches when the pipeline allows it.
+ * With elts NULL the vertices are used linearly.
+ */
+static void
+pipe_run_tri_list(struct draw_context *draw,
+                  char *verts,
+                  unsigned stride,
+                  const ushort *elts,
+                  unsigned count,
+                  unsigned max_index)
+{
+   const ushort flags = DRAW_PIPE_RESET_STIPPLE | DRAW_PIPE_EDGE_FLAG_ALL;
+   struct prim_header prims[4];
+   unsigned i = 0, n = 0, k;
+
+   while (i + 2 < count) {
+      for (k = 0; k < 3; k++) {
+         unsigned idx = elts ? MIN2(elts[i + k], max_index) : i + k;
+         prims[n].v[k] = (struct vertex_header *)(verts + stride * idx);
+      }
+      prims[n].flags = flags;
+      prims[n].pad = 0;
+      i += 3;
+
+      if (!draw->pipeline.batch_next ||
+          draw->pipeline.first == draw->pipeline.validate) {
+         /* also validates the pipeline on the first triangle */
+         if (n) {
+            pipe_run_tri_batch(draw, prims, n);
+            prims[0] = prims[n];
+            n = 0;
+         }
+         draw->pipeline.first->tri(draw->pipeline.first, &prims[n]);
+         continue;
+      }
+
+      if (++n == ARRAY_SIZE(prims)) {
+         pipe_run_tri_batch(draw, prims, n);
+         n = 0;
+      }
+   }
+
+   if (n)
+      pipe_run_tri_batch(draw, prims, n);
+}
+
+
 /*
  * Set up macros for draw_pt_decompose.h template code.
  * This code uses vertex indexes / elements.
@@ -262,14 +424,22 @@ void draw_pipeline_run( struct draw_context *draw,
       }
 #endif
 
-      pipe_run_elts(draw,
-                    prim_info->prim,
-                    prim_info->flags,
-                    vert_info->verts,
-                    vert_info->stride,
-                    prim_info->elts + start,
-                    count,
-                    vert_info->count - 1);
+      if (prim_info->prim == PIPE_PRIM_TRIANGLES)
+         pipe_run_tri_list(draw,
+                           (char *)vert_info->verts,
+                           vert_info->stride,
+                           prim_info->elts + start,
+                           count,
+                           vert_info->count - 1);
+      else
+         pipe_run_elts(draw,
+                       prim_info->prim,
+                       prim_info->flags,
+                       vert_info->verts,
+                       vert_info->stride,
+                       prim_info->elts + start,
+                       count,
+                       vert_info->count - 1);
    }
 
    draw->pipeline.verts = NULL;
@@ -334,12 +504,15 @@ void draw_pipeline_run_linear( struct draw_context *draw,
 
       assert(count <= vert_info->count);
 
-      pipe_run_linear(draw,
-                      prim_info->prim,
-                      prim_info->flags,
-                      (struct vertex_header*)verts,
-                      vert_info->stride,
-                      count);
+      if (prim_info->prim == PIPE_PRIM_TRIANGLES)
+         pipe_run_tri_list(draw, verts, vert_info->stride, NULL, count, 0);
+      else
+         pipe_run_linear(draw,
+                         prim_info->prim,
+                         prim_info->flags,
+                         (struct vertex_header*)verts,
+                         vert_info->stride,
+                         count);
    }
 
    draw->pipeline.verts = NULL;
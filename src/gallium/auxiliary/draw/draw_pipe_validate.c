@@ -275,6 +275,22 @@ static struct draw_stage *validate_pipeline( struct draw_stage *stage )
 
    draw->pipeline.first = next;
 
+   /* Triangles which need neither clipping nor culling can skip those
+    * stages, see pipe_run_tri_list().
+    */
+   draw->pipeline.batch_clip = FALSE;
+   draw->pipeline.batch_cull_face = PIPE_FACE_NONE;
+   draw->pipeline.batch_front_ccw = rast->front_ccw;
+   if (next == draw->pipeline.clip) {
+      draw->pipeline.batch_clip = TRUE;
+      next = next->next;
+   }
+   if (next == draw->pipeline.cull) {
+      draw->pipeline.batch_cull_face = rast->cull_face;
+      next = next->next;
+   }
+   draw->pipeline.batch_next = next != draw->pipeline.first ? next : NULL;
+
    if (0) {
       debug_printf("draw pipeline:\n");
       for (next = draw->pipeline.first; next ; next = next->next ) 
@@ -140,6 +140,14 @@ struct draw_context
       boolean line_stipple;       /**< do line stipple? */
       boolean point_sprite;       /**< convert points to quads for sprites? */
 
+      /* Stage following the clip and cull stages, which triangles that
+       * need neither can be sent to directly (NULL if not possible):
+       */
+      struct draw_stage *batch_next;
+      boolean batch_clip;         /**< clip stage is in the pipeline */
+      boolean batch_front_ccw;
+      unsigned batch_cull_face;   /**< PIPE_FACE_x culled by the cull stage */
+
       /* Temporary storage while the pipeline is being run:
        */
       char *verts;
@@ -158,6 +166,7 @@ struct draw_context
       unsigned prim;
       unsigned opt;     /**< bitmask of PT_x flags */
       unsigned eltSize; /* saved eltSize for flushing */
+      unsigned count;   /**< vertex count of the draw being run */
       ubyte vertices_per_patch;
       boolean rebind_parameters;
 
@@ -235,6 +244,8 @@ struct draw_context
       boolean bypass_clip_z;
       boolean guard_band_xy;
       boolean bypass_clip_points;
+      boolean clip_lines_xy;  /**< clip lines to the viewport despite guard band */
+      float guard_band[2];  /**< x/y guard band, in viewport extents */
    } driver;
 
    boolean quads_always_flatshade_last;
@@ -250,6 +261,7 @@ struct draw_context
    boolean clip_user;
    boolean guard_band_xy;
    boolean guard_band_points_xy;
+   boolean guard_band_lines_xy;
 
    boolean force_passthrough; /**< never clip or shade */
 
@@ -400,6 +412,16 @@ struct draw_context
                                     struct lp_cached_code *cache,
                                     unsigned char ir_sha1_cache_key[20]);
 
+   /* Driver thread pool for shading vertices in parallel, see
+    * draw_set_task_callback().
+    */
+   void *task_cookie;
+   unsigned num_task_threads;
+   void (*run_tasks)(void *cookie,
+                     void (*func)(void *data, unsigned index),
+                     void *data,
+                     unsigned count);
+
    void *driver_private;
 };
 
@@ -155,8 +155,12 @@ draw_pt_arrays(struct draw_context *draw,
       draw->pt.rebind_parameters = FALSE;
    }
 
+   draw->pt.count = count;
    frontend->run( frontend, start, count );
 
+   if (middle->flush)
+      middle->flush(middle);
+
    return TRUE;
 }
 
@@ -458,6 +462,39 @@ resolve_draw_info(const struct pipe_draw_info *raw_info,
    }
 }
 
+/**
+ * Draw all instances of one draw.  The draw->pt.user state must be set.
+ */
+static void
+draw_instances(struct draw_context *draw, const struct pipe_draw_info *info)
+{
+   unsigned instance;
+
+   draw->start_index = info->start;
+
+   for (instance = 0; instance < info->instance_count; instance++) {
+      unsigned instance_idx = instance + info->start_instance;
+      draw->start_instance = info->start_instance;
+      draw->instance_id = instance;
+      /* check for overflow */
+      if (instance_idx < instance ||
+          instance_idx < draw->start_instance) {
+         /* if we overflown just set the instance id to the max */
+         draw->instance_id = 0xffffffff;
+      }
+
+      draw_new_instance(draw);
+
+      if (info->primitive_restart) {
+         draw_pt_arrays_restart(draw, info);
+      }
+      else {
+         draw_pt_arrays(draw, info->mode, info->start, info->count);
+      }
+   }
+}
+
+
 /**
  * Draw vertex arrays.
  * This is the main entrypoint into the drawing module.  If drawing an indexed
@@ -468,7 +505,6 @@ void
 draw_vbo(struct draw_context *draw,
          const struct pipe_draw_info *info)
 {
-   unsigned instance;
    unsigned index_limit;
    unsigned count;
    unsigned fpstate = util_fpstate_get();
@@ -552,35 +588,100 @@ draw_vbo(struct draw_context *draw,
    }
 
    draw->pt.max_index = index_limit - 1;
-   draw->start_index = info->start;
 
    /*
     * TODO: We could use draw->pt.max_index to further narrow
     * the min_index/max_index hints given by gallium frontends.
     */
 
-   for (instance = 0; instance < info->instance_count; instance++) {
-      unsigned instance_idx = instance + info->start_instance;
-      draw->start_instance = info->start_instance;
-      draw->instance_id = instance;
-      /* check for overflow */
-      if (instance_idx < instance ||
-          instance_idx < draw->start_instance) {
-         /* if we overflown just set the instance id to the max */
-         draw->instance_id = 0xffffffff;
-      }
+   draw_instances(draw, info);
 
-      draw_new_instance(draw);
+   /* If requested emit the pipeline statistics for this run */
+   if (draw->collect_statistics) {
+      draw->render->pipeline_statistics(draw->render, &draw->statistics);
+   }
+   util_fpstate_set(fpstate);
+}
 
-      if (info->primitive_restart) {
-         draw_pt_arrays_restart(draw, info);
+
+/**
+ * Same as one draw_vbo call per element of draws, with the start, count and
+ * index_bias of the element and increasing drawids.  See
+ * pipe_context::multi_draw.
+ */
+void
+draw_multi_draw(struct draw_context *draw,
+                const struct pipe_draw_info *info,
+                const struct pipe_draw_start_count *draws,
+                unsigned num_draws)
+{
+   unsigned index_limit;
+   unsigned fpstate;
+   struct pipe_draw_info tmp;
+   unsigned i;
+
+   assert(!info->indirect && !info->count_from_stream_output);
+
+   if (info->instance_count == 0)
+      return;
+
+   fpstate = util_fpstate_get();
+   util_fpstate_set_denorms_to_zero(fpstate);
+
+   if (info->index_size)
+      assert(draw->pt.user.elts);
+
+   draw->pt.user.eltSize = info->index_size ? draw->pt.user.eltSizeIB : 0;
+   draw->pt.vertices_per_patch = info->vertices_per_patch;
+
+   /* This doesn't depend on the vertex range, so it's the same for all
+    * draws.
+    */
+   index_limit = util_draw_max_index(draw->pt.vertex_buffer,
+                                     draw->pt.vertex_element,
+                                     draw->pt.nr_vertex_elements,
+                                     info);
+#ifdef LLVM_AVAILABLE
+   if (!draw->llvm)
+#endif
+   {
+      if (index_limit == 0) {
+         /* one of the buffers is too small to do any valid drawing */
+         debug_warning("draw: VBO too small to draw anything\n");
+         util_fpstate_set(fpstate);
+         return;
       }
-      else {
-         draw_pt_arrays(draw, info->mode, info->start, count);
+   }
+
+   if (draw->collect_statistics) {
+      memset(&draw->statistics, 0, sizeof(draw->statistics));
+   }
+
+   draw->pt.max_index = index_limit - 1;
+
+   tmp = *info;
+   for (i = 0; i < num_draws; i++) {
+      if (!draws[i].count)
+         continue;
+
+      tmp.start = draws[i].start;
+      tmp.count = draws[i].count;
+      tmp.index_bias = draws[i].index_bias;
+      tmp.drawid = info->drawid + (info->increment_draw_id ? i : 0);
+      if (!info->index_size) {
+         tmp.min_index = tmp.start;
+         tmp.max_index = tmp.start + tmp.count - 1;
       }
+
+      draw->pt.user.eltBias = tmp.index_bias;
+      draw->pt.user.min_index = tmp.min_index;
+      draw->pt.user.max_index = tmp.max_index;
+      draw->pt.user.drawid = tmp.drawid;
+
+      draw_instances(draw, &tmp);
    }
 
-   /* If requested emit the pipeline statistics for this run */
+   /* The statistics of all draws are emitted together. */
    if (draw->collect_statistics) {
       draw->render->pipeline_statistics(draw->render, &draw->statistics);
    }
@@ -84,6 +84,9 @@ fetch_pipeline_prepare(struct draw_pt_middle_end *middle,
    unsigned nr = MAX2(vs->info.num_inputs, nr_vs_outputs);
    unsigned point_clip = draw->rasterizer->fill_front == PIPE_POLYGON_MODE_POINT ||
                          gs_out_prim == PIPE_PRIM_POINTS;
+   unsigned line_clip = draw->rasterizer->fill_front == PIPE_POLYGON_MODE_LINE ||
+                        draw->rasterizer->fill_back == PIPE_POLYGON_MODE_LINE ||
+                        u_reduced_prim(gs_out_prim) == PIPE_PRIM_LINES;
 
    if (gs) {
       nr = MAX2(nr, gs->info.num_outputs + 1);
@@ -116,7 +119,8 @@ fetch_pipeline_prepare(struct draw_pt_middle_end *middle,
                             draw->clip_z,
                             draw->clip_user,
                             point_clip ? draw->guard_band_points_xy :
-                                         draw->guard_band_xy,
+                            line_clip ? draw->guard_band_lines_xy :
+                                        draw->guard_band_xy,
                             draw->bypass_viewport,
                             draw->rasterizer->clip_halfz,
                             (draw->vs.edgeflag_output ? TRUE : FALSE) );
@@ -41,6 +41,30 @@
 #include "gallivm/lp_bld_debug.h"
 
 
+/* Max number of vsplit segments shaded in one go on the task threads,
+ * per thread.
+ */
+#define LLVM_SEGMENTS_PER_THREAD 4
+
+/* Draws with fewer vertices than this are shaded on the calling thread,
+ * as waking up the task threads costs more than it saves for them.
+ */
+#define LLVM_MIN_PARALLEL_VERTICES 4096
+
+
+/**
+ * A vsplit segment queued for shading on a task thread.  The element
+ * lists are copies, as vsplit reuses its buffers for the next segment.
+ */
+struct llvm_segment {
+   struct draw_fetch_info fetch_info;
+   struct draw_prim_info prim_info;
+   unsigned prim_length;
+   struct draw_vertex_info vert_info;
+   boolean clipped;
+};
+
+
 struct llvm_middle_end {
    struct draw_pt_middle_end base;
    struct draw_context *draw;
@@ -58,6 +82,12 @@ struct llvm_middle_end {
 
    struct draw_llvm *llvm;
    struct draw_llvm_variant *current_variant;
+
+   /* Segments waiting to be shaded in parallel, see llvm_middle_end_flush */
+   boolean parallel;
+   struct llvm_segment *segments;
+   unsigned max_segments;
+   unsigned num_segments;
 };
 
 
@@ -301,6 +331,9 @@ llvm_middle_end_prepare( struct draw_pt_middle_end *middle,
       u_assembled_prim(in_prim);
    unsigned point_clip = draw->rasterizer->fill_front == PIPE_POLYGON_MODE_POINT ||
                          out_prim == PIPE_PRIM_POINTS;
+   unsigned line_clip = draw->rasterizer->fill_front == PIPE_POLYGON_MODE_LINE ||
+                        draw->rasterizer->fill_back == PIPE_POLYGON_MODE_LINE ||
+                        u_reduced_prim(out_prim) == PIPE_PRIM_LINES;
    unsigned nr;
 
    fpme->input_prim = in_prim;
@@ -311,7 +344,8 @@ llvm_middle_end_prepare( struct draw_pt_middle_end *middle,
                             draw->clip_z,
                             draw->clip_user,
                             point_clip ? draw->guard_band_points_xy :
-                                         draw->guard_band_xy,
+                            line_clip ? draw->guard_band_lines_xy :
+                                        draw->guard_band_xy,
                             draw->bypass_viewport,
                             draw->rasterizer->clip_halfz,
                             (draw->vs.edgeflag_output ? TRUE : FALSE) );
@@ -419,6 +453,24 @@ llvm_middle_end_prepare( struct draw_pt_middle_end *middle,
    if (tes) {
       llvm_middle_end_prepare_tes(fpme);
    }
+
+   /*
+    * Only the vertex shader is run on the task threads, so tessellation
+    * and geometry shaders, which need whole primitives, keep everything
+    * on this thread.
+    */
+   assert(fpme->num_segments == 0);
+   fpme->parallel = FALSE;
+   if (draw->num_task_threads > 1 && !gs && !tcs && !tes) {
+      unsigned max_segments = draw->num_task_threads * LLVM_SEGMENTS_PER_THREAD;
+
+      if (fpme->max_segments != max_segments) {
+         FREE(fpme->segments);
+         fpme->segments = CALLOC(max_segments, sizeof(*fpme->segments));
+         fpme->max_segments = fpme->segments ? max_segments : 0;
+      }
+      fpme->parallel = fpme->segments != NULL;
+   }
 }
 
 static unsigned
@@ -560,47 +612,31 @@ emit(struct pt_emit *emit,
 }
 
 
-static void
-llvm_pipeline_generic(struct draw_pt_middle_end *middle,
-                      const struct draw_fetch_info *fetch_info,
-                      const struct draw_prim_info *in_prim_info)
+static boolean
+llvm_pipeline_alloc_verts(struct llvm_middle_end *fpme,
+                          const struct draw_fetch_info *fetch_info,
+                          struct draw_vertex_info *vert_info)
 {
-   struct llvm_middle_end *fpme = llvm_middle_end(middle);
-   struct draw_context *draw = fpme->draw;
-   struct draw_geometry_shader *gshader = draw->gs.geometry_shader;
-   struct draw_tess_ctrl_shader *tcs_shader = draw->tcs.tess_ctrl_shader;
-   struct draw_tess_eval_shader *tes_shader = draw->tes.tess_eval_shader;
-   struct draw_prim_info tcs_prim_info;
-   struct draw_prim_info tes_prim_info;
-   struct draw_prim_info gs_prim_info[TGSI_MAX_VERTEX_STREAMS];
-   struct draw_vertex_info llvm_vert_info;
-   struct draw_vertex_info tcs_vert_info;
-   struct draw_vertex_info tes_vert_info;
-   struct draw_vertex_info gs_vert_info[TGSI_MAX_VERTEX_STREAMS];
-   struct draw_vertex_info *vert_info;
-   struct draw_prim_info ia_prim_info;
-   struct draw_vertex_info ia_vert_info;
-   const struct draw_prim_info *prim_info = in_prim_info;
-   boolean free_prim_info = FALSE;
-   unsigned opt = fpme->opt;
-   boolean clipped = 0;
-   unsigned start_or_maxelt, vid_base;
-   const unsigned *elts;
-   ushort *tes_elts_out = NULL;
-
-   memset(&gs_vert_info, 0, sizeof(struct draw_vertex_info) * TGSI_MAX_VERTEX_STREAMS);
    assert(fetch_info->count > 0);
-   llvm_vert_info.count = fetch_info->count;
-   llvm_vert_info.vertex_size = fpme->vertex_size;
-   llvm_vert_info.stride = fpme->vertex_size;
-   llvm_vert_info.verts = (struct vertex_header *)
+   vert_info->count = fetch_info->count;
+   vert_info->vertex_size = fpme->vertex_size;
+   vert_info->stride = fpme->vertex_size;
+   vert_info->verts = (struct vertex_header *)
       MALLOC(fpme->vertex_size *
              align(fetch_info->count, lp_native_vector_width / 32));
-   if (!llvm_vert_info.verts) {
+   if (!vert_info->verts) {
       assert(0);
-      return;
+      return FALSE;
    }
+   return TRUE;
+}
 
+
+static void
+llvm_pipeline_stats(struct draw_context *draw,
+                    const struct draw_fetch_info *fetch_info,
+                    const struct draw_prim_info *prim_info)
+{
    if (draw->collect_statistics) {
       draw->statistics.ia_vertices += prim_info->count;
       if (prim_info->prim == PIPE_PRIM_PATCHES)
@@ -610,6 +646,21 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
             u_decomposed_prims_for_vertices(prim_info->prim, prim_info->count);
       draw->statistics.vs_invocations += fetch_info->count;
    }
+}
+
+
+/**
+ * Fetch and run the vertex shader.  Only reads the draw and jit context,
+ * so this can be called from several threads at once.
+ */
+static boolean
+llvm_pipeline_shade(struct llvm_middle_end *fpme,
+                    const struct draw_fetch_info *fetch_info,
+                    struct vertex_header *verts)
+{
+   struct draw_context *draw = fpme->draw;
+   unsigned start_or_maxelt, vid_base;
+   const unsigned *elts;
 
    if (fetch_info->linear) {
       start_or_maxelt = fetch_info->start;
@@ -621,22 +672,51 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
       vid_base = draw->pt.user.eltBias;
       elts = fetch_info->elts;
    }
-   clipped = fpme->current_variant->jit_func(&fpme->llvm->jit_context,
-                                             llvm_vert_info.verts,
-                                             draw->pt.user.vbuffer,
-                                             fetch_info->count,
-                                             start_or_maxelt,
-                                             fpme->vertex_size,
-                                             draw->pt.vertex_buffer,
-                                             draw->instance_id,
-                                             vid_base,
-                                             draw->start_instance,
-                                             elts, draw->pt.user.drawid);
-
-   /* Finished with fetch and vs:
-    */
-   fetch_info = NULL;
-   vert_info = &llvm_vert_info;
+   return fpme->current_variant->jit_func(&fpme->llvm->jit_context,
+                                          verts,
+                                          draw->pt.user.vbuffer,
+                                          fetch_info->count,
+                                          start_or_maxelt,
+                                          fpme->vertex_size,
+                                          draw->pt.vertex_buffer,
+                                          draw->instance_id,
+                                          vid_base,
+                                          draw->start_instance,
+                                          elts, draw->pt.user.drawid);
+}
+
+
+/**
+ * Everything after the vertex shader: tessellation, geometry shader,
+ * stream output, clipping and emit.  Takes ownership of the vertices.
+ */
+static void
+llvm_pipeline_post_vs(struct llvm_middle_end *fpme,
+                      struct draw_vertex_info *llvm_vert_info,
+                      const struct draw_prim_info *in_prim_info,
+                      boolean clipped)
+{
+   struct draw_context *draw = fpme->draw;
+   struct draw_geometry_shader *gshader = draw->gs.geometry_shader;
+   struct draw_tess_ctrl_shader *tcs_shader = draw->tcs.tess_ctrl_shader;
+   struct draw_tess_eval_shader *tes_shader = draw->tes.tess_eval_shader;
+   struct draw_prim_info tcs_prim_info;
+   struct draw_prim_info tes_prim_info;
+   struct draw_prim_info gs_prim_info[TGSI_MAX_VERTEX_STREAMS];
+   struct draw_vertex_info tcs_vert_info;
+   struct draw_vertex_info tes_vert_info;
+   struct draw_vertex_info gs_vert_info[TGSI_MAX_VERTEX_STREAMS];
+   struct draw_vertex_info *vert_info;
+   struct draw_prim_info ia_prim_info;
+   struct draw_vertex_info ia_vert_info;
+   const struct draw_prim_info *prim_info = in_prim_info;
+   boolean free_prim_info = FALSE;
+   unsigned opt = fpme->opt;
+   ushort *tes_elts_out = NULL;
+
+   memset(&gs_vert_info, 0, sizeof(struct draw_vertex_info) * TGSI_MAX_VERTEX_STREAMS);
+
+   vert_info = llvm_vert_info;
 
    if (opt & PT_SHADE) {
       struct draw_vertex_shader *vshader = draw->vs.vertex_shader;
@@ -776,6 +856,132 @@ out:
 }
 
 
+/**
+ * Shade a segment on a task thread.
+ */
+static void
+llvm_segment_shade(void *data, unsigned index)
+{
+   struct llvm_middle_end *fpme = data;
+   struct llvm_segment *segment = &fpme->segments[index];
+
+   segment->clipped = llvm_pipeline_shade(fpme, &segment->fetch_info,
+                                          segment->vert_info.verts);
+}
+
+
+/**
+ * Shade the queued segments on the task threads, then run the rest of
+ * the pipeline on each of them here, in the order they were queued.
+ * This keeps primitive order and provoking vertices as if the segments
+ * had been run one by one.
+ */
+static void
+llvm_middle_end_flush(struct draw_pt_middle_end *middle)
+{
+   struct llvm_middle_end *fpme = llvm_middle_end(middle);
+   struct draw_context *draw = fpme->draw;
+   unsigned i;
+
+   if (!fpme->num_segments)
+      return;
+
+   if (fpme->num_segments == 1) {
+      llvm_segment_shade(fpme, 0);
+   }
+   else {
+      draw->run_tasks(draw->task_cookie, llvm_segment_shade,
+                      fpme, fpme->num_segments);
+   }
+
+   for (i = 0; i < fpme->num_segments; i++) {
+      struct llvm_segment *segment = &fpme->segments[i];
+
+      llvm_pipeline_post_vs(fpme, &segment->vert_info, &segment->prim_info,
+                            segment->clipped);
+
+      FREE((void *) segment->fetch_info.elts);
+      FREE((void *) segment->prim_info.elts);
+   }
+   fpme->num_segments = 0;
+}
+
+
+/**
+ * Queue a segment for llvm_middle_end_flush().
+ */
+static void
+llvm_pipeline_queue(struct llvm_middle_end *fpme,
+                    const struct draw_fetch_info *fetch_info,
+                    const struct draw_prim_info *prim_info)
+{
+   struct llvm_segment *segment;
+   unsigned *fetch_elts = NULL;
+   ushort *draw_elts = NULL;
+
+   if (fpme->num_segments == fpme->max_segments)
+      llvm_middle_end_flush(&fpme->base);
+
+   segment = &fpme->segments[fpme->num_segments];
+
+   if (fetch_info->elts) {
+      fetch_elts = MALLOC(fetch_info->count * sizeof(unsigned));
+      if (!fetch_elts)
+         return;
+      memcpy(fetch_elts, fetch_info->elts,
+             fetch_info->count * sizeof(unsigned));
+   }
+   if (prim_info->elts) {
+      draw_elts = MALLOC(prim_info->count * sizeof(ushort));
+      if (!draw_elts) {
+         FREE(fetch_elts);
+         return;
+      }
+      memcpy(draw_elts, prim_info->elts, prim_info->count * sizeof(ushort));
+   }
+
+   if (!llvm_pipeline_alloc_verts(fpme, fetch_info, &segment->vert_info)) {
+      FREE(fetch_elts);
+      FREE(draw_elts);
+      return;
+   }
+
+   segment->fetch_info = *fetch_info;
+   segment->fetch_info.elts = fetch_elts;
+   segment->prim_info = *prim_info;
+   segment->prim_info.elts = draw_elts;
+   assert(prim_info->primitive_count == 1);
+   segment->prim_length = prim_info->primitive_lengths[0];
+   segment->prim_info.primitive_lengths = &segment->prim_length;
+
+   fpme->num_segments++;
+}
+
+
+static void
+llvm_pipeline_generic(struct draw_pt_middle_end *middle,
+                      const struct draw_fetch_info *fetch_info,
+                      const struct draw_prim_info *prim_info)
+{
+   struct llvm_middle_end *fpme = llvm_middle_end(middle);
+   struct draw_vertex_info llvm_vert_info;
+   boolean clipped;
+
+   llvm_pipeline_stats(fpme->draw, fetch_info, prim_info);
+
+   if (fpme->parallel && fpme->draw->pt.count >= LLVM_MIN_PARALLEL_VERTICES) {
+      llvm_pipeline_queue(fpme, fetch_info, prim_info);
+      return;
+   }
+
+   if (!llvm_pipeline_alloc_verts(fpme, fetch_info, &llvm_vert_info))
+      return;
+
+   clipped = llvm_pipeline_shade(fpme, fetch_info, llvm_vert_info.verts);
+   llvm_pipeline_post_vs(fpme, &llvm_vert_info, prim_info, clipped);
+}
+
+
 static inline unsigned
 prim_type(unsigned prim, unsigned flags)
 {
@@ -879,7 +1085,7 @@ llvm_middle_end_linear_run_elts(struct draw_pt_middle_end *middle,
 static void
 llvm_middle_end_finish(struct draw_pt_middle_end *middle)
 {
-   /* nothing to do */
+   llvm_middle_end_flush(middle);
 }
 
 
@@ -900,6 +1106,7 @@ llvm_middle_end_destroy(struct draw_pt_middle_end *middle)
    if (fpme->post_vs)
       draw_pt_post_vs_destroy( fpme->post_vs );
 
+   FREE(fpme->segments);
    FREE(middle);
 }
 
@@ -921,6 +1128,7 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
    fpme->base.run             = llvm_middle_end_run;
    fpme->base.run_linear      = llvm_middle_end_linear_run;
    fpme->base.run_linear_elts = llvm_middle_end_linear_run_elts;
+   fpme->base.flush           = llvm_middle_end_flush;
    fpme->base.finish          = llvm_middle_end_finish;
    fpme->base.destroy         = llvm_middle_end_destroy;
 
@@ -128,31 +128,28 @@ void draw_pt_post_vs_prepare( struct pt_post_vs *pvs,
 			      boolean clip_xy,
 			      boolean clip_z,
                               boolean clip_user,
-                              boolean guard_band,
+                              boolean guard_band_xy,
 			      boolean bypass_viewport,
                               boolean clip_halfz,
 			      boolean need_edgeflags )
 {
-   pvs->flags = 0;
+   const float *guard_band = pvs->draw->driver.guard_band;
 
-   /* This combination not currently tested/in use:
-    */
-   if (!clip_halfz)
-      guard_band = FALSE;
+   pvs->flags = 0;
 
-   if (clip_xy && !guard_band) {
+   if (clip_xy && !guard_band_xy) {
       pvs->flags |= DO_CLIP_XY;
       ASSIGN_4V( pvs->draw->plane[0], -1,  0,  0, 1 );
       ASSIGN_4V( pvs->draw->plane[1],  1,  0,  0, 1 );
       ASSIGN_4V( pvs->draw->plane[2],  0, -1,  0, 1 );
       ASSIGN_4V( pvs->draw->plane[3],  0,  1,  0, 1 );
    }
-   else if (clip_xy && guard_band) {
+   else if (clip_xy && guard_band_xy) {
       pvs->flags |= DO_CLIP_XY_GUARD_BAND;
-      ASSIGN_4V( pvs->draw->plane[0], -0.5,  0,  0, 1 );
-      ASSIGN_4V( pvs->draw->plane[1],  0.5,  0,  0, 1 );
-      ASSIGN_4V( pvs->draw->plane[2],  0, -0.5,  0, 1 );
-      ASSIGN_4V( pvs->draw->plane[3],  0,  0.5,  0, 1 );
+      ASSIGN_4V( pvs->draw->plane[0], -1.0f / guard_band[0],  0,  0, 1 );
+      ASSIGN_4V( pvs->draw->plane[1],  1.0f / guard_band[0],  0,  0, 1 );
+      ASSIGN_4V( pvs->draw->plane[2],  0, -1.0f / guard_band[1],  0, 1 );
+      ASSIGN_4V( pvs->draw->plane[3],  0,  1.0f / guard_band[1],  0, 1 );
    }
 
    if (clip_z) {
@@ -31,7 +31,14 @@
 #include "draw/draw_pt.h"
 
 #define SEGMENT_SIZE 1024
-#define MAP_SIZE     256
+
+/* The post-transform cache is set associative and sized to hold a whole
+ * segment, so a vertex is only fetched and shaded again when more than
+ * MAP_WAYS of the segment's vertices hash to the same set.
+ */
+#define MAP_SET_BITS 8
+#define MAP_SETS     (1 << MAP_SET_BITS)
+#define MAP_WAYS     (SEGMENT_SIZE / MAP_SETS)
 
 /* The largest possible index within an index buffer */
 #define MAX_ELT_IDX 0xffffffff
@@ -53,10 +60,11 @@ struct vsplit_frontend {
    ushort identity_draw_elts[SEGMENT_SIZE];
 
    struct {
-      /* map a fetch element to a draw element */
-      unsigned fetches[MAP_SIZE];
-      ushort draws[MAP_SIZE];
-      boolean has_max_fetch;
+      /* map a fetch element to a draw element, the ways of each set are
+       * kept in most recently used order */
+      unsigned fetches[MAP_SETS][MAP_WAYS];
+      ushort draws[MAP_SETS][MAP_WAYS];
+      ubyte num_ways[MAP_SETS];
 
       ushort num_fetch_elts;
       ushort num_draw_elts;
@@ -67,8 +75,7 @@ struct vsplit_frontend {
 static void
 vsplit_clear_cache(struct vsplit_frontend *vsplit)
 {
-   memset(vsplit->cache.fetches, 0xff, sizeof(vsplit->cache.fetches));
-   vsplit->cache.has_max_fetch = FALSE;
+   memset(vsplit->cache.num_ways, 0, sizeof(vsplit->cache.num_ways));
    vsplit->cache.num_fetch_elts = 0;
    vsplit->cache.num_draw_elts = 0;
 }
@@ -81,29 +88,58 @@ vsplit_flush_cache(struct vsplit_frontend *vsplit, unsigned flags)
          vsplit->draw_elts, vsplit->cache.num_draw_elts, flags);
 }
 
+/**
+ * Hash a fetch element to a cache set.  Meshes often have indices which
+ * alias modulo a power of two, so mix the high bits in as well.
+ */
+static inline unsigned
+vsplit_cache_set(unsigned fetch)
+{
+   return (fetch * 2654435761u) >> (32 - MAP_SET_BITS);
+}
+
 /**
  * Add a fetch element and add it to the draw elements.
  */
 static inline void
 vsplit_add_cache(struct vsplit_frontend *vsplit, unsigned fetch)
 {
-   unsigned hash;
-
-   hash = fetch % MAP_SIZE;
-
-   /* If the value isn't in the cache or it's an overflow due to the
-    * element bias */
-   if (vsplit->cache.fetches[hash] != fetch) {
-      /* update cache */
-      vsplit->cache.fetches[hash] = fetch;
-      vsplit->cache.draws[hash] = vsplit->cache.num_fetch_elts;
+   const unsigned set = vsplit_cache_set(fetch);
+   unsigned *fetches = vsplit->cache.fetches[set];
+   ushort *draws = vsplit->cache.draws[set];
+   const unsigned num_ways = vsplit->cache.num_ways[set];
+   unsigned way;
+   ushort draw;
+
+   for (way = 0; way < num_ways; way++) {
+      if (fetches[way] == fetch)
+         break;
+   }
 
-      /* add fetch */
+   if (way < num_ways) {
+      draw = draws[way];
+   }
+   else {
+      /* add fetch, replacing the least recently used way if the set is full */
       assert(vsplit->cache.num_fetch_elts < vsplit->segment_size);
+      draw = vsplit->cache.num_fetch_elts;
       vsplit->fetch_elts[vsplit->cache.num_fetch_elts++] = fetch;
+
+      if (num_ways < MAP_WAYS)
+         vsplit->cache.num_ways[set] = num_ways + 1;
+      else
+         way = MAP_WAYS - 1;
    }
 
-   vsplit->draw_elts[vsplit->cache.num_draw_elts++] = vsplit->cache.draws[hash];
+   /* move to the front of the set */
+   for (; way > 0; way--) {
+      fetches[way] = fetches[way - 1];
+      draws[way] = draws[way - 1];
+   }
+   fetches[0] = fetch;
+   draws[0] = draw;
+
+   vsplit->draw_elts[vsplit->cache.num_draw_elts++] = draw;
 }
 
 /**
@@ -125,12 +161,6 @@ vsplit_add_cache_ubyte(struct vsplit_frontend *vsplit, const ubyte *elts,
    unsigned elt_idx;
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
-   /* unlike the uint case this can only happen with elt_bias */
-   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = TRUE;
-   }
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -142,12 +172,6 @@ vsplit_add_cache_ushort(struct vsplit_frontend *vsplit, const ushort *elts,
    unsigned elt_idx;
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
-   /* unlike the uint case this can only happen with elt_bias */
-   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = TRUE;
-   }
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -167,13 +191,6 @@ vsplit_add_cache_uint(struct vsplit_frontend *vsplit, const uint *elts,
     */
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
-   /* Take care for DRAW_MAX_FETCH_IDX (since cache is initialized to -1). */
-   if (elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      /* force update - any value will do except DRAW_MAX_FETCH_IDX */
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = TRUE;
-   }
    vsplit_add_cache(vsplit, elt_idx);
 }
 
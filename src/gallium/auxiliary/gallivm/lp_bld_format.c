@@ -26,6 +26,8 @@
  **************************************************************************/
 
 
+#include "util/format/u_format.h"
+
 #include "lp_bld_format.h"
 
 
@@ -54,3 +56,33 @@ lp_build_format_cache_type(struct gallivm_state *gallivm)
 
    return s;
 }
+
+
+/**
+ * Whether 4x4 blocks of the given format can be decoded into the block
+ * cache. Cache entries hold rgba8 texels, so formats needing more
+ * precision (bptc float, signed rgtc) are excluded, as are formats
+ * u_format cannot unpack (etc2).
+ * Note srgb formats are cached undecoded, like with s3tc.
+ */
+boolean
+lp_build_format_cache_supported(const struct util_format_description *format_desc)
+{
+   const struct util_format_description *linear_desc;
+
+   if (format_desc->block.width != 4 || format_desc->block.height != 4)
+      return FALSE;
+
+   switch (format_desc->layout) {
+   case UTIL_FORMAT_LAYOUT_S3TC:
+      return TRUE;
+   case UTIL_FORMAT_LAYOUT_RGTC:
+   case UTIL_FORMAT_LAYOUT_BPTC:
+   case UTIL_FORMAT_LAYOUT_ETC:
+      linear_desc = util_format_description(util_format_linear(format_desc->format));
+      return format_desc->unpack_rgba_8unorm != NULL &&
+             util_format_fits_8unorm(linear_desc);
+   default:
+      return FALSE;
+   }
+}
@@ -49,6 +49,9 @@ struct lp_build_context;
  * Block cache
  *
  * Optional block cache to be used when unpacking big pixel blocks.
+ * Each entry holds one decoded 4x4 block of a compressed format (s3tc,
+ * rgtc, bptc or etc1), so the neighbouring fetches hitting the same block
+ * only decode it once.
  * Must be a power of 2
  */
 
@@ -82,6 +85,19 @@ enum {
 LLVMTypeRef
 lp_build_format_cache_type(struct gallivm_state *gallivm);
 
+boolean
+lp_build_format_cache_supported(const struct util_format_description *format_desc);
+
+LLVMValueRef
+lp_build_fetch_cached_texels(struct gallivm_state *gallivm,
+                             const struct util_format_description *format_desc,
+                             unsigned n,
+                             LLVMValueRef base_ptr,
+                             LLVMValueRef offset,
+                             LLVMValueRef i,
+                             LLVMValueRef j,
+                             LLVMValueRef cache);
+
 
 /*
  * AoS
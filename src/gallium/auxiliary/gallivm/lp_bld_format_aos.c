@@ -785,6 +785,39 @@ lp_build_fetch_rgba_aos(struct gallivm_state *gallivm,
        return tmp;
    }
 
+   /*
+    * other block compressed formats (bptc, etc1), when there's a cache
+    * to decode whole blocks into
+    */
+
+   if (cache &&
+       (format_desc->layout == UTIL_FORMAT_LAYOUT_BPTC ||
+        format_desc->layout == UTIL_FORMAT_LAYOUT_ETC) &&
+       format_desc->colorspace == UTIL_FORMAT_COLORSPACE_RGB &&
+       lp_build_format_cache_supported(format_desc)) {
+      struct lp_type tmp_type;
+      LLVMValueRef tmp;
+
+      memset(&tmp_type, 0, sizeof tmp_type);
+      tmp_type.width = 8;
+      tmp_type.length = num_pixels * 4;
+      tmp_type.norm = TRUE;
+
+      tmp = lp_build_fetch_cached_texels(gallivm,
+                                         format_desc,
+                                         num_pixels,
+                                         base_ptr,
+                                         offset,
+                                         i, j,
+                                         cache);
+
+      lp_build_conv(gallivm,
+                    tmp_type, type,
+                    &tmp, 1, &tmp, 1);
+
+      return tmp;
+   }
+
    /*
     * Fallback to util_format_description::fetch_rgba_8unorm().
     */
@@ -38,6 +38,7 @@
 
 #include "util/format/u_format.h"
 #include "util/u_math.h"
+#include "util/u_pointer.h"
 #include "util/u_string.h"
 #include "util/u_cpu_detect.h"
 #include "util/u_debug.h"
@@ -57,6 +58,7 @@
 #include "lp_bld_init.h"
 #include "lp_bld_debug.h"
 #include "lp_bld_intr.h"
+#include "lp_bld_misc.h"
 
 
 /**
@@ -1908,6 +1910,80 @@ s3tc_decode_block_dxt5(struct gallivm_state *gallivm,
 }
 
 
+/*
+ * decode one block of any other cacheable format, by calling the
+ * u_format unpack function on it.
+ */
+static void
+generic_decode_block(struct gallivm_state *gallivm,
+                     const struct util_format_description *format_desc,
+                     LLVMValueRef ptr_addr,
+                     LLVMValueRef *col)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef i8t = LLVMInt8TypeInContext(gallivm->context);
+   LLVMTypeRef pi8t = LLVMPointerType(i8t, 0);
+   LLVMTypeRef i32t = LLVMInt32TypeInContext(gallivm->context);
+   LLVMTypeRef ret_type, arg_types[6];
+   LLVMValueRef function, tmp_ptr, args[6], rows[4];
+   struct lp_type type32 = lp_type_uint_vec(32, 128);
+   unsigned count;
+
+   assert(format_desc->unpack_rgba_8unorm);
+
+   /*
+    * Function to call looks like:
+    *   unpack(uint8_t *dst, unsigned dst_stride,
+    *          const uint8_t *src, unsigned src_stride,
+    *          unsigned width, unsigned height)
+    */
+   ret_type = LLVMVoidTypeInContext(gallivm->context);
+   arg_types[0] = pi8t;
+   arg_types[1] = i32t;
+   arg_types[2] = pi8t;
+   arg_types[3] = i32t;
+   arg_types[4] = i32t;
+   arg_types[5] = i32t;
+
+   if (gallivm->cache)
+      gallivm->cache->dont_cache = true;
+   function = lp_build_const_func_pointer(gallivm,
+                                          func_to_pointer((func_pointer) format_desc->unpack_rgba_8unorm),
+                                          ret_type,
+                                          arg_types, ARRAY_SIZE(arg_types),
+                                          format_desc->short_name);
+
+   tmp_ptr = lp_build_alloca(gallivm,
+                             LLVMArrayType(lp_build_vec_type(gallivm, type32), 4),
+                             "block");
+
+   /* a single block, so the source stride is never used */
+   args[0] = LLVMBuildBitCast(builder, tmp_ptr, pi8t, "");
+   args[1] = lp_build_const_int32(gallivm, 16);
+   args[2] = ptr_addr;
+   args[3] = lp_build_const_int32(gallivm, 0);
+   args[4] = lp_build_const_int32(gallivm, 4);
+   args[5] = lp_build_const_int32(gallivm, 4);
+   LLVMBuildCall(builder, function, args, ARRAY_SIZE(args), "");
+
+   for (count = 0; count < 4; count++) {
+      LLVMValueRef indices[2];
+      indices[0] = lp_build_const_int32(gallivm, 0);
+      indices[1] = lp_build_const_int32(gallivm, count);
+      rows[count] = LLVMBuildLoad(builder,
+                                  LLVMBuildGEP(builder, tmp_ptr, indices,
+                                               ARRAY_SIZE(indices), ""),
+                                  "");
+   }
+
+   /*
+    * The cache wants the same "wrong" order as the s3tc decoders produce,
+    * col0 being rgba0, rgba4, rgba8, rgba12 and so on.
+    */
+   lp_build_transpose_aos(gallivm, type32, rows, col);
+}
+
+
 static void
 generate_update_cache_one_block(struct gallivm_state *gallivm,
                                 LLVMValueRef function,
@@ -1938,8 +2014,10 @@ generate_update_cache_one_block(struct gallivm_state *gallivm,
    gallivm->builder = LLVMCreateBuilderInContext(gallivm->context);
    LLVMPositionBuilderAtEnd(gallivm->builder, block);
 
-   lp_build_gather_s3tc_simple_scalar(gallivm, format_desc, &dxt_block,
-                                      ptr_addr);
+   if (format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC) {
+      lp_build_gather_s3tc_simple_scalar(gallivm, format_desc, &dxt_block,
+                                         ptr_addr);
+   }
 
    switch (format_desc->format) {
    case PIPE_FORMAT_DXT1_RGB:
@@ -1957,8 +2035,8 @@ generate_update_cache_one_block(struct gallivm_state *gallivm,
       s3tc_decode_block_dxt5(gallivm, format_desc->format, dxt_block, col);
       break;
    default:
-      assert(0);
-      s3tc_decode_block_dxt1(gallivm, format_desc->format, dxt_block, col);
+      assert(format_desc->layout != UTIL_FORMAT_LAYOUT_S3TC);
+      generic_decode_block(gallivm, format_desc, ptr_addr, col);
       break;
    }
 
@@ -2032,11 +2110,21 @@ update_cached_block(struct gallivm_state *gallivm,
    LLVMSetInstructionCallConv(inst, LLVMFastCallConv);
 }
 
-/*
- * cached lookup
+/**
+ * Fetch texels of a block compressed format through the block cache.
+ * Blocks missing in the cache get decoded in full, so the other texels
+ * of the same block are cache hits afterwards.
+ * See lp_build_format_cache_supported() for the formats this works with.
+ *
+ * @param n  number of pixels processed
+ * @param base_ptr  base pointer
+ * @param offset <n x i32> vector with the relative offsets of the blocks
+ * @param i  is a <n x i32> vector with the x subpixel coordinate (0..3)
+ * @param j  is a <n x i32> vector with the y subpixel coordinate (0..3)
+ * @return  a <4*n x i8> vector with the pixel RGBA values in AoS
  */
-static LLVMValueRef
-compressed_fetch_cached(struct gallivm_state *gallivm,
+LLVMValueRef
+lp_build_fetch_cached_texels(struct gallivm_state *gallivm,
                         const struct util_format_description *format_desc,
                         unsigned n,
                         LLVMValueRef base_ptr,
@@ -2055,6 +2143,9 @@ compressed_fetch_cached(struct gallivm_state *gallivm,
    LLVMTypeRef i64t = LLVMInt64TypeInContext(gallivm->context);
    struct lp_type type;
    struct lp_build_context bld32;
+
+   assert(lp_build_format_cache_supported(format_desc));
+
    memset(&type, 0, sizeof type);
    type.width = 32;
    type.length = n;
@@ -2210,8 +2301,8 @@ lp_build_fetch_s3tc_rgba_aos(struct gallivm_state *gallivm,
 
 /*   debug_printf("format = %d\n", format_desc->format);*/
    if (cache) {
-      rgba = compressed_fetch_cached(gallivm, format_desc, n,
-                                     base_ptr, offset, i, j, cache);
+      rgba = lp_build_fetch_cached_texels(gallivm, format_desc, n,
+                                          base_ptr, offset, i, j, cache);
       return rgba;
    }
 
@@ -2570,6 +2661,13 @@ lp_build_fetch_rgtc_rgba_aos(struct gallivm_state *gallivm,
 
    assert((n == 1) || (n % 4 == 0));
 
+   /* signed formats don't fit the cache and are decoded per texel */
+   if (cache && lp_build_format_cache_supported(format_desc)) {
+      rgba = lp_build_fetch_cached_texels(gallivm, format_desc, n,
+                                          base_ptr, offset, i, j, cache);
+      return rgba;
+   }
+
    if (n > 4) {
       unsigned count;
       LLVMTypeRef i128_type = LLVMIntTypeInContext(gallivm->context, 128);
@@ -261,9 +261,13 @@ init_gallivm_engine(struct gallivm_state *gallivm)
       char *error = NULL;
       int ret;
 
-      if (gallivm_perf & GALLIVM_PERF_NO_OPT) {
+      if ((gallivm_perf & GALLIVM_PERF_NO_OPT) ||
+          gallivm->opt_level == GALLIVM_OPT_NONE) {
          optlevel = None;
       }
+      else if (gallivm->opt_level == GALLIVM_OPT_FAST) {
+         optlevel = Less;
+      }
       else {
          optlevel = Default;
       }
@@ -564,6 +568,7 @@ gallivm_verify_function(struct gallivm_state *gallivm,
 void
 gallivm_compile_module(struct gallivm_state *gallivm)
 {
+   LLVMPassManagerRef passmgr = gallivm->passmgr;
    LLVMValueRef func;
    int64_t time_begin = 0;
 
@@ -600,8 +605,23 @@ gallivm_compile_module(struct gallivm_state *gallivm)
 #if GALLIVM_HAVE_CORO
    LLVMRunPassManager(gallivm->cgpassmgr, gallivm->module);
 #endif
+   if (gallivm->opt_level != GALLIVM_OPT_FULL) {
+      /* A cheaper pipeline than create_pass_manager()'s, for code which
+       * won't run much.  mem2reg is needed by the backends regardless.
+       */
+      passmgr = LLVMCreateFunctionPassManagerForModule(gallivm->module);
+      LLVMAddPromoteMemoryToRegisterPass(passmgr);
+      if (gallivm->opt_level == GALLIVM_OPT_FAST) {
+         LLVMAddEarlyCSEPass(passmgr);
+         LLVMAddCFGSimplificationPass(passmgr);
+      }
+#if GALLIVM_HAVE_CORO
+      LLVMAddCoroCleanupPass(passmgr);
+#endif
+   }
+
    /* Run optimization passes */
-   LLVMInitializeFunctionPassManager(gallivm->passmgr);
+   LLVMInitializeFunctionPassManager(passmgr);
    func = LLVMGetFirstFunction(gallivm->module);
    while (func) {
       if (0) {
@@ -615,10 +635,13 @@ gallivm_compile_module(struct gallivm_state *gallivm)
       LLVMAddTargetDependentFunctionAttr(func, "no-frame-pointer-elim-non-leaf", "true");
 #endif
 
-      LLVMRunFunctionPassManager(gallivm->passmgr, func);
+      LLVMRunFunctionPassManager(passmgr, func);
       func = LLVMGetNextFunction(func);
    }
-   LLVMFinalizeFunctionPassManager(gallivm->passmgr);
+   LLVMFinalizeFunctionPassManager(passmgr);
+
+   if (passmgr != gallivm->passmgr)
+      LLVMDisposePassManager(passmgr);
 
    if (gallivm_debug & GALLIVM_DEBUG_PERF) {
       int64_t time_end = os_time_get();
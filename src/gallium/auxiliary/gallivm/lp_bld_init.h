@@ -40,6 +40,18 @@ extern "C" {
 #endif
 
 struct lp_cached_code;
+/**
+ * How hard gallivm_compile_module() tries to optimize, trading the quality
+ * of the generated code for compile time.
+ */
+enum gallivm_opt_level
+{
+   GALLIVM_OPT_FULL = 0,  /**< the full pass pipeline, -O2 codegen */
+   GALLIVM_OPT_FAST,      /**< a few cheap cleanups, -O1 codegen */
+   GALLIVM_OPT_NONE,      /**< mem2reg only, -O0 codegen */
+};
+
+
 struct gallivm_state
 {
    char *module_name;
@@ -54,6 +66,8 @@ struct gallivm_state
    struct lp_generated_code *code;
    struct lp_cached_code *cache;
    unsigned compiled;
+   /** Set before gallivm_compile_module(), see enum gallivm_opt_level */
+   enum gallivm_opt_level opt_level;
    LLVMValueRef coro_malloc_hook;
    LLVMValueRef coro_free_hook;
    LLVMValueRef debug_printf_hook;
@@ -118,6 +118,7 @@ lp_sampler_static_texture_state(struct lp_static_texture_state *state,
    state->pot_height        = util_is_power_of_two_or_zero(texture->height0);
    state->pot_depth         = util_is_power_of_two_or_zero(texture->depth0);
    state->level_zero_only   = !view->u.tex.last_level;
+   state->tiled             = !!(texture->flags & LP_RESOURCE_FLAG_TILED);
 
    /*
     * the layer / element / level parameters are all either dynamic
@@ -2060,6 +2061,52 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
 }
 
 
+/**
+ * Compute the partial offset of a pixel block along the x or y axis of a
+ * tiled texture (see LP_TEXEL_TILE_SIZE).
+ *
+ * @param stride  number of bytes between pixel blocks in different tiles,
+ *                i.e. the block size times LP_TEXEL_TILE_SIZE along x, the
+ *                row stride along y
+ * @param tile_stride  number of bytes between pixel blocks within a tile,
+ *                     i.e. the block size along x, the block size times
+ *                     LP_TEXEL_TILE_SIZE along y
+ */
+void
+lp_build_sample_partial_offset_tiled(struct lp_build_context *bld,
+                                     unsigned block_length,
+                                     LLVMValueRef coord,
+                                     LLVMValueRef stride,
+                                     LLVMValueRef tile_stride,
+                                     LLVMValueRef *out_offset,
+                                     LLVMValueRef *out_subcoord)
+{
+   LLVMBuilderRef builder = bld->gallivm->builder;
+   LLVMValueRef tile_mask, tile_coord, offset;
+
+   if (block_length == 1) {
+      *out_subcoord = bld->zero;
+   }
+   else {
+      unsigned logbase2 = util_logbase2(block_length);
+      LLVMValueRef block_shift = lp_build_const_int_vec(bld->gallivm, bld->type, logbase2);
+      LLVMValueRef block_mask = lp_build_const_int_vec(bld->gallivm, bld->type, block_length - 1);
+      *out_subcoord = LLVMBuildAnd(builder, coord, block_mask, "");
+      coord = LLVMBuildLShr(builder, coord, block_shift, "");
+   }
+
+   tile_mask = lp_build_const_int_vec(bld->gallivm, bld->type,
+                                      LP_TEXEL_TILE_SIZE - 1);
+   tile_coord = LLVMBuildAnd(builder, coord, tile_mask, "");
+   coord = LLVMBuildAnd(builder, coord, LLVMBuildNot(builder, tile_mask, ""), "");
+
+   offset = lp_build_mul(bld, coord, stride);
+   offset = lp_build_add(bld, offset, lp_build_mul(bld, tile_coord, tile_stride));
+
+   *out_offset = offset;
+}
+
+
 /**
  * Compute the offset of a pixel block.
  *
@@ -2070,6 +2117,7 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
 void
 lp_build_sample_offset(struct lp_build_context *bld,
                        const struct util_format_description *format_desc,
+                       boolean tiled,
                        LLVMValueRef x,
                        LLVMValueRef y,
                        LLVMValueRef z,
@@ -2085,21 +2133,41 @@ lp_build_sample_offset(struct lp_build_context *bld,
    x_stride = lp_build_const_vec(bld->gallivm, bld->type,
                                  format_desc->block.bits/8);
 
-   lp_build_sample_partial_offset(bld,
-                                  format_desc->block.width,
-                                  x, x_stride,
-                                  &offset, out_i);
-
-   if (y && y_stride) {
+   if (tiled) {
+      LLVMValueRef tile_stride =
+         lp_build_const_vec(bld->gallivm, bld->type,
+                            format_desc->block.bits/8 * LP_TEXEL_TILE_SIZE);
       LLVMValueRef y_offset;
-      lp_build_sample_partial_offset(bld,
-                                     format_desc->block.height,
-                                     y, y_stride,
-                                     &y_offset, out_j);
+
+      assert(y && y_stride);
+
+      lp_build_sample_partial_offset_tiled(bld,
+                                           format_desc->block.width,
+                                           x, tile_stride, x_stride,
+                                           &offset, out_i);
+      lp_build_sample_partial_offset_tiled(bld,
+                                           format_desc->block.height,
+                                           y, y_stride, tile_stride,
+                                           &y_offset, out_j);
       offset = lp_build_add(bld, offset, y_offset);
    }
    else {
-      *out_j = bld->zero;
+      lp_build_sample_partial_offset(bld,
+                                     format_desc->block.width,
+                                     x, x_stride,
+                                     &offset, out_i);
+
+      if (y && y_stride) {
+         LLVMValueRef y_offset;
+         lp_build_sample_partial_offset(bld,
+                                        format_desc->block.height,
+                                        y, y_stride,
+                                        &y_offset, out_j);
+         offset = lp_build_add(bld, offset, y_offset);
+      }
+      else {
+         *out_j = bld->zero;
+      }
    }
 
    if (z && z_stride) {
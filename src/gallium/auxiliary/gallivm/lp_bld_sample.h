@@ -36,6 +36,7 @@
 #define LP_BLD_SAMPLE_H
 
 
+#include "pipe/p_defines.h"
 #include "pipe/p_format.h"
 #include "util/u_debug.h"
 #include "gallivm/lp_bld.h"
@@ -80,6 +81,30 @@ enum lp_sampler_lod_control {
 };
 
 
+/**
+ * Width and height, in pixel blocks, of the tiles of tiled textures.
+ *
+ * The levels of textures created with LP_RESOURCE_FLAG_TILED have the same
+ * size and strides as linear ones, but each image is stored as rows of
+ * LP_TEXEL_TILE_SIZE x LP_TEXEL_TILE_SIZE tiles, each tile being stored
+ * contiguously in row-major order.  The block at (x, y) is at byte offset
+ *
+ *    (y & ~3) * row_stride + (x & ~3) * 4 * block_size +
+ *    ((y & 3) * 4 + (x & 3)) * block_size
+ *
+ * so that the texels of a bilinear footprint mostly share a cache line.
+ * The image width and height in blocks must be multiples of
+ * LP_TEXEL_TILE_SIZE.
+ */
+#define LP_TEXEL_TILE_SIZE 4
+
+/**
+ * pipe_resource::flags bit marking tiled textures, for drivers using the
+ * gallivm samplers.
+ */
+#define LP_RESOURCE_FLAG_TILED (PIPE_RESOURCE_FLAG_DRV_PRIV << 8)
+
+
 enum lp_sampler_op_type {
    LP_SAMPLER_OP_TEXTURE,
    LP_SAMPLER_OP_FETCH,
@@ -174,6 +199,7 @@ struct lp_static_texture_state
    unsigned pot_height:1;
    unsigned pot_depth:1;
    unsigned level_zero_only:1;
+   unsigned tiled:1;         /**< see LP_TEXEL_TILE_SIZE */
 };
 
 
@@ -663,9 +689,20 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
                                LLVMValueRef *out_i);
 
 
+void
+lp_build_sample_partial_offset_tiled(struct lp_build_context *bld,
+                                     unsigned block_length,
+                                     LLVMValueRef coord,
+                                     LLVMValueRef stride,
+                                     LLVMValueRef tile_stride,
+                                     LLVMValueRef *out_offset,
+                                     LLVMValueRef *out_i);
+
+
 void
 lp_build_sample_offset(struct lp_build_context *bld,
                        const struct util_format_description *format_desc,
+                       boolean tiled,
                        LLVMValueRef x,
                        LLVMValueRef y,
                        LLVMValueRef z,
@@ -189,3 +189,35 @@ util_draw_indirect(struct pipe_context *pipe,
    }
    pipe_buffer_unmap(pipe, transfer);
 }
+
+
+void
+util_draw_multi(struct pipe_context *pipe,
+                const struct pipe_draw_info *info,
+                const struct pipe_draw_start_count *draws,
+                unsigned num_draws)
+{
+   struct pipe_draw_info tmp;
+
+   assert(!info->indirect);
+   assert(!info->count_from_stream_output);
+
+   memcpy(&tmp, info, sizeof(tmp));
+
+   for (unsigned i = 0; i < num_draws; i++) {
+      if (!draws[i].count)
+         continue;
+
+      tmp.start = draws[i].start;
+      tmp.count = draws[i].count;
+      tmp.index_bias = draws[i].index_bias;
+      tmp.drawid = info->drawid + (info->increment_draw_id ? i : 0);
+
+      if (!info->index_size) {
+         tmp.min_index = tmp.start;
+         tmp.max_index = tmp.start + tmp.count - 1;
+      }
+
+      pipe->draw_vbo(pipe, &tmp);
+   }
+}
@@ -146,6 +146,16 @@ util_draw_indirect(struct pipe_context *pipe,
                    const struct pipe_draw_info *info);
 
 
+/* This implements pipe_context::multi_draw with one pipe->draw_vbo call
+ * per draw.
+ */
+void
+util_draw_multi(struct pipe_context *pipe,
+                const struct pipe_draw_info *info,
+                const struct pipe_draw_start_count *draws,
+                unsigned num_draws);
+
+
 unsigned
 util_draw_max_index(
       const struct pipe_vertex_buffer *vertex_buffers,
@@ -26,6 +26,7 @@
 
 #include "util/u_threaded_context.h"
 #include "util/u_cpu_detect.h"
+#include "util/u_draw.h"
 #include "util/format/u_format.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
@@ -100,6 +101,93 @@ tc_batch_execute(void *job, UNUSED int thread_index)
    batch->num_total_call_slots = 0;
 }
 
+/* How a call affects merging, see tc_track_call. */
+enum tc_call_kind {
+   /* The call can use the current state (draws, clears, blits, etc.) or
+    * has side effects.  Default for all calls not listed below.
+    */
+   TC_CALL_KIND_USE_STATE = 0,
+   /* The call sets state without using any other state. */
+   TC_CALL_KIND_SET_STATE,
+   /* Like TC_CALL_KIND_SET_STATE, and the call completely replaces
+    * the previous call of the same type and holds no references, so the
+    * previous call can be dropped.
+    */
+   TC_CALL_KIND_REPLACE_STATE,
+};
+
+static const ubyte tc_call_kind[TC_NUM_CALLS] = {
+   [TC_CALL_bind_sampler_states] = TC_CALL_KIND_SET_STATE,
+   [TC_CALL_set_constant_buffer] = TC_CALL_KIND_SET_STATE,
+   [TC_CALL_set_scissor_states] = TC_CALL_KIND_SET_STATE,
+   [TC_CALL_set_viewport_states] = TC_CALL_KIND_SET_STATE,
+   [TC_CALL_set_sampler_views] = TC_CALL_KIND_SET_STATE,
+   [TC_CALL_set_vertex_buffers] = TC_CALL_KIND_SET_STATE,
+
+   [TC_CALL_set_tess_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_set_blend_color] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_set_stencil_ref] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_set_clip_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_set_sample_mask] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_set_min_samples] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_set_polygon_stipple] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_bind_blend_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_bind_rasterizer_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_bind_depth_stencil_alpha_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_bind_compute_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_bind_fs_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_bind_vs_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_bind_gs_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_bind_tcs_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_bind_tes_state] = TC_CALL_KIND_REPLACE_STATE,
+   [TC_CALL_bind_vertex_elements_state] = TC_CALL_KIND_REPLACE_STATE,
+};
+
+static void
+tc_call_nop(UNUSED struct pipe_context *pipe, UNUSED union tc_payload *payload)
+{
+}
+
+/* Nothing recorded before this point can be merged with later calls. */
+static void
+tc_reset_merging(struct threaded_context *tc)
+{
+   tc->last_draw = NULL;
+   tc->num_state_calls = 0;
+}
+
+/* Called for every new call. If the call replaces state that was set by
+ * an earlier call and nothing has used that state since, the earlier call
+ * is turned into a no-op.
+ */
+static void
+tc_track_call(struct threaded_context *tc, struct tc_call *call)
+{
+   tc->last_draw = NULL;
+
+   switch (tc_call_kind[call->call_id]) {
+   case TC_CALL_KIND_USE_STATE:
+      tc->num_state_calls = 0;
+      return;
+   case TC_CALL_KIND_SET_STATE:
+      return;
+   case TC_CALL_KIND_REPLACE_STATE:
+      break;
+   }
+
+   for (unsigned i = 0; i < tc->num_state_calls; i++) {
+      if (tc->state_calls[i]->call_id == call->call_id) {
+         tc->state_calls[i]->call_id = TC_CALL_nop;
+         tc->state_calls[i] = call;
+         p_atomic_inc(&tc->num_dropped_calls);
+         return;
+      }
+   }
+
+   if (tc->num_state_calls < TC_MAX_TRACKED_STATE_CALLS)
+      tc->state_calls[tc->num_state_calls++] = call;
+}
+
 static void
 tc_batch_flush(struct threaded_context *tc)
 {
@@ -109,6 +197,7 @@ tc_batch_flush(struct threaded_context *tc)
    tc_batch_check(next);
    tc_debug_check(tc);
    tc->bytes_mapped_estimate = 0;
+   tc_reset_merging(tc);
    p_atomic_add(&tc->num_offloaded_slots, next->num_total_call_slots);
 
    if (next->token) {
@@ -150,6 +239,7 @@ tc_add_sized_call(struct threaded_context *tc, enum tc_call_id id,
    call->sentinel = TC_SENTINEL;
    call->call_id = id;
    call->num_call_slots = num_call_slots;
+   tc_track_call(tc, call);
 
    tc_debug_check(tc);
    return &call->payload;
@@ -206,6 +296,7 @@ _tc_sync(struct threaded_context *tc, UNUSED const char *info, UNUSED const char
    if (next->num_total_call_slots) {
       p_atomic_add(&tc->num_direct_slots, next->num_total_call_slots);
       tc->bytes_mapped_estimate = 0;
+      tc_reset_merging(tc);
       tc_batch_execute(next, 0);
       synced = true;
    }
@@ -2091,6 +2182,12 @@ out_of_memory:
    pipe->flush(pipe, fence, flags);
 }
 
+struct tc_multi_draw {
+   struct pipe_draw_info info;
+   unsigned num_draws;
+   struct pipe_draw_start_count slot[0]; /* more will be allocated if needed */
+};
+
 /* This is actually variable-sized, because indirect isn't allocated if it's
  * not needed. */
 struct tc_full_draw_info {
@@ -2122,6 +2219,88 @@ tc_add_draw_vbo(struct pipe_context *_pipe, bool indirect)
                                        sizeof(struct pipe_draw_info));
 }
 
+static struct tc_call *
+tc_payload_to_call(void *payload)
+{
+   return (struct tc_call*)((char*)payload - offsetof(struct tc_call, payload));
+}
+
+/* Whether two direct draws can be executed by one multi_draw call. */
+static bool
+tc_is_draw_compatible(const struct pipe_draw_info *a,
+                      const struct pipe_draw_info *b)
+{
+   return a->index_size == b->index_size &&
+          a->mode == b->mode &&
+          a->primitive_restart == b->primitive_restart &&
+          a->vertices_per_patch == b->vertices_per_patch &&
+          a->start_instance == b->start_instance &&
+          a->instance_count == b->instance_count &&
+          (!a->primitive_restart || a->restart_index == b->restart_index) &&
+          (!a->index_size || a->index.resource == b->index.resource);
+}
+
+/* Try to append a direct draw with a real or no index buffer to the draw
+ * recorded last.  If that's a draw_vbo call, it's turned into a multi_draw
+ * call in place.  This works because the last call ends the batch and
+ * pipe_draw_info is at the beginning of both payloads.
+ */
+static bool
+tc_merge_draw(struct threaded_context *tc, const struct pipe_draw_info *info)
+{
+   struct tc_batch *next = &tc->batch_slots[tc->next];
+   struct tc_call *call = tc->last_draw;
+   struct tc_multi_draw *p = (struct tc_multi_draw*)&call->payload;
+   unsigned num_draws = call->call_id == TC_CALL_multi_draw ? p->num_draws : 1;
+   bool increment_draw_id;
+
+   if (num_draws >= TC_MAX_MULTI_DRAWS ||
+       !tc_is_draw_compatible(&p->info, info))
+      return false;
+
+   if (num_draws == 1 && info->drawid == p->info.drawid)
+      increment_draw_id = false;
+   else if (num_draws == 1 && info->drawid == p->info.drawid + 1)
+      increment_draw_id = true;
+   else if (num_draws > 1 &&
+            info->drawid == p->info.drawid +
+                            (p->info.increment_draw_id ? num_draws : 0))
+      increment_draw_id = p->info.increment_draw_id;
+   else
+      return false;
+
+   unsigned total_size = offsetof(struct tc_call, payload) +
+                         sizeof(struct tc_multi_draw) +
+                         sizeof(p->slot[0]) * (num_draws + 1);
+   unsigned num_call_slots = DIV_ROUND_UP(total_size, sizeof(struct tc_call));
+
+   if (next->num_total_call_slots - call->num_call_slots + num_call_slots >
+       TC_CALLS_PER_BATCH)
+      return false;
+
+   if (call->call_id == TC_CALL_draw_vbo) {
+      p->slot[0].start = p->info.start;
+      p->slot[0].count = p->info.count;
+      p->slot[0].index_bias = p->info.index_bias;
+      p->num_draws = 1;
+      call->call_id = TC_CALL_multi_draw;
+   }
+
+   p->info.increment_draw_id = increment_draw_id;
+   p->info.min_index = MIN2(p->info.min_index, info->min_index);
+   p->info.max_index = MAX2(p->info.max_index, info->max_index);
+   p->slot[num_draws].start = info->start;
+   p->slot[num_draws].count = info->count;
+   p->slot[num_draws].index_bias = info->index_bias;
+   p->num_draws++;
+
+   next->num_total_call_slots += num_call_slots - call->num_call_slots;
+   call->num_call_slots = num_call_slots;
+   p_atomic_inc(&tc->num_merged_draws);
+   tc_debug_check(tc);
+   return true;
+}
+
 static void
 tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
 {
@@ -2147,6 +2326,20 @@ tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
       if (unlikely(!buffer))
          return;
 
+      /* Uploads usually go to the same buffer as the previous draw. */
+      if (tc->last_draw) {
+         struct pipe_draw_info tmp = *info;
+
+         tmp.has_user_indices = false;
+         tmp.index.resource = buffer;
+         tmp.start = offset >> util_logbase2(index_size);
+
+         if (tc_merge_draw(tc, &tmp)) {
+            pipe_resource_reference(&buffer, NULL);
+            return;
+         }
+      }
+
       struct tc_full_draw_info *p = tc_add_draw_vbo(_pipe, false);
       p->draw.count_from_stream_output = NULL;
       pipe_so_target_reference(&p->draw.count_from_stream_output,
@@ -2155,7 +2348,13 @@ tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
       p->draw.has_user_indices = false;
       p->draw.index.resource = buffer;
       p->draw.start = offset >> util_logbase2(index_size);
+      tc->last_draw = tc_payload_to_call(p);
    } else {
+      bool direct = !indirect && !info->count_from_stream_output;
+
+      if (direct && tc->last_draw && tc_merge_draw(tc, info))
+         return;
+
       /* Non-indexed call or indexed with a real index buffer. */
       struct tc_full_draw_info *p = tc_add_draw_vbo(_pipe, indirect != NULL);
       p->draw.count_from_stream_output = NULL;
@@ -2174,6 +2373,86 @@ tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
          memcpy(&p->indirect, indirect, sizeof(*indirect));
          p->draw.indirect = &p->indirect;
       }
+
+      if (direct)
+         tc->last_draw = tc_payload_to_call(p);
+   }
+}
+
+static void
+tc_call_multi_draw(struct pipe_context *pipe, union tc_payload *payload)
+{
+   struct tc_multi_draw *p = (struct tc_multi_draw *)payload;
+
+   if (pipe->multi_draw)
+      pipe->multi_draw(pipe, &p->info, p->slot, p->num_draws);
+   else
+      util_draw_multi(pipe, &p->info, p->slot, p->num_draws);
+
+   if (p->info.index_size)
+      pipe_resource_reference(&p->info.index.resource, NULL);
+}
+
+static void
+tc_multi_draw(struct pipe_context *_pipe, const struct pipe_draw_info *info,
+              const struct pipe_draw_start_count *draws, unsigned num_draws)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   unsigned index_size = info->index_size;
+
+   tc_assert(!info->indirect && !info->count_from_stream_output);
+
+   /* All draws go into one call, unless there are too many to fit. */
+   for (unsigned first = 0; first < num_draws; first += TC_MAX_MULTI_DRAWS) {
+      const struct pipe_draw_start_count *chunk = draws + first;
+      unsigned num = MIN2(num_draws - first, TC_MAX_MULTI_DRAWS);
+      struct pipe_resource *buffer = NULL;
+      unsigned start_bias = 0;
+
+      if (index_size && info->has_user_indices) {
+         unsigned min_start = ~0u, end = 0, offset;
+
+         for (unsigned i = 0; i < num; i++) {
+            if (chunk[i].count) {
+               min_start = MIN2(min_start, chunk[i].start);
+               end = MAX2(end, chunk[i].start + chunk[i].count);
+            }
+         }
+         if (!end)
+            continue;
+
+         /* Upload the index range used by all draws.  This must be done
+          * before adding the call, see tc_draw_vbo.
+          */
+         u_upload_data(tc->base.stream_uploader, 0,
+                       (end - min_start) * index_size, 4,
+                       (uint8_t*)info->index.user + min_start * index_size,
+                       &offset, &buffer);
+         if (unlikely(!buffer))
+            return;
+
+         start_bias = (offset >> util_logbase2(index_size)) - min_start;
+      }
+
+      struct tc_multi_draw *p =
+         tc_add_slot_based_call(tc, TC_CALL_multi_draw, tc_multi_draw, num);
+
+      memcpy(&p->info, info, sizeof(*info));
+      if (info->increment_draw_id)
+         p->info.drawid = info->drawid + first;
+      p->num_draws = num;
+      memcpy(p->slot, chunk, num * sizeof(*chunk));
+
+      if (buffer) {
+         p->info.has_user_indices = false;
+         p->info.index.resource = buffer;
+         for (unsigned i = 0; i < num; i++)
+            p->slot[i].start += start_bias;
+      } else if (index_size) {
+         tc_set_resource_reference(&p->info.index.resource,
+                                   info->index.resource);
+      }
+      tc->last_draw = tc_payload_to_call(p);
    }
 }
 
@@ -2688,6 +2967,8 @@ threaded_context_create(struct pipe_context *pipe,
 
    CTX_INIT(flush);
    CTX_INIT(draw_vbo);
+   /* Drivers without multi_draw execute it with util_draw_multi. */
+   tc->base.multi_draw = tc_multi_draw;
    CTX_INIT(launch_grid);
    CTX_INIT(resource_copy_region);
    CTX_INIT(blit);
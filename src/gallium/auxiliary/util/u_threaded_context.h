@@ -176,6 +176,13 @@
  * The batches are ordered in a ring and reused once they are idle again.
  * The batching is necessary for low queue/mutex overhead.
  *
+ * Calls are merged while the batch is being recorded:
+ * - A CSO bind or another state call that holds no references is turned
+ *   into a no-op when the same state is set again before any call that can
+ *   use it (draws, clears, blits, flushes, etc.).
+ * - A direct draw that directly follows a compatible draw in the same batch
+ *   is appended to it, turning it into a multi_draw call.
+ *
  */
 
 #ifndef U_THREADED_CONTEXT_H
@@ -232,6 +239,14 @@ struct tc_unflushed_batch_token;
  */
 #define TC_MAX_SUBDATA_BYTES        320
 
+/* Maximum number of draws in one multi_draw call slot.  Longer arrays are
+ * split into several calls.
+ */
+#define TC_MAX_MULTI_DRAWS          256
+
+/* Maximum number of distinct state calls tracked for merging. */
+#define TC_MAX_TRACKED_STATE_CALLS  16
+
 typedef void (*tc_replace_buffer_storage_func)(struct pipe_context *ctx,
                                                struct pipe_resource *dst,
                                                struct pipe_resource *src);
@@ -360,6 +375,16 @@ struct threaded_context {
    unsigned num_offloaded_slots;
    unsigned num_direct_slots;
    unsigned num_syncs;
+   unsigned num_merged_draws;
+   unsigned num_dropped_calls;
+
+   /* Merging state of the batch being recorded. last_draw is the last call
+    * of the batch if it's a draw that can be appended to, and state_calls
+    * are the state calls recorded since the last call that can use them.
+    */
+   struct tc_call *last_draw;
+   struct tc_call *state_calls[TC_MAX_TRACKED_STATE_CALLS];
+   unsigned num_state_calls;
 
    /* Estimation of how much vram/gtt bytes are mmap'd in
     * the current tc_batch.
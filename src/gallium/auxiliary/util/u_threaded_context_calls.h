@@ -1,3 +1,4 @@
+CALL(nop)
 CALL(flush)
 CALL(callback)
 CALL(fence_server_sync)
@@ -26,6 +27,7 @@ CALL(buffer_subdata)
 CALL(texture_subdata)
 CALL(emit_string_marker)
 CALL(draw_vbo)
+CALL(multi_draw)
 CALL(launch_grid)
 CALL(resource_copy_region)
 CALL(blit)
@@ -87,6 +87,7 @@
 
 #include "util/u_vbuf.h"
 
+#include "util/u_draw.h"
 #include "util/u_dump.h"
 #include "util/format/u_format.h"
 #include "util/u_inlines.h"
@@ -96,7 +97,6 @@
 #include "translate/translate.h"
 #include "translate/translate_cache.h"
 #include "cso_cache/cso_cache.h"
-#include "cso_cache/cso_hash.h"
 
 struct u_vbuf_elements {
    unsigned count;
@@ -342,29 +342,27 @@ u_vbuf_set_vertex_elements_internal(struct u_vbuf *mgr,
 {
    struct pipe_context *pipe = mgr->pipe;
    unsigned key_size, hash_key;
-   struct cso_hash_iter iter;
+   struct cso_velements *cso;
    struct u_vbuf_elements *ve;
 
    /* need to include the count into the stored state data too. */
    key_size = sizeof(struct pipe_vertex_element) * velems->count +
               sizeof(unsigned);
    hash_key = cso_construct_key((void*)velems, key_size);
-   iter = cso_find_state_template(mgr->cso_cache, hash_key, CSO_VELEMENTS,
-                                  (void*)velems, key_size);
+   cso = cso_find_state_template(mgr->cso_cache, hash_key, CSO_VELEMENTS,
+                                 velems, key_size);
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_velements *cso = MALLOC_STRUCT(cso_velements);
+   if (!cso) {
+      cso = MALLOC_STRUCT(cso_velements);
       memcpy(&cso->state, velems, key_size);
       cso->data = u_vbuf_create_vertex_elements(mgr, velems->count,
                                                 velems->velems);
       cso->delete_state = (cso_state_callback)u_vbuf_delete_vertex_elements;
       cso->context = (void*)mgr;
 
-      iter = cso_insert_state(mgr->cso_cache, hash_key, CSO_VELEMENTS, cso);
-      ve = cso->data;
-   } else {
-      ve = ((struct cso_velements *)cso_hash_iter_data(iter))->data;
+      cso_insert_state(mgr->cso_cache, hash_key, CSO_VELEMENTS, cso);
    }
+   ve = cso->data;
 
    assert(ve);
 
@@ -1572,6 +1570,51 @@ void u_vbuf_draw_vbo(struct u_vbuf *mgr, const struct pipe_draw_info *info)
    }
 }
 
+void u_vbuf_multi_draw(struct u_vbuf *mgr, const struct pipe_draw_info *info,
+                       const struct pipe_draw_start_count *draws,
+                       unsigned num_draws)
+{
+   struct pipe_context *pipe = mgr->pipe;
+   const uint32_t used_vb_mask = mgr->ve->used_vb_mask;
+   struct pipe_draw_info tmp;
+
+   /* Normal draw. No fallback and no user buffers. */
+   if (!(mgr->incompatible_vb_mask & used_vb_mask) &&
+       !mgr->ve->incompatible_elem_mask &&
+       !(mgr->user_vb_mask & used_vb_mask)) {
+
+      /* Set vertex buffers if needed. */
+      if (mgr->dirty_real_vb_mask & used_vb_mask) {
+         u_vbuf_set_driver_vertex_buffers(mgr);
+      }
+
+      if (pipe->multi_draw)
+         pipe->multi_draw(pipe, info, draws, num_draws);
+      else
+         util_draw_multi(pipe, info, draws, num_draws);
+      return;
+   }
+
+   /* The fallbacks upload and translate vertices per draw. */
+   tmp = *info;
+   for (unsigned i = 0; i < num_draws; i++) {
+      if (!draws[i].count)
+         continue;
+
+      tmp.start = draws[i].start;
+      tmp.count = draws[i].count;
+      tmp.index_bias = draws[i].index_bias;
+      tmp.drawid = info->drawid + (info->increment_draw_id ? i : 0);
+
+      if (!info->index_size) {
+         tmp.min_index = tmp.start;
+         tmp.max_index = tmp.start + tmp.count - 1;
+      }
+
+      u_vbuf_draw_vbo(mgr, &tmp);
+   }
+}
+
 void u_vbuf_save_vertex_elements(struct u_vbuf *mgr)
 {
    assert(!mgr->ve_saved);
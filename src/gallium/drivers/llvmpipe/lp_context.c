@@ -47,6 +47,7 @@
 #include "lp_query.h"
 #include "lp_setup.h"
 #include "lp_screen.h"
+#include "lp_cs_tpool.h"
 
 /* This is only safe if there's just one concurrent context */
 #ifdef EMBEDDED_DEVICE
@@ -144,6 +145,13 @@ static void lp_draw_disk_cache_find_shader(void *cookie,
 {
    struct llvmpipe_screen *screen = cookie;
    lp_disk_cache_find_shader(screen, cache, ir_sha1_cache_key);
+
+   if (screen->disk_shader_cache) {
+      if (cache->data_size)
+         p_atomic_inc(&screen->num_disk_draw_cache_hits);
+      else
+         p_atomic_inc(&screen->num_disk_draw_cache_misses);
+   }
 }
 
 static void lp_draw_disk_cache_insert_shader(void *cookie,
@@ -154,6 +162,38 @@ static void lp_draw_disk_cache_insert_shader(void *cookie,
    lp_disk_cache_insert_shader(screen, cache, ir_sha1_cache_key);
 }
 
+struct lp_draw_task {
+   draw_task_func func;
+   void *data;
+};
+
+static void lp_draw_task_run(void *data, int iter_idx,
+                             struct lp_cs_local_mem *lmem)
+{
+   struct lp_draw_task *draw_task = data;
+   draw_task->func(draw_task->data, iter_idx);
+}
+
+static void lp_draw_run_tasks(void *cookie,
+                              draw_task_func func,
+                              void *data,
+                              unsigned count)
+{
+   struct llvmpipe_screen *screen = cookie;
+   struct lp_draw_task draw_task = { func, data };
+   struct lp_cs_tpool_task *task;
+   unsigned i;
+
+   task = lp_cs_tpool_queue_task(screen->cs_tpool, lp_draw_task_run,
+                                 &draw_task, count);
+   if (!task) {
+      for (i = 0; i < count; i++)
+         func(data, i);
+      return;
+   }
+   lp_cs_tpool_wait_for_task(screen->cs_tpool, &task);
+}
+
 static enum pipe_reset_status
 llvmpipe_get_device_reset_status(struct pipe_context *pipe)
 {
@@ -231,6 +271,20 @@ llvmpipe_create_context(struct pipe_screen *screen, void *priv,
                                  lp_draw_disk_cache_find_shader,
                                  lp_draw_disk_cache_insert_shader);
 
+   if (llvmpipe_screen(screen)->num_vs_threads > 1)
+      draw_set_task_callback(llvmpipe->draw,
+                             llvmpipe_screen(screen),
+                             llvmpipe_screen(screen)->num_vs_threads,
+                             lp_draw_run_tasks);
+
+   /* Setup only scissors triangles to the viewport, so lines still need
+    * to be clipped to it.
+    */
+   if (llvmpipe_screen(screen)->guard_band) {
+      draw_set_driver_clipping(llvmpipe->draw, FALSE, FALSE, TRUE, FALSE);
+      draw_set_clip_lines_xy(llvmpipe->draw, TRUE);
+   }
+
    draw_set_constant_buffer_stride(llvmpipe->draw, lp_get_constant_buffer_stride(screen));
 
    /* FIXME: devise alternative to draw_texture_samplers */
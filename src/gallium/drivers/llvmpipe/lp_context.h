@@ -89,6 +89,7 @@ struct llvmpipe_context {
    struct pipe_vertex_buffer vertex_buffer[PIPE_MAX_ATTRIBS];
 
    struct pipe_shader_buffer ssbos[PIPE_SHADER_TYPES][LP_MAX_TGSI_SHADER_BUFFERS];
+   unsigned ssbo_write_mask[PIPE_SHADER_TYPES];  /**< writable ssbos */
    struct pipe_image_view images[PIPE_SHADER_TYPES][LP_MAX_TGSI_SHADER_IMAGES];
 
    unsigned num_samplers[PIPE_SHADER_TYPES];
@@ -150,6 +151,10 @@ struct llvmpipe_context {
    struct blitter_context *blitter;
 
    unsigned tex_timestamp;
+   unsigned cs_tex_timestamp;
+
+   /** The fs variant bound to setup */
+   struct lp_fragment_shader_variant *fs_variant;
 
    /** List of all fragment shader variants */
    struct lp_fs_variant_list_item fs_variants_list;
@@ -32,10 +32,53 @@
 #include "util/u_memory.h"
 #include "lp_cs_tpool.h"
 
+/* Aim for this many chunks per worker, so that there is something left
+ * to steal when the workgroups don't all take the same time.
+ */
+#define LP_CS_TPOOL_CHUNKS_PER_THREAD 8
+
+static void
+lp_cs_tpool_task_release(struct lp_cs_tpool_task *task, unsigned count)
+{
+   if (p_atomic_add_return(&task->pending, -(int)count) == 0)
+      util_queue_fence_signal(&task->finish);
+}
+
+/**
+ * Run chunks of iterations of a task until they have all been claimed,
+ * starting with the worker's own slice and then stealing from the others.
+ */
+static void
+lp_cs_tpool_run_task(struct lp_cs_tpool_task *task, unsigned index,
+                     struct lp_cs_local_mem *lmem)
+{
+   unsigned chunk = task->iter_per_chunk;
+
+   for (unsigned i = 0; i < task->num_slices; i++) {
+      struct lp_cs_tpool_slice *slice =
+         &task->slices[(index + i) % task->num_slices];
+
+      while ((unsigned)p_atomic_read(&slice->next) < slice->end) {
+         unsigned start = p_atomic_add_return(&slice->next, chunk) - chunk;
+         unsigned end;
+
+         if (start >= slice->end)
+            break;
+
+         end = MIN2(start + chunk, slice->end);
+         for (unsigned iter = start; iter < end; iter++)
+            task->work(task->data, iter, lmem);
+
+         lp_cs_tpool_task_release(task, end - start);
+      }
+   }
+}
+
 static int
 lp_cs_tpool_worker(void *data)
 {
-   struct lp_cs_tpool *pool = data;
+   struct lp_cs_tpool_worker *worker = data;
+   struct lp_cs_tpool *pool = worker->pool;
    struct lp_cs_local_mem lmem;
 
    memset(&lmem, 0, sizeof(lmem));
@@ -52,17 +95,19 @@ lp_cs_tpool_worker(void *data)
 
       task = list_first_entry(&pool->workqueue, struct lp_cs_tpool_task,
                               list);
-      unsigned this_iter = task->iter_start++;
-
-      if (task->iter_start == task->iter_total)
-         list_del(&task->list);
+      p_atomic_inc(&task->pending);
 
       mtx_unlock(&pool->m);
-      task->work(task->data, this_iter, &lmem);
+      lp_cs_tpool_run_task(task, worker->index, &lmem);
       mtx_lock(&pool->m);
-      task->iter_finished++;
-      if (task->iter_finished == task->iter_total)
-         cnd_broadcast(&task->finish);
+
+      /* All the iterations have been handed out. */
+      if (task->queued) {
+         list_del(&task->list);
+         task->queued = false;
+         lp_cs_tpool_task_release(task, 1);
+      }
+      lp_cs_tpool_task_release(task, 1);
    }
    mtx_unlock(&pool->m);
    FREE(lmem.local_mem_ptr);
@@ -82,9 +127,25 @@ lp_cs_tpool_create(unsigned num_threads)
 
    list_inithead(&pool->workqueue);
    assert (num_threads <= LP_MAX_THREADS);
-   pool->num_threads = num_threads;
-   for (unsigned i = 0; i < num_threads; i++)
-      pool->threads[i] = u_thread_create(lp_cs_tpool_worker, pool);
+   if (num_threads) {
+      pool->workers = CALLOC(num_threads, sizeof(*pool->workers));
+      if (!pool->workers) {
+         cnd_destroy(&pool->new_work);
+         mtx_destroy(&pool->m);
+         FREE(pool);
+         return NULL;
+      }
+   }
+   for (unsigned i = 0; i < num_threads; i++) {
+      struct lp_cs_tpool_worker *worker = &pool->workers[i];
+
+      worker->pool = pool;
+      worker->index = i;
+      worker->thread = u_thread_create(lp_cs_tpool_worker, worker);
+      if (!worker->thread)
+         break;
+      pool->num_threads++;
+   }
    return pool;
 }
 
@@ -100,11 +161,12 @@ lp_cs_tpool_destroy(struct lp_cs_tpool *pool)
    mtx_unlock(&pool->m);
 
    for (unsigned i = 0; i < pool->num_threads; i++) {
-      thrd_join(pool->threads[i], NULL);
+      thrd_join(pool->workers[i].thread, NULL);
    }
 
    cnd_destroy(&pool->new_work);
    mtx_destroy(&pool->m);
+   FREE(pool->workers);
    FREE(pool);
 }
 
@@ -113,6 +175,7 @@ lp_cs_tpool_queue_task(struct lp_cs_tpool *pool,
                        lp_cs_tpool_task_func work, void *data, int num_iters)
 {
    struct lp_cs_tpool_task *task;
+   unsigned num_slices, slice_size;
 
    if (pool->num_threads == 0) {
       struct lp_cs_local_mem lmem;
@@ -121,9 +184,12 @@ lp_cs_tpool_queue_task(struct lp_cs_tpool *pool,
       for (unsigned t = 0; t < num_iters; t++) {
          work(data, t, &lmem);
       }
+      FREE(lmem.local_mem_ptr);
       return NULL;
    }
-   task = CALLOC_STRUCT(lp_cs_tpool_task);
+
+   num_slices = MAX2(1, MIN2(pool->num_threads, (unsigned)num_iters));
+   task = CALLOC(1, sizeof(*task) + num_slices * sizeof(task->slices[0]));
    if (!task) {
       return NULL;
    }
@@ -131,10 +197,23 @@ lp_cs_tpool_queue_task(struct lp_cs_tpool *pool,
    task->work = work;
    task->data = data;
    task->iter_total = num_iters;
-   cnd_init(&task->finish);
+   task->iter_per_chunk =
+      MAX2(1, num_iters / (pool->num_threads * LP_CS_TPOOL_CHUNKS_PER_THREAD));
+   task->num_slices = num_slices;
+
+   slice_size = DIV_ROUND_UP(num_iters, num_slices);
+   for (unsigned i = 0; i < num_slices; i++) {
+      task->slices[i].next = MIN2(i * slice_size, (unsigned)num_iters);
+      task->slices[i].end = MIN2((i + 1) * slice_size, (unsigned)num_iters);
+   }
+
+   task->pending = num_iters + 1;
+   util_queue_fence_init(&task->finish);
+   util_queue_fence_reset(&task->finish);
 
    mtx_lock(&pool->m);
 
+   task->queued = true;
    list_addtail(&task->list, &pool->workqueue);
 
    cnd_broadcast(&pool->new_work);
@@ -151,12 +230,8 @@ lp_cs_tpool_wait_for_task(struct lp_cs_tpool *pool,
    if (!pool || !task)
       return;
 
-   mtx_lock(&pool->m);
-   while (task->iter_finished < task->iter_total)
-      cnd_wait(&task->finish, &pool->m);
-   mtx_unlock(&pool->m);
-
-   cnd_destroy(&task->finish);
+   util_queue_fence_wait(&task->finish);
+   util_queue_fence_destroy(&task->finish);
    FREE(task);
    *task_handle = NULL;
 }
@@ -30,6 +30,12 @@
  * structs with just unique indexes in them.
  * It also supports a local memory support struct to be passed from
  * outside the thread exec function.
+ *
+ * The iterations of a task are split into one slice per worker thread.
+ * Workers claim chunks of iterations from their own slice with an atomic
+ * add, and steal chunks from the other slices once theirs is drained, so
+ * the pool mutex is only taken once per task and worker, not per
+ * iteration.
  */
 #ifndef LP_CS_QUEUE
 #define LP_CS_QUEUE
@@ -37,15 +43,24 @@
 #include "pipe/p_compiler.h"
 
 #include "util/u_thread.h"
+#include "util/u_queue.h"
 #include "util/list.h"
 
 #include "lp_limits.h"
 
+struct lp_cs_tpool;
+
+struct lp_cs_tpool_worker {
+   struct lp_cs_tpool *pool;
+   unsigned index;
+   thrd_t thread;
+};
+
 struct lp_cs_tpool {
    mtx_t m;
    cnd_t new_work;
 
-   thrd_t threads[LP_MAX_THREADS];
+   struct lp_cs_tpool_worker *workers;
    unsigned num_threads;
    struct list_head workqueue;
    bool shutdown;
@@ -58,14 +73,33 @@ struct lp_cs_local_mem {
 
 typedef void (*lp_cs_tpool_task_func)(void *data, int iter_idx, struct lp_cs_local_mem *lmem);
 
+/* Range of iterations initially assigned to one worker.  Padded to a
+ * cache line so that workers claiming from their own slice don't
+ * contend with each other.
+ */
+struct lp_cs_tpool_slice {
+   int next;
+   unsigned end;
+   uint8_t pad[64 - 2 * sizeof(unsigned)];
+};
+
 struct lp_cs_tpool_task {
    lp_cs_tpool_task_func work;
    void *data;
    struct list_head list;
-   cnd_t finish;
+   bool queued;
+   struct util_queue_fence finish;
    unsigned iter_total;
-   unsigned iter_start;
-   unsigned iter_finished;
+   unsigned iter_per_chunk;
+
+   /* Unfinished iterations, plus one for each worker still looking at
+    * the task, plus one while it is on the work queue.  The finish fence
+    * is signalled once this drops to zero.
+    */
+   int pending;
+
+   unsigned num_slices;
+   struct lp_cs_tpool_slice slices[];
 };
 
 struct lp_cs_tpool *lp_cs_tpool_create(unsigned num_threads);
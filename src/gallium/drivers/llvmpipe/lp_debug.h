@@ -48,6 +48,7 @@
 #define DEBUG_TGSI_IR       0x20000
 #define DEBUG_CL            0x40000
 #define DEBUG_CACHE_STATS   0x80000
+#define DEBUG_RAST_TIME     0x100000
 
 /* Performance flags.  These are active even on release builds.
  */
@@ -59,6 +60,7 @@
 #define PERF_NO_BLEND       0x20  	/* disable blending */
 #define PERF_NO_DEPTH       0x40  	/* disable depth buffering entirely */
 #define PERF_NO_ALPHATEST   0x80  	/* disable alpha testing */
+#define PERF_NO_HIZ         0x100 	/* disable hierarchical depth culling */
 
 
 extern int LP_PERF;
@@ -37,6 +37,7 @@
 #include "util/u_prim.h"
 
 #include "lp_context.h"
+#include "lp_flush.h"
 #include "lp_state.h"
 #include "lp_query.h"
 
@@ -45,30 +46,90 @@
 
 
 /**
- * Draw vertex arrays, with optional indexing, optional instancing.
- * All the other drawing functions are implemented in terms of this function.
- * Basically, map the vertex buffers (and drawing surfaces), then hand off
- * the drawing to the 'draw' module.
+ * The draw module runs vertex fetch and the vertex, geometry and
+ * tessellation shaders on this thread, while scenes flushed earlier may
+ * still be rasterizing.  Wait for those that write what these read, or
+ * read what they write.  This has to happen on every draw, as resources
+ * stay bound while later scenes render to them.
  */
 static void
-llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
+llvmpipe_sync_draw_resources(struct llvmpipe_context *lp,
+                             const struct pipe_draw_info *info)
+{
+   struct pipe_context *pipe = &lp->pipe;
+   unsigned sh, i;
+
+   for (i = 0; i < lp->num_vertex_buffers; i++) {
+      if (!lp->vertex_buffer[i].is_user_buffer &&
+          lp->vertex_buffer[i].buffer.resource)
+         llvmpipe_flush_resource(pipe, lp->vertex_buffer[i].buffer.resource,
+                                 0, TRUE, TRUE, FALSE, "vertex_buffer");
+   }
+
+   if (info->index_size && !info->has_user_indices)
+      llvmpipe_flush_resource(pipe, info->index.resource, 0, TRUE, TRUE,
+                              FALSE, "index_buffer");
+
+   for (i = 0; i < lp->num_so_targets; i++) {
+      if (lp->so_targets[i] && lp->so_targets[i]->target.buffer)
+         llvmpipe_flush_resource(pipe, lp->so_targets[i]->target.buffer, 0,
+                                 FALSE, TRUE, FALSE, "stream_output");
+   }
+
+   for (sh = 0; sh < PIPE_SHADER_TYPES; sh++) {
+      if (sh == PIPE_SHADER_FRAGMENT || sh == PIPE_SHADER_COMPUTE)
+         continue;
+
+      for (i = 0; i < ARRAY_SIZE(lp->constants[sh]); i++) {
+         if (lp->constants[sh][i].buffer)
+            llvmpipe_flush_resource(pipe, lp->constants[sh][i].buffer, 0,
+                                    TRUE, TRUE, FALSE, "vs_constants");
+      }
+
+      for (i = 0; i < lp->num_sampler_views[sh]; i++) {
+         if (lp->sampler_views[sh][i])
+            llvmpipe_flush_resource(pipe, lp->sampler_views[sh][i]->texture,
+                                    0, TRUE, TRUE, FALSE, "vs_sampler_view");
+      }
+
+      for (i = 0; i < lp->num_images[sh]; i++) {
+         const struct pipe_image_view *image = &lp->images[sh][i];
+
+         if (image->resource)
+            llvmpipe_flush_resource(pipe, image->resource, 0,
+                                    !(image->access & PIPE_IMAGE_ACCESS_WRITE),
+                                    TRUE, FALSE, "vs_image");
+      }
+
+      for (i = 0; i < ARRAY_SIZE(lp->ssbos[sh]); i++) {
+         if (lp->ssbos[sh][i].buffer)
+            llvmpipe_flush_resource(pipe, lp->ssbos[sh][i].buffer, 0,
+                                    !(lp->ssbo_write_mask[sh] & (1u << i)),
+                                    TRUE, FALSE, "vs_ssbo");
+      }
+   }
+}
+
+
+/**
+ * Validate state and map the vertex buffers (and drawing surfaces) for
+ * the 'draw' module.  Returns the mapped index buffer, if any.
+ */
+static const void *
+llvmpipe_draw_begin(struct llvmpipe_context *lp,
+                    const struct pipe_draw_info *info)
 {
-   struct llvmpipe_context *lp = llvmpipe_context(pipe);
    struct draw_context *draw = lp->draw;
    const void *mapped_indices = NULL;
    unsigned i;
 
-   if (!llvmpipe_check_render_cond(lp))
-      return;
-
-   if (info->indirect) {
-      util_draw_indirect(pipe, info);
-      return;
-   }
+   llvmpipe_sync_draw_resources(lp, info);
 
    if (lp->dirty)
       llvmpipe_update_derived( lp );
 
+   lp_fs_variant_count_draw(lp);
+
    /*
     * Map vertex buffers
     */
@@ -138,8 +199,15 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
                                      lp->active_primgen_queries &&
                                      !lp->queries_disabled);
 
-   /* draw! */
-   draw_vbo(draw, info);
+   return mapped_indices;
+}
+
+
+static void
+llvmpipe_draw_end(struct llvmpipe_context *lp, const void *mapped_indices)
+{
+   struct draw_context *draw = lp->draw;
+   unsigned i;
 
    /*
     * unmap vertex/index buffers
@@ -168,8 +236,62 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
 }
 
 
+/**
+ * Draw vertex arrays, with optional indexing, optional instancing.
+ * All the other drawing functions are implemented in terms of this function.
+ * Basically, map the vertex buffers (and drawing surfaces), then hand off
+ * the drawing to the 'draw' module.
+ */
+static void
+llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
+{
+   struct llvmpipe_context *lp = llvmpipe_context(pipe);
+   const void *mapped_indices;
+
+   if (!llvmpipe_check_render_cond(lp))
+      return;
+
+   if (info->indirect) {
+      util_draw_indirect(pipe, info);
+      return;
+   }
+
+   mapped_indices = llvmpipe_draw_begin(lp, info);
+
+   /* draw! */
+   draw_vbo(lp->draw, info);
+
+   llvmpipe_draw_end(lp, mapped_indices);
+}
+
+
+/**
+ * Same as several llvmpipe_draw_vbo calls, but the state is validated and
+ * the buffers are mapped only once.
+ */
+static void
+llvmpipe_multi_draw(struct pipe_context *pipe,
+                    const struct pipe_draw_info *info,
+                    const struct pipe_draw_start_count *draws,
+                    unsigned num_draws)
+{
+   struct llvmpipe_context *lp = llvmpipe_context(pipe);
+   const void *mapped_indices;
+
+   if (!llvmpipe_check_render_cond(lp))
+      return;
+
+   mapped_indices = llvmpipe_draw_begin(lp, info);
+
+   draw_multi_draw(lp->draw, info, draws, num_draws);
+
+   llvmpipe_draw_end(lp, mapped_indices);
+}
+
+
 void
 llvmpipe_init_draw_funcs(struct llvmpipe_context *llvmpipe)
 {
    llvmpipe->pipe.draw_vbo = llvmpipe_draw_vbo;
+   llvmpipe->pipe.multi_draw = llvmpipe_multi_draw;
 }
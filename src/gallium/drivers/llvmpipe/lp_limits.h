@@ -66,7 +66,12 @@
 
 #define LP_MAX_SAMPLES 4
 
-#define LP_MAX_THREADS 16
+/**
+ * Upper bound on the number of rasterizer/compute threads.  The default is
+ * the number of CPUs, and all per-thread storage is sized at runtime for
+ * the number of threads actually created.
+ */
+#define LP_MAX_THREADS 1024
 
 
 /**
@@ -74,6 +79,13 @@
  */
 #define LP_MAX_SCENE_SIZE (512 * 1024 * 1024)
 
+/**
+ * Max number of scenes per context.  How many are actually used is set
+ * with LP_NUM_SCENES: while the rasterizer works on one, the next ones
+ * can be binned.
+ */
+#define LP_MAX_SCENES 8
+
 /**
  * Max number of shader variants (for all shaders combined,
  * per context) that will be kept around.
@@ -25,6 +25,7 @@
  *
  **************************************************************************/
 
+#include <inttypes.h>
 #include "util/u_debug.h"
 #include "lp_debug.h"
 #include "lp_perf.h"
@@ -98,13 +99,26 @@ lp_print_counters(void)
       debug_printf("llvmpipe:   nr_empty_4x4:               %9u (%3.0f%% of %u)\n", lp_count.nr_empty_4, p1, total_4);
       debug_printf("llvmpipe:   nr_non_empty_4x4:           %9u (%3.0f%% of %u)\n", lp_count.nr_non_empty_4, p4, total_4);
 
+      debug_printf("llvmpipe: nr_hiz_scans:                 %9u\n", lp_count.nr_hiz_scans);
+      debug_printf("llvmpipe:   nr_hiz_culled_64x64:        %9u\n", lp_count.nr_hiz_culled_64);
+      debug_printf("llvmpipe:   nr_hiz_culled_16x16:        %9u\n", lp_count.nr_hiz_culled_16);
+      debug_printf("llvmpipe:   nr_hiz_culled_4x4:          %9u\n", lp_count.nr_hiz_culled_4);
+
       debug_printf("llvmpipe: nr_color_tile_clear:          %9u\n", lp_count.nr_color_tile_clear);
       debug_printf("llvmpipe: nr_color_tile_load:           %9u\n", lp_count.nr_color_tile_load);
       debug_printf("llvmpipe: nr_color_tile_store:          %9u\n", lp_count.nr_color_tile_store);
 
+      debug_printf("llvmpipe: scene bytes recycled:         %9" PRIu64 "\n", lp_count.scene_bytes_recycled);
+      debug_printf("llvmpipe: scene bytes allocated:        %9" PRIu64 "\n", lp_count.scene_bytes_allocated);
+
       debug_printf("llvmpipe: nr_llvm_compiles:             %u\n", lp_count.nr_llvm_compiles);
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
       debug_printf("llvmpipe: average LLVM compile time:    %.2f sec\n", lp_count.llvm_compile_time / 1000000.0 / lp_count.nr_llvm_compiles);
 
+      debug_printf("llvmpipe: nr_llvm_fast_compiles:        %u\n", lp_count.nr_llvm_fast_compiles);
+      debug_printf("llvmpipe: total fast compile time:      %.2f sec\n", lp_count.llvm_fast_compile_time / 1000000.0);
+      debug_printf("llvmpipe: nr_fs_tier_ups:               %u\n", lp_count.nr_fs_tier_ups);
+      debug_printf("llvmpipe: nr_fs_tier_up_cache_hits:     %u\n", lp_count.nr_fs_tier_up_cache_hits);
+
    }
 }
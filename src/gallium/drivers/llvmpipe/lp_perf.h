@@ -56,12 +56,23 @@ struct lp_counters
    unsigned nr_fully_covered_4;
    unsigned nr_partially_covered_4;
    unsigned nr_non_empty_4;
+   unsigned nr_hiz_scans;
+   unsigned nr_hiz_culled_64;
+   unsigned nr_hiz_culled_16;
+   unsigned nr_hiz_culled_4;
    unsigned nr_llvm_compiles;
    int64_t llvm_compile_time;  /**< total, in microseconds */
+   unsigned nr_llvm_fast_compiles;
+   int64_t llvm_fast_compile_time;  /**< total, in microseconds */
+   unsigned nr_fs_tier_ups;
+   unsigned nr_fs_tier_up_cache_hits;  /**< tier-ups that compiled nothing */
 
    unsigned nr_color_tile_clear;
    unsigned nr_color_tile_load;
    unsigned nr_color_tile_store;
+
+   uint64_t scene_bytes_recycled;   /**< scene data taken from the pool */
+   uint64_t scene_bytes_allocated;  /**< scene data freshly malloc'ed */
 };
 
 
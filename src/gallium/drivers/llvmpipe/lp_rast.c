@@ -25,6 +25,7 @@
  *
  **************************************************************************/
 
+#include <float.h>
 #include <limits.h>
 #include "util/u_memory.h"
 #include "util/u_math.h"
@@ -34,6 +35,7 @@
 #include "util/u_string.h"
 #include "util/u_thread.h"
 #include "util/u_memset.h"
+#include "util/u_cpu_detect.h"
 #include "util/os_time.h"
 
 #include "lp_scene_queue.h"
@@ -44,12 +46,17 @@
 #include "lp_query.h"
 #include "lp_rast.h"
 #include "lp_rast_priv.h"
+#include "lp_rast_profile.h"
 #include "gallivm/lp_bld_format.h"
 #include "gallivm/lp_bld_debug.h"
 #include "lp_scene.h"
 #include "lp_tex_sample.h"
 
 
+/** Times the depth bounds of a tile may be recomputed before giving up */
+#define LP_HIZ_MAX_SCANS 4
+
+
 #ifdef DEBUG
 int jit_line = 0;
 const struct lp_rast_state *jit_state = NULL;
@@ -73,17 +80,31 @@ lp_rast_begin( struct lp_rasterizer *rast,
 
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
+   if (rast->profile)
+      lp_profile_begin_scene(rast->profile);
+
    lp_scene_begin_rasterization( scene );
-   lp_scene_bin_iter_begin( scene );
+   lp_scene_bin_iter_begin( scene, rast->num_threads );
 }
 
 
+/**
+ * End rasterizing a scene.
+ * Called once per scene by one thread, after all threads are done with it.
+ * Signalling the fence hands the scene back to the setup module, so it must
+ * not be touched afterwards.
+ */
 static void
 lp_rast_end( struct lp_rasterizer *rast )
 {
-   lp_scene_end_rasterization( rast->curr_scene );
+   struct lp_scene *scene = rast->curr_scene;
+
+   lp_scene_end_rasterization( scene );
 
    rast->curr_scene = NULL;
+
+   if (scene->fence)
+      lp_fence_signal(scene->fence);
 }
 
 
@@ -125,6 +146,9 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
                          scene->zsbuf.stride * task->y +
                          scene->zsbuf.format_bytes * task->x;
    }
+
+   task->hiz.valid = 0;
+   task->hiz.scans = 0;
 }
 
 
@@ -200,6 +224,8 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
    LP_DBG(DEBUG_RAST, "%s: value=0x%08x, mask=0x%08x\n",
            __FUNCTION__, clear_value, clear_mask);
 
+   task->hiz.valid = 0;
+
    /*
     * Clear the area of the depth/depth buffer matching this tile.
     */
@@ -327,6 +353,11 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    }
    variant = state->variant;
 
+   if (lp_rast_hiz_reject(task, inputs, tile_x, tile_y, TILE_SIZE)) {
+      LP_COUNT(nr_hiz_culled_64);
+      return;
+   }
+
    /* render the whole 64x64 tile in 4x4 chunks */
    for (y = 0; y < task->height; y += 4){
       for (x = 0; x < task->width; x += 4) {
@@ -338,6 +369,11 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          unsigned depth_sample_stride = 0;
          unsigned i;
 
+         if (lp_rast_hiz_reject(task, inputs, tile_x + x, tile_y + y, 4)) {
+            LP_COUNT(nr_hiz_culled_4);
+            continue;
+         }
+
          /* color buffer */
          for (i = 0; i < scene->fb.nr_cbufs; i++){
             if (scene->fb.cbufs[i]) {
@@ -444,6 +480,11 @@ lp_rast_shade_quads_mask_sample(struct lp_rasterizer_task *task,
    assert((x % 4) == 0);
    assert((y % 4) == 0);
 
+   if (lp_rast_hiz_reject(task, inputs, x, y, 4)) {
+      LP_COUNT(nr_hiz_culled_4);
+      return;
+   }
+
    /* color buffer */
    for (i = 0; i < scene->fb.nr_cbufs; i++) {
       if (scene->fb.cbufs[i]) {
@@ -527,6 +568,9 @@ lp_rast_begin_query(struct lp_rasterizer_task *task,
       break;
    case PIPE_QUERY_PIPELINE_STATISTICS:
       pq->start[task->thread_index] = task->thread_data.ps_invocations;
+      /* Culled fragments wouldn't be counted as shader invocations. */
+      task->hiz_enabled = FALSE;
+      task->hiz.cull = 0;
       break;
    default:
       assert(0);
@@ -569,11 +613,233 @@ lp_rast_end_query(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Whether hierarchical depth can be used with the scene's depth buffer.
+ */
+static boolean
+lp_rast_hiz_supported(const struct lp_scene *scene)
+{
+   const struct util_format_description *desc;
+   unsigned i;
+
+   if (LP_PERF & PERF_NO_HIZ)
+      return FALSE;
+
+   if (!scene->fb.zsbuf || !scene->zsbuf.map ||
+       scene->zsbuf.nr_samples > 1 || scene->fb_max_layer > 0)
+      return FALSE;
+
+   for (i = 0; i < scene->num_active_queries; i++) {
+      if (scene->active_queries[i]->type == PIPE_QUERY_PIPELINE_STATISTICS)
+         return FALSE;
+   }
+
+   desc = util_format_description(scene->fb.zsbuf->format);
+   return util_format_has_depth(desc) && desc->unpack_z_float != NULL;
+}
+
+
+/**
+ * Smallest difference between two depth values of the depth buffer.
+ */
+static float
+lp_rast_hiz_ulp(const struct lp_scene *scene)
+{
+   const struct util_format_description *desc =
+      util_format_description(scene->fb.zsbuf->format);
+   const struct util_format_channel_description *chan =
+      &desc->channel[desc->swizzle[0]];
+
+   if (chan->type == UTIL_FORMAT_TYPE_UNSIGNED && chan->normalized)
+      return (float)(1.0 / (double)((1ull << chan->size) - 1));
+
+   return 0.0f;
+}
+
+
+/**
+ * Work out which depth bounds the new state can cull with, and which
+ * survive its depth writes.
+ */
+static void
+lp_rast_hiz_set_state(struct lp_rasterizer_task *task,
+                      const struct lp_rast_state *state)
+{
+   const struct lp_fragment_shader_variant *variant = state->variant;
+   const struct lp_fragment_shader_variant_key *key = &variant->key;
+   const struct tgsi_shader_info *info = &variant->shader->info.base;
+   struct lp_rast_hiz *hiz = &task->hiz;
+
+   hiz->cull = 0;
+   hiz->keep = LP_HIZ_ZMIN | LP_HIZ_ZMAX;
+
+   if (!key->depth.enabled)
+      return;
+
+   /* Writes can only lower the depth values with LESS, raise them with
+    * GREATER, and leave them alone with EQUAL.
+    */
+   if (key->depth.writemask) {
+      switch (key->depth.func) {
+      case PIPE_FUNC_NEVER:
+      case PIPE_FUNC_EQUAL:
+         break;
+      case PIPE_FUNC_LESS:
+      case PIPE_FUNC_LEQUAL:
+         hiz->keep = LP_HIZ_ZMAX;
+         break;
+      case PIPE_FUNC_GREATER:
+      case PIPE_FUNC_GEQUAL:
+         hiz->keep = LP_HIZ_ZMIN;
+         break;
+      default:
+         hiz->keep = 0;
+         break;
+      }
+   }
+   hiz->valid &= hiz->keep;
+
+   /* Culling must not skip anything but the depth test: not stencil
+    * updates, nor stores, and the depth must be the interpolated one.
+    */
+   if (!task->hiz_enabled ||
+       key->stencil[0].enabled ||
+       key->depth_clamp ||
+       info->writes_z ||
+       info->writes_memory)
+      return;
+
+   switch (key->depth.func) {
+   case PIPE_FUNC_LESS:
+   case PIPE_FUNC_LEQUAL:
+      hiz->cull = LP_HIZ_ZMAX;
+      break;
+   case PIPE_FUNC_GREATER:
+   case PIPE_FUNC_GEQUAL:
+      hiz->cull = LP_HIZ_ZMIN;
+      break;
+   case PIPE_FUNC_EQUAL:
+      hiz->cull = LP_HIZ_ZMIN | LP_HIZ_ZMAX;
+      break;
+   default:
+      break;
+   }
+}
+
+
+/**
+ * Compute the depth bounds of each 16x16 block of the current tile.
+ * Blocks outside the framebuffer get empty bounds.
+ */
+static boolean
+lp_rast_hiz_scan(struct lp_rasterizer_task *task)
+{
+   const struct lp_scene *scene = task->scene;
+   const struct util_format_description *desc =
+      util_format_description(scene->fb.zsbuf->format);
+   struct lp_rast_hiz *hiz = &task->hiz;
+   float row[TILE_SIZE];
+   unsigned x, y;
+
+   if (hiz->scans >= LP_HIZ_MAX_SCANS) {
+      /* The bounds keep getting invalidated, stop trying in this tile. */
+      hiz->cull = 0;
+      return FALSE;
+   }
+   hiz->scans++;
+
+   for (y = 0; y < TILE_SIZE / 16; y++) {
+      for (x = 0; x < TILE_SIZE / 16; x++) {
+         hiz->zmin[y][x] = FLT_MAX;
+         hiz->zmax[y][x] = -FLT_MAX;
+      }
+   }
+
+   for (y = 0; y < task->height; y++) {
+      float *zmin = hiz->zmin[y / 16];
+      float *zmax = hiz->zmax[y / 16];
+
+      desc->unpack_z_float(row, 0,
+                           task->depth_tile + y * scene->zsbuf.stride, 0,
+                           task->width, 1);
+
+      for (x = 0; x < task->width; x++) {
+         zmin[x / 16] = MIN2(zmin[x / 16], row[x]);
+         zmax[x / 16] = MAX2(zmax[x / 16], row[x]);
+      }
+   }
+
+   hiz->valid = (LP_HIZ_ZMIN | LP_HIZ_ZMAX) & hiz->keep;
+   LP_COUNT(nr_hiz_scans);
+   return TRUE;
+}
+
+
+/**
+ * Test the depth range of a triangle's plane over a block against the
+ * depth bounds of the blocks it covers.  The triangle's depth is
+ * evaluated with a pixel of margin, and a generous error allowance, so
+ * that only triangles which fail the depth test everywhere get rejected.
+ */
+boolean
+lp_rast_hiz_test(struct lp_rasterizer_task *task,
+                 const struct lp_rast_shader_inputs *inputs,
+                 int x, int y, unsigned size)
+{
+   struct lp_rast_hiz *hiz = &task->hiz;
+   const float a0 = GET_A0(inputs)[0][2];
+   const float dzdx = GET_DADX(inputs)[0][2];
+   const float dzdy = GET_DADY(inputs)[0][2];
+   const float x0 = (float)(x - 1), x1 = (float)(x + (int)size + 1);
+   const float y0 = (float)(y - 1), y1 = (float)(y + (int)size + 1);
+   const int bx0 = (x - task->x) / 16;
+   const int by0 = (y - task->y) / 16;
+   const int bx1 = MIN2((x - task->x + (int)size - 1) / 16, TILE_SIZE / 16 - 1);
+   const int by1 = MIN2((y - task->y + (int)size - 1) / 16, TILE_SIZE / 16 - 1);
+   float zmin = FLT_MAX, zmax = -FLT_MAX;
+   float zlo, zhi, err;
+   unsigned bounds;
+   int bx, by;
+
+   if (!(hiz->valid & hiz->cull) && !lp_rast_hiz_scan(task))
+      return FALSE;
+
+   bounds = hiz->valid & hiz->cull;
+   if (!bounds)
+      return FALSE;
+
+   for (by = by0; by <= by1; by++) {
+      for (bx = bx0; bx <= bx1; bx++) {
+         zmin = MIN2(zmin, hiz->zmin[by][bx]);
+         zmax = MAX2(zmax, hiz->zmax[by][bx]);
+      }
+   }
+
+   zlo = a0 + MIN2(dzdx * x0, dzdx * x1) + MIN2(dzdy * y0, dzdy * y1);
+   zhi = a0 + MAX2(dzdx * x0, dzdx * x1) + MAX2(dzdy * y0, dzdy * y1);
+   err = hiz->ulp + 8.0f * FLT_EPSILON *
+         (fabsf(a0) + fabsf(dzdx * x1) + fabsf(dzdy * y1));
+
+   /* The fragment depth gets clamped to [0, 1] before the test. */
+   zlo = MIN2(zlo - err, 1.0f);
+   zhi = MAX2(zhi + err, 0.0f);
+
+   if ((bounds & LP_HIZ_ZMAX) && zlo > zmax)
+      return TRUE;
+   if ((bounds & LP_HIZ_ZMIN) && zhi < zmin)
+      return TRUE;
+
+   return FALSE;
+}
+
+
 void
 lp_rast_set_state(struct lp_rasterizer_task *task,
                   const union lp_rast_cmd_arg arg)
 {
    task->state = arg.state;
+
+   lp_rast_hiz_set_state(task, task->state);
 }
 
 
@@ -639,9 +905,59 @@ static lp_rast_cmd_func dispatch[LP_RAST_OP_MAX] =
    lp_rast_triangle_ms_3_4,
    lp_rast_triangle_ms_3_16,
    lp_rast_triangle_ms_4_16,
+   lp_rast_small_triangles,
 };
 
 
+static once_flag dispatch_once_flag = ONCE_FLAG_INIT;
+
+/**
+ * Swap in the triangle rasterizers built for the widest vector
+ * extension the CPU supports.
+ */
+static void
+lp_rast_init_dispatch(void)
+{
+#if defined(USE_AVX512)
+   if (util_cpu_caps.has_avx512f) {
+      lp_rast_triangle_init_avx512(dispatch);
+      return;
+   }
+#endif
+#if defined(USE_AVX2)
+   if (util_cpu_caps.has_avx2) {
+      lp_rast_triangle_init_avx2(dispatch);
+      return;
+   }
+#endif
+}
+
+
+/**
+ * As do_rasterize_bin(), timing each command.
+ */
+static void
+do_rasterize_bin_profiled(struct lp_rasterizer_task *task,
+                          const struct cmd_bin *bin,
+                          int x, int y)
+{
+   const struct cmd_block *block;
+   unsigned k;
+
+   for (block = bin->head; block; block = block->next) {
+      for (k = 0; k < block->count; k++) {
+         int64_t start = os_time_get_nano();
+
+         dispatch[block->cmd[k]]( task, block->arg[k] );
+
+         lp_profile_record(task->profile, LP_PROFILE_CMD,
+                           start, os_time_get_nano(),
+                           block->cmd[k], x, y, task->state);
+      }
+   }
+}
+
+
 static void
 do_rasterize_bin(struct lp_rasterizer_task *task,
                  const struct cmd_bin *bin,
@@ -653,6 +969,11 @@ do_rasterize_bin(struct lp_rasterizer_task *task,
    if (0)
       lp_debug_bin(bin, x, y);
 
+   if (unlikely(task->profile)) {
+      do_rasterize_bin_profiled(task, bin, x, y);
+      return;
+   }
+
    for (block = bin->head; block; block = block->next) {
       for (k = 0; k < block->count; k++) {
          dispatch[block->cmd[k]]( task, block->arg[k] );
@@ -672,12 +993,21 @@ static void
 rasterize_bin(struct lp_rasterizer_task *task,
               const struct cmd_bin *bin, int x, int y )
 {
+   int64_t start_time = 0;
+
+   if (unlikely(task->profile))
+      start_time = os_time_get_nano();
+
    lp_rast_tile_begin( task, bin, x, y );
 
    do_rasterize_bin(task, bin, x, y);
 
    lp_rast_tile_end(task);
 
+   if (unlikely(task->profile))
+      lp_profile_record(task->profile, LP_PROFILE_BIN,
+                        start_time, os_time_get_nano(), 0, x, y, NULL);
+
 #ifdef DEBUG
    /* Debug/Perf flags:
     */
@@ -713,8 +1043,19 @@ static void
 rasterize_scene(struct lp_rasterizer_task *task,
                 struct lp_scene *scene)
 {
+   int64_t start_time = 0;
+   unsigned num_bins = 0;
+
+   if ((LP_DEBUG & DEBUG_RAST_TIME) || task->profile)
+      start_time = os_time_get_nano();
+
    task->scene = scene;
 
+   task->hiz_enabled = lp_rast_hiz_supported(scene);
+   task->hiz.cull = 0;
+   if (task->hiz_enabled)
+      task->hiz.ulp = lp_rast_hiz_ulp(scene);
+
    /* Clear the cache tags. This should not always be necessary but
       simpler for now. */
 #if LP_USE_TEXTURE_CACHE
@@ -733,13 +1074,26 @@ rasterize_scene(struct lp_rasterizer_task *task,
          int i, j;
 
          assert(scene);
-         while ((bin = lp_scene_bin_iter_next(scene, &i, &j))) {
-            if (!is_empty_bin( bin ))
+         while ((bin = lp_scene_bin_iter_next(scene, task->thread_index,
+                                              &i, &j))) {
+            if (!is_empty_bin( bin )) {
                rasterize_bin(task, bin, i, j);
+               num_bins++;
+            }
          }
       }
    }
 
+   if (task->profile)
+      lp_profile_record(task->profile, LP_PROFILE_SCENE,
+                        start_time, os_time_get_nano(), 0, 0, 0, NULL);
+
+   if (LP_DEBUG & DEBUG_RAST_TIME) {
+      debug_printf("llvmpipe: thread %u rasterized %u bins in %" PRId64 " us\n",
+                   task->thread_index, num_bins,
+                   (os_time_get_nano() - start_time) / 1000);
+   }
+
 
 #if LP_BUILD_FORMAT_CACHE_DEBUG
    {
@@ -755,10 +1109,6 @@ rasterize_scene(struct lp_rasterizer_task *task,
    }
 #endif
 
-   if (scene->fence) {
-      lp_fence_signal(scene->fence);
-   }
-
    task->scene = NULL;
 }
 
@@ -807,29 +1157,12 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 }
 
 
-void
-lp_rast_finish( struct lp_rasterizer *rast )
-{
-   if (rast->num_threads == 0) {
-      /* nothing to do */
-   }
-   else {
-      int i;
-
-      /* wait for work to complete */
-      for (i = 0; i < rast->num_threads; i++) {
-         pipe_semaphore_wait(&rast->tasks[i].work_done);
-      }
-   }
-}
-
-
 /**
  * This is the thread's main entrypoint.
  * It's a simple loop:
  *   1. wait for work
  *   2. do work
- *   3. signal that we're done
+ *   3. signal the scene's fence (thread 0, once all threads are done)
  */
 static int
 thread_function(void *init_data)
@@ -843,6 +1176,23 @@ thread_function(void *init_data)
    snprintf(thread_name, sizeof thread_name, "llvmpipe-%u", task->thread_index);
    u_thread_setname(thread_name);
 
+   if (rast->pin_cpus) {
+      void *cache;
+
+      util_pin_thread_to_cpu(thrd_current(),
+                             rast->pin_cpus[task->thread_index]);
+
+      /* Reallocate the per-thread data from the pinned thread, so that it
+       * gets placed on the local NUMA node when first touched.
+       */
+      cache = align_malloc(sizeof(struct lp_build_format_cache), 16);
+      if (cache) {
+         memset(cache, 0, sizeof(struct lp_build_format_cache));
+         align_free(task->thread_data.cache);
+         task->thread_data.cache = cache;
+      }
+   }
+
    /* Make sure that denorms are treated like zeros. This is 
     * the behavior required by D3D10. OpenGL doesn't care.
     */
@@ -882,17 +1232,12 @@ thread_function(void *init_data)
       /* wait for all threads to finish with this scene */
       util_barrier_wait( &rast->barrier );
 
-      /* XXX: shouldn't be necessary:
-       */
       if (task->thread_index == 0) {
          lp_rast_end( rast );
       }
 
-      /* signal done with work */
       if (debug)
          debug_printf("thread %d done working\n", task->thread_index);
-
-      pipe_semaphore_signal(&task->work_done);
    }
 
 #ifdef _WIN32
@@ -926,22 +1271,72 @@ create_rast_threads(struct lp_rasterizer *rast)
 
 
 
+/**
+ * Pick the CPU to pin each rasterizer thread to, among those the process
+ * may run on (which taskset or a cpuset can restrict).  Returns NULL if
+ * the threads can't be pinned.
+ */
+static unsigned *
+get_pin_cpus(unsigned num_threads)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY)
+   cpu_set_t cpuset;
+   unsigned *cpus;
+   unsigned num_cpus = 0;
+   unsigned cpu, i;
+
+   if (pthread_getaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0)
+      return NULL;
+
+   cpus = MALLOC(num_threads * sizeof *cpus);
+   if (!cpus)
+      return NULL;
+
+   for (cpu = 0; cpu < CPU_SETSIZE && num_cpus < num_threads; cpu++) {
+      if (CPU_ISSET(cpu, &cpuset))
+         cpus[num_cpus++] = cpu;
+   }
+
+   if (!num_cpus) {
+      FREE(cpus);
+      return NULL;
+   }
+
+   /* With more threads than CPUs, share them out round-robin. */
+   for (i = num_cpus; i < num_threads; i++)
+      cpus[i] = cpus[i % num_cpus];
+
+   return cpus;
+#else
+   return NULL;
+#endif
+}
+
+
 /**
  * Create new lp_rasterizer.  If num_threads is zero, don't create any
  * new threads, do rendering synchronously.
  * \param num_threads  number of rasterizer threads to create
  */
 struct lp_rasterizer *
-lp_rast_create( unsigned num_threads )
+lp_rast_create( unsigned num_threads, boolean pin_threads )
 {
    struct lp_rasterizer *rast;
    unsigned i;
 
+   call_once(&dispatch_once_flag, lp_rast_init_dispatch);
+
    rast = CALLOC_STRUCT(lp_rasterizer);
    if (!rast) {
       goto no_rast;
    }
 
+   rast->tasks = CALLOC(MAX2(1, num_threads), sizeof *rast->tasks);
+   rast->threads = CALLOC(MAX2(1, num_threads), sizeof *rast->threads);
+   if (!rast->tasks || !rast->threads) {
+      goto no_tasks;
+   }
+
    rast->full_scenes = lp_scene_queue_create();
    if (!rast->full_scenes) {
       goto no_full_scenes;
@@ -959,6 +1354,14 @@ lp_rast_create( unsigned num_threads )
    }
 
    rast->num_threads = num_threads;
+   if (pin_threads && num_threads)
+      rast->pin_cpus = get_pin_cpus(num_threads);
+
+   rast->profile = lp_profile_create(num_threads);
+   if (rast->profile) {
+      for (i = 0; i < MAX2(1, num_threads); i++)
+         rast->tasks[i].profile = &rast->profile->threads[i];
+   }
 
    rast->no_rast = debug_get_bool_option("LP_NO_RAST", FALSE);
 
@@ -974,7 +1377,7 @@ lp_rast_create( unsigned num_threads )
    return rast;
 
 no_thread_data_cache:
-   for (i = 0; i < MAX2(1, rast->num_threads); i++) {
+   for (i = 0; i < MAX2(1, num_threads); i++) {
       if (rast->tasks[i].thread_data.cache) {
          align_free(rast->tasks[i].thread_data.cache);
       }
@@ -982,6 +1385,9 @@ no_thread_data_cache:
 
    lp_scene_queue_destroy(rast->full_scenes);
 no_full_scenes:
+no_tasks:
+   FREE(rast->threads);
+   FREE(rast->tasks);
    FREE(rast);
 no_rast:
    return NULL;
@@ -1023,6 +1429,9 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
       align_free(rast->tasks[i].thread_data.cache);
    }
 
+   if (rast->profile)
+      lp_profile_destroy(rast->profile);
+
    /* for synchronizing rasterization threads */
    if (rast->num_threads > 0) {
       util_barrier_destroy( &rast->barrier );
@@ -1030,6 +1439,9 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
 
    lp_scene_queue_destroy(rast->full_scenes);
 
+   FREE(rast->pin_cpus);
+   FREE(rast->threads);
+   FREE(rast->tasks);
    FREE(rast);
 }
 
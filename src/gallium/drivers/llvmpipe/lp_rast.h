@@ -150,6 +150,28 @@ struct lp_rast_clear_rb {
 };
 
 
+#define LP_RAST_SMALL_TRIS_MAX 16
+
+/**
+ * A 3-plane, single-sample triangle contained in a 4x4 or 16x16 block
+ * of its tile.
+ */
+struct lp_rast_small_tri {
+   const struct lp_rast_triangle *tri;
+   uint8_t x, y;       /**< block position within the tile */
+   uint8_t size;       /**< 4 or 16 */
+};
+
+/**
+ * A run of consecutive small triangles in a bin, rasterized by a single
+ * LP_RAST_OP_SMALL_TRIANGLES command.  Lives in the scene data.
+ */
+struct lp_rast_small_tris {
+   unsigned count;
+   struct lp_rast_small_tri tri[LP_RAST_SMALL_TRIS_MAX];
+};
+
+
 #define GET_A0(inputs) ((float (*)[4])((inputs)+1))
 #define GET_DADX(inputs) ((float (*)[4])((char *)((inputs) + 1) + (inputs)->stride))
 #define GET_DADY(inputs) ((float (*)[4])((char *)((inputs) + 1) + 2 * (inputs)->stride))
@@ -158,7 +180,7 @@ struct lp_rast_clear_rb {
 
 
 struct lp_rasterizer *
-lp_rast_create( unsigned num_threads );
+lp_rast_create( unsigned num_threads, boolean pin_threads );
 
 void
 lp_rast_destroy( struct lp_rasterizer * );
@@ -167,9 +189,6 @@ void
 lp_rast_queue_scene( struct lp_rasterizer *rast,
                      struct lp_scene *scene );
 
-void
-lp_rast_finish( struct lp_rasterizer *rast );
-
 
 union lp_rast_cmd_arg {
    const struct lp_rast_shader_inputs *shade_tile;
@@ -186,6 +205,7 @@ union lp_rast_cmd_arg {
    const struct lp_rast_state *state;
    struct lp_fence *fence;
    struct llvmpipe_query *query_obj;
+   struct lp_rast_small_tris *small_tris;
 };
 
 
@@ -315,7 +335,8 @@ lp_rast_arg_null( void )
 #define LP_RAST_OP_MS_TRIANGLE_3_4   0x25
 #define LP_RAST_OP_MS_TRIANGLE_3_16  0x26
 #define LP_RAST_OP_MS_TRIANGLE_4_16  0x27
-#define LP_RAST_OP_MAX               0x28
+#define LP_RAST_OP_SMALL_TRIANGLES   0x28
+#define LP_RAST_OP_MAX               0x29
 #define LP_RAST_OP_MASK              0xff
 
 void
@@ -54,9 +54,22 @@ static const char *cmd_names[LP_RAST_OP_MAX] =
    "triangle_32_3_4",
    "triangle_32_3_16",
    "triangle_32_4_16",
+   "ms_triangle_1",
+   "ms_triangle_2",
+   "ms_triangle_3",
+   "ms_triangle_4",
+   "ms_triangle_5",
+   "ms_triangle_6",
+   "ms_triangle_7",
+   "ms_triangle_8",
+   "ms_triangle_3_4",
+   "ms_triangle_3_16",
+   "ms_triangle_4_16",
+   "small_triangles",
 };
 
-static const char *cmd_name(unsigned cmd)
+const char *
+lp_rast_cmd_name(unsigned cmd)
 {
    assert(ARRAY_SIZE(cmd_names) > cmd);
    return cmd_names[cmd];
@@ -115,7 +128,7 @@ debug_bin( const struct cmd_bin *bin, int x, int y )
             state = head->arg[i].state;
 
          debug_printf("%d: %s %s\n", j,
-                      cmd_name(head->cmd[i]),
+                      lp_rast_cmd_name(head->cmd[i]),
                       is_blend(state, head, i) ? "blended" : "");
       }
       head = head->next;
@@ -263,7 +276,7 @@ do_debug_bin( struct tile *tile,
          int count = 0;
             
          if (print_cmds)
-            debug_printf("%c: %15s", val, cmd_name(block->cmd[k]));
+            debug_printf("%c: %15s", val, lp_rast_cmd_name(block->cmd[k]));
 
          if (block->cmd[k] == LP_RAST_OP_SET_STATE)
             tile->state = block->arg[k].state;
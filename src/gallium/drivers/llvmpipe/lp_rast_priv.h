@@ -32,6 +32,7 @@
 #include "util/u_thread.h"
 #include "gallivm/lp_bld_debug.h"
 #include "lp_memory.h"
+#include "lp_perf.h"
 #include "lp_rast.h"
 #include "lp_scene.h"
 #include "lp_state.h"
@@ -74,8 +75,31 @@ extern const struct lp_rasterizer_task *jit_task;
 
 
 struct lp_rasterizer;
+struct lp_profile_thread;
 struct cmd_bin;
 
+
+#define LP_HIZ_ZMIN 0x1
+#define LP_HIZ_ZMAX 0x2
+
+/**
+ * Hierarchical depth: conservative bounds of the depth buffer contents of
+ * the tile being rasterized, per 16x16 block.  They let triangles whose
+ * depth test is sure to fail skip whole tiles and blocks without running
+ * the fragment shader.  The bounds are computed from the depth buffer when
+ * first needed, and dropped by clears or depth writes which may move them.
+ */
+struct lp_rast_hiz
+{
+   unsigned cull;   /**< LP_HIZ_x bounds the current state can cull with */
+   unsigned keep;   /**< LP_HIZ_x bounds the current state's writes keep */
+   unsigned valid;  /**< LP_HIZ_x bounds currently valid */
+   unsigned scans;  /**< times the bounds were computed for this tile */
+   float ulp;       /**< precision of the depth buffer */
+   float zmin[TILE_SIZE / 16][TILE_SIZE / 16];
+   float zmax[TILE_SIZE / 16][TILE_SIZE / 16];
+};
+
 /**
  * Per-thread rasterization state
  */
@@ -97,6 +121,13 @@ struct lp_rasterizer_task
    /** "my" index */
    unsigned thread_index;
 
+   /** Where to record timings, NULL unless LP_PROFILE is set */
+   struct lp_profile_thread *profile;
+
+   /** Whether hierarchical depth may be used for the current scene */
+   boolean hiz_enabled;
+   struct lp_rast_hiz hiz;
+
    /** Non-interpolated passthru state and occlude counter for visible pixels */
    struct lp_jit_thread_data thread_data;
 
@@ -122,15 +153,44 @@ struct lp_rasterizer
    struct lp_scene *curr_scene;
 
    /** A task object for each rasterization thread */
-   struct lp_rasterizer_task tasks[LP_MAX_THREADS];
+   struct lp_rasterizer_task *tasks;
 
    unsigned num_threads;
-   thrd_t threads[LP_MAX_THREADS];
+   thrd_t *threads;
+
+   /** CPU to pin each thread to (LP_PIN_THREADS), or NULL */
+   unsigned *pin_cpus;
+
+   /** See lp_rast_profile.h */
+   struct lp_profile *profile;
 
    /** For synchronizing the rasterization threads */
    util_barrier barrier;
 };
 
+boolean
+lp_rast_hiz_test(struct lp_rasterizer_task *task,
+                 const struct lp_rast_shader_inputs *inputs,
+                 int x, int y, unsigned size);
+
+
+/**
+ * Whether the depth test is sure to fail for all the fragments of a
+ * triangle in the size x size block at x, y (in window coordinates, within
+ * the current tile).
+ */
+static inline boolean
+lp_rast_hiz_reject(struct lp_rasterizer_task *task,
+                   const struct lp_rast_shader_inputs *inputs,
+                   int x, int y, unsigned size)
+{
+   if (likely(!task->hiz.cull))
+      return FALSE;
+
+   return lp_rast_hiz_test(task, inputs, x, y, size);
+}
+
+
 void
 lp_rast_shade_quads_mask_sample(struct lp_rasterizer_task *task,
                                 const struct lp_rast_shader_inputs *inputs,
@@ -265,6 +325,11 @@ lp_rast_shade_quads_all( struct lp_rasterizer_task *task,
    for (unsigned i = 0; i < scene->fb_max_samples; i++)
       mask |= (uint64_t)0xffff << (16 * i);
 
+   if (lp_rast_hiz_reject(task, inputs, x, y, 4)) {
+      LP_COUNT(nr_hiz_culled_4);
+      return;
+   }
+
    /*
     * The rasterizer may produce fragments outside our
     * allocated 4x4 blocks hence need to filter them out here.
@@ -293,6 +358,35 @@ lp_rast_shade_quads_all( struct lp_rasterizer_task *task,
    }
 }
 
+
+/**
+ * Shade all pixels in a 4x4 block.
+ */
+static inline void
+lp_rast_block_full_4(struct lp_rasterizer_task *task,
+                     const struct lp_rast_triangle *tri,
+                     int x, int y)
+{
+   lp_rast_shade_quads_all(task, &tri->inputs, x, y);
+}
+
+
+/**
+ * Shade all pixels in a 16x16 block.
+ */
+static inline void
+lp_rast_block_full_16(struct lp_rasterizer_task *task,
+                      const struct lp_rast_triangle *tri,
+                      int x, int y)
+{
+   unsigned ix, iy;
+   assert(x % 16 == 0);
+   assert(y % 16 == 0);
+   for (iy = 0; iy < 16; iy += 4)
+      for (ix = 0; ix < 16; ix += 4)
+         lp_rast_block_full_4(task, tri, x + ix, y + iy);
+}
+
 void lp_rast_triangle_1( struct lp_rasterizer_task *, 
                          const union lp_rast_cmd_arg );
 void lp_rast_triangle_2( struct lp_rasterizer_task *, 
@@ -398,6 +492,33 @@ void lp_rast_triangle_ms_32_3_16( struct lp_rasterizer_task *,
 void lp_rast_triangle_ms_32_4_16( struct lp_rasterizer_task *,
                             const union lp_rast_cmd_arg );
 
+#if defined(USE_AVX2)
+void
+lp_rast_triangle_init_avx2(lp_rast_cmd_func *dispatch);
+
+void
+lp_rast_build_masks_avx2(int c, int cdiff, int dcdx, int dcdy,
+                         unsigned *outmask, unsigned *partmask);
+
+unsigned
+lp_rast_build_mask_linear_avx2(int c, int dcdx, int dcdy);
+#endif
+
+#if defined(USE_AVX512)
+void
+lp_rast_triangle_init_avx512(lp_rast_cmd_func *dispatch);
+
+void
+lp_rast_build_masks_avx512(int c, int cdiff, int dcdx, int dcdy,
+                           unsigned *outmask, unsigned *partmask);
+
+unsigned
+lp_rast_build_mask_linear_avx512(int c, int dcdx, int dcdy);
+#endif
+
+void lp_rast_small_triangles(struct lp_rasterizer_task *,
+                             const union lp_rast_cmd_arg);
+
 void
 lp_rast_set_state(struct lp_rasterizer_task *task,
                   const union lp_rast_cmd_arg arg);
@@ -405,4 +526,7 @@ lp_rast_set_state(struct lp_rasterizer_task *task,
 void
 lp_debug_bin( const struct cmd_bin *bin, int x, int y );
 
+const char *
+lp_rast_cmd_name(unsigned cmd);
+
 #endif
@@ -0,0 +1,416 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#include <inttypes.h>  /* for PRIu64 macro */
+#include <stdio.h>
+#include <stdlib.h>
+#include "util/os_time.h"
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+#include "lp_rast_priv.h"
+#include "lp_rast_profile.h"
+#include "lp_state_fs.h"
+
+
+/** Per thread, events beyond this are only counted in the totals */
+#define LP_PROFILE_MAX_EVENTS (1 << 20)
+
+/** Number of fragment shader variants listed in the summary */
+#define LP_PROFILE_MAX_VARIANTS 20
+
+
+/**
+ * Create the profiler if LP_PROFILE is set, else return NULL.
+ */
+struct lp_profile *
+lp_profile_create(unsigned num_threads)
+{
+   const char *filename = debug_get_option("LP_PROFILE", NULL);
+   struct lp_profile *profile;
+   unsigned i;
+
+   if (!filename || !*filename)
+      return NULL;
+
+   profile = CALLOC_STRUCT(lp_profile);
+   if (!profile)
+      return NULL;
+
+   profile->num_threads = MAX2(1, num_threads);
+   profile->threads = CALLOC(profile->num_threads, sizeof(*profile->threads));
+   if (!profile->threads) {
+      FREE(profile);
+      return NULL;
+   }
+
+   profile->filename = strdup(filename);
+   profile->start_time = os_time_get_nano();
+
+   for (i = 0; i < profile->num_threads; i++) {
+      util_dynarray_init(&profile->threads[i].events, NULL);
+      util_dynarray_init(&profile->threads[i].variants, NULL);
+   }
+
+   return profile;
+}
+
+
+/**
+ * Called by the thread which begins rasterizing a scene, while the other
+ * threads wait for it.
+ */
+void
+lp_profile_begin_scene(struct lp_profile *profile)
+{
+   unsigned i;
+
+   for (i = 0; i < profile->num_threads; i++)
+      profile->threads[i].scene = profile->num_scenes;
+
+   profile->num_scenes++;
+}
+
+
+static boolean
+cmd_shades(unsigned cmd)
+{
+   switch (cmd) {
+   case LP_RAST_OP_CLEAR_COLOR:
+   case LP_RAST_OP_CLEAR_ZSTENCIL:
+   case LP_RAST_OP_BEGIN_QUERY:
+   case LP_RAST_OP_END_QUERY:
+   case LP_RAST_OP_SET_STATE:
+      return FALSE;
+   default:
+      return TRUE;
+   }
+}
+
+
+static struct lp_profile_variant *
+find_variant(struct lp_profile_thread *thread,
+             unsigned fs, unsigned fs_variant)
+{
+   unsigned num_variants =
+      util_dynarray_num_elements(&thread->variants, struct lp_profile_variant);
+   struct lp_profile_variant *v;
+   unsigned i;
+
+   /* Consecutive commands mostly use the same variant. */
+   if (thread->last_variant < num_variants) {
+      v = util_dynarray_element(&thread->variants, struct lp_profile_variant,
+                                thread->last_variant);
+      if (v->fs == fs && v->fs_variant == fs_variant)
+         return v;
+   }
+
+   for (i = 0; i < num_variants; i++) {
+      v = util_dynarray_element(&thread->variants, struct lp_profile_variant, i);
+      if (v->fs == fs && v->fs_variant == fs_variant) {
+         thread->last_variant = i;
+         return v;
+      }
+   }
+
+   v = util_dynarray_grow(&thread->variants, struct lp_profile_variant, 1);
+   if (!v)
+      return NULL;
+
+   memset(v, 0, sizeof *v);
+   v->fs = fs;
+   v->fs_variant = fs_variant;
+   thread->last_variant = num_variants;
+   return v;
+}
+
+
+/**
+ * Account for a scene, bin or command executed by a rasterizer thread.
+ * \param state  the rasterizer state in effect, for commands
+ */
+void
+lp_profile_record(struct lp_profile_thread *thread,
+                  enum lp_profile_event_type type,
+                  int64_t start, int64_t end,
+                  unsigned cmd, unsigned x, unsigned y,
+                  const struct lp_rast_state *state)
+{
+   const struct lp_fragment_shader_variant *variant = NULL;
+   struct lp_profile_total *total;
+   struct lp_profile_event *event;
+
+   switch (type) {
+   case LP_PROFILE_SCENE:
+      total = &thread->scenes;
+      break;
+   case LP_PROFILE_BIN:
+      total = &thread->bins;
+      break;
+   default:
+      total = &thread->cmds[cmd];
+      if (state && cmd_shades(cmd))
+         variant = state->variant;
+      break;
+   }
+
+   total->time += end - start;
+   total->count++;
+
+   if (variant) {
+      struct lp_profile_variant *v =
+         find_variant(thread, variant->shader->no, variant->no);
+      if (v) {
+         v->total.time += end - start;
+         v->total.count++;
+      }
+   }
+
+   if (util_dynarray_num_elements(&thread->events, struct lp_profile_event) >=
+       LP_PROFILE_MAX_EVENTS) {
+      thread->dropped_events++;
+      return;
+   }
+
+   event = util_dynarray_grow(&thread->events, struct lp_profile_event, 1);
+   if (!event) {
+      thread->dropped_events++;
+      return;
+   }
+
+   event->start = start;
+   event->end = end;
+   event->scene = thread->scene;
+   event->type = type;
+   event->cmd = cmd;
+   event->x = x;
+   event->y = y;
+   event->fs = variant ? variant->shader->no : ~0u;
+   event->fs_variant = variant ? variant->no : ~0u;
+}
+
+
+static double
+to_us(const struct lp_profile *profile, int64_t t)
+{
+   return (t - profile->start_time) / 1000.0;
+}
+
+
+static void
+write_trace(const struct lp_profile *profile, FILE *f)
+{
+   const char *sep = "";
+   unsigned i;
+
+   fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+   for (i = 0; i < profile->num_threads; i++) {
+      const struct lp_profile_thread *thread = &profile->threads[i];
+
+      fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+              "\"tid\":%u,\"args\":{\"name\":\"llvmpipe-%u\"}}",
+              sep, i, i);
+      sep = ",\n";
+
+      util_dynarray_foreach(&thread->events, struct lp_profile_event, event) {
+         fprintf(f, "%s{\"ph\":\"X\",\"pid\":0,\"tid\":%u,"
+                 "\"ts\":%.3f,\"dur\":%.3f,",
+                 sep, i, to_us(profile, event->start),
+                 (event->end - event->start) / 1000.0);
+
+         switch (event->type) {
+         case LP_PROFILE_SCENE:
+            fprintf(f, "\"name\":\"scene %u\",\"cat\":\"scene\"}",
+                    event->scene);
+            break;
+         case LP_PROFILE_BIN:
+            fprintf(f, "\"name\":\"bin %u,%u\",\"cat\":\"bin\","
+                    "\"args\":{\"scene\":%u}}",
+                    event->x, event->y, event->scene);
+            break;
+         default:
+            fprintf(f, "\"name\":\"%s\",\"cat\":\"cmd\","
+                    "\"args\":{\"scene\":%u,\"bin\":\"%u,%u\"",
+                    lp_rast_cmd_name(event->cmd), event->scene,
+                    event->x, event->y);
+            if (event->fs != ~0u)
+               fprintf(f, ",\"fs\":\"fs%u_variant%u\"",
+                       event->fs, event->fs_variant);
+            fprintf(f, "}}");
+            break;
+         }
+      }
+   }
+
+   fprintf(f, "\n]}\n");
+}
+
+
+static int
+compare_variants(const void *a, const void *b)
+{
+   const struct lp_profile_variant *va = a, *vb = b;
+
+   if (va->total.time != vb->total.time)
+      return va->total.time < vb->total.time ? 1 : -1;
+   return 0;
+}
+
+
+static void
+print_total(const char *name, const struct lp_profile_total *total,
+            int64_t all_time)
+{
+   debug_printf("llvmpipe:   %-24s %10" PRIu64 " %10.2f %9.2f %5.1f%%\n",
+                name, total->count, total->time / 1000000.0,
+                total->count ? total->time / 1000.0 / total->count : 0.0,
+                all_time ? 100.0 * total->time / all_time : 0.0);
+}
+
+
+static void
+print_summary(const struct lp_profile *profile)
+{
+   struct lp_profile_total cmds[LP_RAST_OP_MAX];
+   struct util_dynarray variants;
+   int64_t cmd_time = 0;
+   unsigned dropped_events = 0;
+   unsigned num_variants;
+   unsigned i, j;
+
+   memset(cmds, 0, sizeof cmds);
+   util_dynarray_init(&variants, NULL);
+
+   for (i = 0; i < profile->num_threads; i++) {
+      const struct lp_profile_thread *thread = &profile->threads[i];
+
+      for (j = 0; j < LP_RAST_OP_MAX; j++) {
+         cmds[j].time += thread->cmds[j].time;
+         cmds[j].count += thread->cmds[j].count;
+         cmd_time += thread->cmds[j].time;
+      }
+
+      util_dynarray_foreach(&thread->variants, struct lp_profile_variant, tv) {
+         struct lp_profile_variant *v = NULL;
+
+         util_dynarray_foreach(&variants, struct lp_profile_variant, mv) {
+            if (mv->fs == tv->fs && mv->fs_variant == tv->fs_variant) {
+               v = mv;
+               break;
+            }
+         }
+         if (!v) {
+            v = util_dynarray_grow(&variants, struct lp_profile_variant, 1);
+            if (!v)
+               continue;
+            *v = *tv;
+         } else {
+            v->total.time += tv->total.time;
+            v->total.count += tv->total.count;
+         }
+      }
+
+      dropped_events += thread->dropped_events;
+   }
+
+   debug_printf("llvmpipe: profiled %u scenes on %u threads, trace in %s",
+                profile->num_scenes, profile->num_threads, profile->filename);
+   if (dropped_events)
+      debug_printf(" (%u events dropped)", dropped_events);
+   debug_printf("\n");
+
+   debug_printf("llvmpipe:   %-24s %10s %10s %9s %6s\n",
+                "command", "count", "total ms", "avg us", "time");
+   for (i = 0; i < LP_RAST_OP_MAX; i++) {
+      if (cmds[i].count)
+         print_total(lp_rast_cmd_name(i), &cmds[i], cmd_time);
+   }
+
+   num_variants =
+      util_dynarray_num_elements(&variants, struct lp_profile_variant);
+   if (num_variants) {
+      qsort(variants.data, num_variants, sizeof(struct lp_profile_variant),
+            compare_variants);
+
+      debug_printf("llvmpipe:   %-24s %10s %10s %9s %6s\n",
+                   "fs variant", "commands", "total ms", "avg us", "time");
+      for (i = 0; i < MIN2(num_variants, LP_PROFILE_MAX_VARIANTS); i++) {
+         const struct lp_profile_variant *v =
+            util_dynarray_element(&variants, struct lp_profile_variant, i);
+         char name[32];
+
+         snprintf(name, sizeof name, "fs%u_variant%u", v->fs, v->fs_variant);
+         print_total(name, &v->total, cmd_time);
+      }
+   }
+
+   debug_printf("llvmpipe:   %-24s %10s %10s %9s %6s\n",
+                "thread", "bins", "bins ms", "scenes ms", "busy");
+   for (i = 0; i < profile->num_threads; i++) {
+      const struct lp_profile_thread *thread = &profile->threads[i];
+      char name[32];
+
+      snprintf(name, sizeof name, "llvmpipe-%u", i);
+      debug_printf("llvmpipe:   %-24s %10" PRIu64 " %10.2f %9.2f %5.1f%%\n",
+                   name, thread->bins.count, thread->bins.time / 1000000.0,
+                   thread->scenes.time / 1000000.0,
+                   thread->scenes.time ?
+                   100.0 * thread->bins.time / thread->scenes.time : 0.0);
+   }
+
+   util_dynarray_fini(&variants);
+}
+
+
+/**
+ * Write out the trace and print the summary.
+ */
+void
+lp_profile_destroy(struct lp_profile *profile)
+{
+   FILE *f;
+   unsigned i;
+
+   f = fopen(profile->filename, "w");
+   if (f) {
+      write_trace(profile, f);
+      fclose(f);
+   }
+   else {
+      debug_printf("llvmpipe: couldn't open %s for writing\n",
+                   profile->filename);
+   }
+
+   print_summary(profile);
+
+   for (i = 0; i < profile->num_threads; i++) {
+      util_dynarray_fini(&profile->threads[i].events);
+      util_dynarray_fini(&profile->threads[i].variants);
+   }
+   FREE(profile->threads);
+   free(profile->filename);
+   FREE(profile);
+}
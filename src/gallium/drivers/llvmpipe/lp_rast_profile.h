@@ -0,0 +1,128 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Profiling of scene rasterization, enabled with LP_PROFILE=<file>.
+ *
+ * Each rasterizer thread timestamps the scenes, bins and commands it
+ * executes into its own lp_profile_thread, so recording takes no locks.
+ * When the rasterizer is destroyed the events are written to <file> in the
+ * Chrome trace event format (load it in chrome://tracing or Perfetto), and
+ * a summary of the time spent per command, fragment shader variant and
+ * thread is printed.
+ */
+
+#ifndef LP_RAST_PROFILE_H
+#define LP_RAST_PROFILE_H
+
+#include "pipe/p_compiler.h"
+#include "util/u_dynarray.h"
+#include "lp_rast.h"
+
+
+struct lp_rast_state;
+
+
+enum lp_profile_event_type
+{
+   LP_PROFILE_SCENE,
+   LP_PROFILE_BIN,
+   LP_PROFILE_CMD,
+};
+
+
+struct lp_profile_event
+{
+   int64_t start, end;      /**< os_time_get_nano() */
+   unsigned scene;
+   uint8_t type;            /**< enum lp_profile_event_type */
+   uint8_t cmd;             /**< LP_RAST_OP_x, for LP_PROFILE_CMD */
+   uint16_t x, y;           /**< bin position, in tiles */
+   unsigned fs, fs_variant; /**< shader/variant no. of shading commands */
+};
+
+
+/** Time spent on one kind of work */
+struct lp_profile_total
+{
+   int64_t time;
+   uint64_t count;
+};
+
+
+struct lp_profile_variant
+{
+   unsigned fs, fs_variant;
+   struct lp_profile_total total;
+};
+
+
+/** Only ever touched by its rasterizer thread, until the summary */
+struct lp_profile_thread
+{
+   /** lp_profile_event, up to LP_PROFILE_MAX_EVENTS */
+   struct util_dynarray events;
+   unsigned dropped_events;
+
+   unsigned scene;
+   struct lp_profile_total scenes;
+   struct lp_profile_total bins;
+   struct lp_profile_total cmds[LP_RAST_OP_MAX];
+
+   /** lp_profile_variant, and the index of the last one looked up */
+   struct util_dynarray variants;
+   unsigned last_variant;
+};
+
+
+struct lp_profile
+{
+   char *filename;
+   unsigned num_threads;
+   unsigned num_scenes;
+   int64_t start_time;
+   struct lp_profile_thread *threads;  /**< num_threads of them */
+};
+
+
+struct lp_profile *
+lp_profile_create(unsigned num_threads);
+
+void
+lp_profile_destroy(struct lp_profile *profile);
+
+void
+lp_profile_begin_scene(struct lp_profile *profile);
+
+void
+lp_profile_record(struct lp_profile_thread *thread,
+                  enum lp_profile_event_type type,
+                  int64_t start, int64_t end,
+                  unsigned cmd, unsigned x, unsigned y,
+                  const struct lp_rast_state *state);
+
+
+#endif /* LP_RAST_PROFILE_H */
@@ -35,34 +35,6 @@
 #include "lp_perf.h"
 #include "lp_rast_priv.h"
 
-/**
- * Shade all pixels in a 4x4 block.
- */
-static void
-block_full_4(struct lp_rasterizer_task *task,
-             const struct lp_rast_triangle *tri,
-             int x, int y)
-{
-   lp_rast_shade_quads_all(task, &tri->inputs, x, y);
-}
-
-
-/**
- * Shade all pixels in a 16x16 block.
- */
-static void
-block_full_16(struct lp_rasterizer_task *task,
-              const struct lp_rast_triangle *tri,
-              int x, int y)
-{
-   unsigned ix, iy;
-   assert(x % 16 == 0);
-   assert(y % 16 == 0);
-   for (iy = 0; iy < 16; iy += 4)
-      for (ix = 0; ix < 16; ix += 4)
-	 block_full_4(task, tri, x + ix, y + iy);
-}
-
 static inline unsigned
 build_mask_linear(int32_t c, int32_t dcdx, int32_t dcdy)
 {
@@ -710,6 +682,32 @@ lp_rast_triangle_32_3_4(struct lp_rasterizer_task *task,
 
 #endif
 
+
+/**
+ * Rasterize a run of small triangles binned together by
+ * lp_setup_bin_triangle().  Same as issuing a triangle_32_3_4 or
+ * triangle_32_3_16 command for each of them, minus the per-command
+ * dispatch.
+ */
+void
+lp_rast_small_triangles(struct lp_rasterizer_task *task,
+                        const union lp_rast_cmd_arg arg)
+{
+   const struct lp_rast_small_tris *small = arg.small_tris;
+   unsigned i;
+
+   for (i = 0; i < small->count; i++) {
+      const struct lp_rast_small_tri *st = &small->tri[i];
+      const union lp_rast_cmd_arg tri_arg =
+         lp_rast_arg_triangle_contained(st->tri, st->x, st->y);
+
+      if (st->size == 4)
+         lp_rast_triangle_32_3_4(task, tri_arg);
+      else
+         lp_rast_triangle_32_3_16(task, tri_arg);
+   }
+}
+
 #if defined PIPE_ARCH_SSE
 #define BUILD_MASKS(c, cdiff, dcdx, dcdy, omask, pmask) build_masks_sse((int)c, (int)cdiff, dcdx, dcdy, omask, pmask)
 #define BUILD_MASK_LINEAR(c, dcdx, dcdy) build_mask_linear_sse((int)c, dcdx, dcdy)
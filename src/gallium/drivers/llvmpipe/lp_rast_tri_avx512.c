@@ -0,0 +1,108 @@
+/**************************************************************************
+ *
+ * Copyright 2007-2009 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * AVX-512 variants of the binned triangle rasterizers.
+ *
+ * This file is built with -mavx512f; nothing in here may be called
+ * unless util_cpu_caps.has_avx512f is set.
+ */
+
+#if defined(USE_AVX512)
+
+#include <immintrin.h>
+#include <limits.h>
+#include "util/u_math.h"
+#include "lp_debug.h"
+#include "lp_perf.h"
+#include "lp_rast_priv.h"
+
+
+/**
+ * Evaluate the edge function over a whole 4x4 block in one register.
+ */
+static inline __m512i
+cstep_avx512(int c, int dcdx, int dcdy)
+{
+   __m128i row0 = _mm_setr_epi32(c, c+dcdx, c+dcdx*2, c+dcdx*3);
+   __m128i row1 = _mm_add_epi32(row0, _mm_set1_epi32(dcdy));
+   __m256i c01 = _mm256_inserti128_si256(_mm256_castsi128_si256(row0), row1, 1);
+   __m256i c23 = _mm256_add_epi32(c01, _mm256_set1_epi32(dcdy * 2));
+
+   return _mm512_inserti64x4(_mm512_castsi256_si512(c01), c23, 1);
+}
+
+
+static inline void
+build_masks_avx512(int c,
+                   int cdiff,
+                   int dcdx,
+                   int dcdy,
+                   unsigned *outmask,
+                   unsigned *partmask)
+{
+   __m512i cstep = cstep_avx512(c, dcdx, dcdy);
+   __m512i zero = _mm512_setzero_si512();
+
+   *outmask |= _mm512_cmplt_epi32_mask(cstep, zero);
+   *partmask |= _mm512_cmplt_epi32_mask(
+      _mm512_add_epi32(cstep, _mm512_set1_epi32(cdiff)), zero);
+}
+
+
+static inline unsigned
+build_mask_linear_avx512(int c, int dcdx, int dcdy)
+{
+   return _mm512_cmplt_epi32_mask(cstep_avx512(c, dcdx, dcdy),
+                                  _mm512_setzero_si512());
+}
+
+
+/*
+ * Out of line entry points, for lp_test_rast_tri.
+ */
+void
+lp_rast_build_masks_avx512(int c, int cdiff, int dcdx, int dcdy,
+                           unsigned *outmask, unsigned *partmask)
+{
+   build_masks_avx512(c, cdiff, dcdx, dcdy, outmask, partmask);
+}
+
+unsigned
+lp_rast_build_mask_linear_avx512(int c, int dcdx, int dcdy)
+{
+   return build_mask_linear_avx512(c, dcdx, dcdy);
+}
+
+
+#define BUILD_MASKS(c, cdiff, dcdx, dcdy, omask, pmask) build_masks_avx512((int)c, (int)cdiff, dcdx, dcdy, omask, pmask)
+#define BUILD_MASK_LINEAR(c, dcdx, dcdy) build_mask_linear_avx512((int)c, dcdx, dcdy)
+
+#define ISA_TAG(x) x##_avx512
+#include "lp_rast_tri_isa_tmp.h"
+
+#endif /* USE_AVX512 */
@@ -0,0 +1,202 @@
+/**************************************************************************
+ *
+ * Copyright 2007-2010 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Instantiates the binned triangle rasterizers of lp_rast_tri_tmp.h for
+ * one instruction set, plus a function installing them in the
+ * rasterizer dispatch table.
+ *
+ * The including file must define:
+ *
+ *   ISA_TAG(x)                  -- suffix appended to every symbol
+ *   BUILD_MASKS(...)            -- as in lp_rast_tri.c
+ *   BUILD_MASK_LINEAR(...)      -- as in lp_rast_tri.c
+ */
+
+#ifndef ISA_TAG
+#error "ISA_TAG must be defined"
+#endif
+
+
+#define ISA_TRI_PROTO(n)                                                  \
+   void ISA_TAG(lp_rast_triangle_##n)(struct lp_rasterizer_task *,        \
+                                      const union lp_rast_cmd_arg);
+
+ISA_TRI_PROTO(1) ISA_TRI_PROTO(2) ISA_TRI_PROTO(3) ISA_TRI_PROTO(4)
+ISA_TRI_PROTO(5) ISA_TRI_PROTO(6) ISA_TRI_PROTO(7) ISA_TRI_PROTO(8)
+ISA_TRI_PROTO(32_1) ISA_TRI_PROTO(32_2) ISA_TRI_PROTO(32_3)
+ISA_TRI_PROTO(32_4) ISA_TRI_PROTO(32_5) ISA_TRI_PROTO(32_6)
+ISA_TRI_PROTO(32_7) ISA_TRI_PROTO(32_8)
+ISA_TRI_PROTO(ms_1) ISA_TRI_PROTO(ms_2) ISA_TRI_PROTO(ms_3)
+ISA_TRI_PROTO(ms_4) ISA_TRI_PROTO(ms_5) ISA_TRI_PROTO(ms_6)
+ISA_TRI_PROTO(ms_7) ISA_TRI_PROTO(ms_8)
+
+#undef ISA_TRI_PROTO
+
+
+#define RASTER_64 1
+
+#define TAG(x) ISA_TAG(x##_1)
+#define NR_PLANES 1
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_2)
+#define NR_PLANES 2
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_3)
+#define NR_PLANES 3
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_4)
+#define NR_PLANES 4
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_5)
+#define NR_PLANES 5
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_6)
+#define NR_PLANES 6
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_7)
+#define NR_PLANES 7
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_8)
+#define NR_PLANES 8
+#include "lp_rast_tri_tmp.h"
+
+#undef RASTER_64
+
+#define TAG(x) ISA_TAG(x##_32_1)
+#define NR_PLANES 1
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_32_2)
+#define NR_PLANES 2
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_32_3)
+#define NR_PLANES 3
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_32_4)
+#define NR_PLANES 4
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_32_5)
+#define NR_PLANES 5
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_32_6)
+#define NR_PLANES 6
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_32_7)
+#define NR_PLANES 7
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_32_8)
+#define NR_PLANES 8
+#include "lp_rast_tri_tmp.h"
+
+#define MULTISAMPLE 1
+#define RASTER_64 1
+
+#define TAG(x) ISA_TAG(x##_ms_1)
+#define NR_PLANES 1
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_ms_2)
+#define NR_PLANES 2
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_ms_3)
+#define NR_PLANES 3
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_ms_4)
+#define NR_PLANES 4
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_ms_5)
+#define NR_PLANES 5
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_ms_6)
+#define NR_PLANES 6
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_ms_7)
+#define NR_PLANES 7
+#include "lp_rast_tri_tmp.h"
+
+#define TAG(x) ISA_TAG(x##_ms_8)
+#define NR_PLANES 8
+#include "lp_rast_tri_tmp.h"
+
+#undef RASTER_64
+#undef MULTISAMPLE
+
+
+/**
+ * Replace the generic triangle rasterizers in the dispatch table with
+ * the ones built above.  The specialized 3/4 plane SSE paths
+ * (lp_rast_triangle_*_3_4 etc) are left alone.
+ */
+void
+ISA_TAG(lp_rast_triangle_init)(lp_rast_cmd_func *dispatch)
+{
+   dispatch[LP_RAST_OP_TRIANGLE_1] = ISA_TAG(lp_rast_triangle_1);
+   dispatch[LP_RAST_OP_TRIANGLE_2] = ISA_TAG(lp_rast_triangle_2);
+   dispatch[LP_RAST_OP_TRIANGLE_3] = ISA_TAG(lp_rast_triangle_3);
+   dispatch[LP_RAST_OP_TRIANGLE_4] = ISA_TAG(lp_rast_triangle_4);
+   dispatch[LP_RAST_OP_TRIANGLE_5] = ISA_TAG(lp_rast_triangle_5);
+   dispatch[LP_RAST_OP_TRIANGLE_6] = ISA_TAG(lp_rast_triangle_6);
+   dispatch[LP_RAST_OP_TRIANGLE_7] = ISA_TAG(lp_rast_triangle_7);
+   dispatch[LP_RAST_OP_TRIANGLE_8] = ISA_TAG(lp_rast_triangle_8);
+
+   dispatch[LP_RAST_OP_TRIANGLE_32_1] = ISA_TAG(lp_rast_triangle_32_1);
+   dispatch[LP_RAST_OP_TRIANGLE_32_2] = ISA_TAG(lp_rast_triangle_32_2);
+   dispatch[LP_RAST_OP_TRIANGLE_32_3] = ISA_TAG(lp_rast_triangle_32_3);
+   dispatch[LP_RAST_OP_TRIANGLE_32_4] = ISA_TAG(lp_rast_triangle_32_4);
+   dispatch[LP_RAST_OP_TRIANGLE_32_5] = ISA_TAG(lp_rast_triangle_32_5);
+   dispatch[LP_RAST_OP_TRIANGLE_32_6] = ISA_TAG(lp_rast_triangle_32_6);
+   dispatch[LP_RAST_OP_TRIANGLE_32_7] = ISA_TAG(lp_rast_triangle_32_7);
+   dispatch[LP_RAST_OP_TRIANGLE_32_8] = ISA_TAG(lp_rast_triangle_32_8);
+
+   dispatch[LP_RAST_OP_MS_TRIANGLE_1] = ISA_TAG(lp_rast_triangle_ms_1);
+   dispatch[LP_RAST_OP_MS_TRIANGLE_2] = ISA_TAG(lp_rast_triangle_ms_2);
+   dispatch[LP_RAST_OP_MS_TRIANGLE_3] = ISA_TAG(lp_rast_triangle_ms_3);
+   dispatch[LP_RAST_OP_MS_TRIANGLE_4] = ISA_TAG(lp_rast_triangle_ms_4);
+   dispatch[LP_RAST_OP_MS_TRIANGLE_5] = ISA_TAG(lp_rast_triangle_ms_5);
+   dispatch[LP_RAST_OP_MS_TRIANGLE_6] = ISA_TAG(lp_rast_triangle_ms_6);
+   dispatch[LP_RAST_OP_MS_TRIANGLE_7] = ISA_TAG(lp_rast_triangle_ms_7);
+   dispatch[LP_RAST_OP_MS_TRIANGLE_8] = ISA_TAG(lp_rast_triangle_ms_8);
+}
@@ -32,6 +32,8 @@
 #include "util/simple_list.h"
 #include "util/format/u_format.h"
 #include "lp_scene.h"
+#include "lp_scene_pool.h"
+#include "lp_screen.h"
 #include "lp_fence.h"
 #include "lp_debug.h"
 
@@ -41,6 +43,7 @@
 /** List of resource references */
 struct resource_ref {
    struct pipe_resource *resource[RESOURCE_REF_SZ];
+   uint8_t writable[RESOURCE_REF_SZ];
    int count;
    struct resource_ref *next;
 };
@@ -58,11 +61,13 @@ lp_scene_create( struct pipe_context *pipe )
       return NULL;
 
    scene->pipe = pipe;
+   scene->pool = &llvmpipe_screen(pipe->screen)->scene_pool;
 
-   scene->data.head =
-      CALLOC_STRUCT(data_block);
-
-   (void) mtx_init(&scene->mutex, mtx_plain);
+   scene->data.head = lp_scene_pool_get(scene->pool);
+   if (!scene->data.head) {
+      FREE(scene);
+      return NULL;
+   }
 
 #ifdef DEBUG
    /* Do some scene limit sanity checks here */
@@ -83,6 +88,28 @@ lp_scene_create( struct pipe_context *pipe )
 }
 
 
+/**
+ * Create a scene which a binner thread bins part of a draw into.  It has
+ * no data block of its own to begin with: the static one is marked as
+ * full, so that every block the binner allocates can later be handed
+ * over to the real scene by lp_scene_merge_bins().
+ */
+struct lp_scene *
+lp_scene_create_binner( struct pipe_context *pipe )
+{
+   struct lp_scene *scene = CALLOC_STRUCT(lp_scene);
+   if (!scene)
+      return NULL;
+
+   scene->pipe = pipe;
+   scene->pool = &llvmpipe_screen(pipe->screen)->scene_pool;
+   scene->data.first.used = DATA_BLOCK_SIZE;
+   scene->data.head = &scene->data.first;
+
+   return scene;
+}
+
+
 /**
  * Free all data associated with the given scene, and the scene itself.
  */
@@ -90,9 +117,12 @@ void
 lp_scene_destroy(struct lp_scene *scene)
 {
    lp_fence_reference(&scene->fence, NULL);
-   mtx_destroy(&scene->mutex);
-   assert(scene->data.head->next == NULL);
-   FREE(scene->data.head);
+   if (scene->data.head != &scene->data.first) {
+      assert(scene->data.head->next == NULL);
+      lp_scene_pool_put(scene->pool, scene->data.head);
+   }
+   FREE(scene->bin_order);
+   FREE(scene->bin_queue);
    FREE(scene);
 }
 
@@ -211,12 +241,13 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
 
 
 /**
- * Free all the temporary data in a scene.
+ * Unmap the framebuffer surfaces.  Called by the rasterizer once all its
+ * threads are done with the scene, just before signalling its fence.
  */
 void
 lp_scene_end_rasterization(struct lp_scene *scene )
 {
-   int i, j;
+   int i;
 
    /* Unmap color buffers */
    for (i = 0; i < scene->fb.nr_cbufs; i++) {
@@ -239,6 +270,18 @@ lp_scene_end_rasterization(struct lp_scene *scene )
                               zsbuf->u.tex.first_layer);
       scene->zsbuf.map = NULL;
    }
+}
+
+
+/**
+ * Free all the temporary data in a scene, so that it can be binned into
+ * again.  Called by the setup module, after the scene's fence signalled
+ * (or when binning of it failed).
+ */
+void
+lp_scene_reset(struct lp_scene *scene)
+{
+   int i, j;
 
    /* Reset all command lists:
     */
@@ -281,16 +324,12 @@ lp_scene_end_rasterization(struct lp_scene *scene )
                       j, scene->resource_reference_size);
    }
 
-   /* Free all scene data blocks:
+   /* Return all scene data blocks but the current one to the pool:
     */
    {
       struct data_block_list *list = &scene->data;
-      struct data_block *block, *tmp;
 
-      for (block = list->head->next; block; block = tmp) {
-         tmp = block->next;
-	 FREE(block);
-      }
+      lp_scene_pool_put(scene->pool, list->head->next);
 
       list->head->next = NULL;
       list->head->used = 0;
@@ -334,6 +373,105 @@ lp_scene_new_cmd_block( struct lp_scene *scene,
 }
 
 
+/**
+ * Prepare a binner scene to take part of the draws binned into 'scene'.
+ * The binner may allocate up to 'max_size' bytes of bin data.
+ */
+void
+lp_scene_begin_binner(struct lp_scene *binner,
+                      const struct lp_scene *scene,
+                      unsigned max_size)
+{
+   assert(binner->data.head == &binner->data.first);
+
+   binner->tiles_x = scene->tiles_x;
+   binner->tiles_y = scene->tiles_y;
+   /* Only checked for being non-null, so not referenced */
+   binner->fb.zsbuf = scene->fb.zsbuf;
+   binner->fb_max_layer = scene->fb_max_layer;
+   binner->had_queries = scene->had_queries;
+   binner->scene_size = LP_SCENE_MAX_SIZE - MIN2(max_size, LP_SCENE_MAX_SIZE);
+   binner->alloc_failed = FALSE;
+}
+
+
+/**
+ * Append the commands of each of the binner's bins to the scene's bin
+ * for the same tile, and hand over the data blocks they live in.  This
+ * leaves the binner empty.
+ */
+void
+lp_scene_merge_bins(struct lp_scene *scene, struct lp_scene *binner)
+{
+   struct data_block *block, *next;
+   unsigned x, y;
+
+   for (y = 0; y < binner->tiles_y; y++) {
+      for (x = 0; x < binner->tiles_x; x++) {
+         struct cmd_bin *bin = lp_scene_get_bin(scene, x, y);
+         struct cmd_bin *src = lp_scene_get_bin(binner, x, y);
+
+         if (!src->head)
+            continue;
+
+         if (bin->tail)
+            bin->tail->next = src->head;
+         else
+            bin->head = src->head;
+         bin->tail = src->tail;
+         bin->last_state = src->last_state;
+
+         src->head = NULL;
+         src->tail = NULL;
+         src->last_state = NULL;
+      }
+   }
+
+   /* Keep the scene's current block at the head of its list so that it
+    * keeps filling it up.
+    */
+   for (block = binner->data.head; block != &binner->data.first; block = next) {
+      next = block->next;
+      block->next = scene->data.head->next;
+      scene->data.head->next = block;
+      scene->scene_size += sizeof *block;
+   }
+
+   binner->data.head = &binner->data.first;
+   binner->fb.zsbuf = NULL;
+}
+
+
+/**
+ * Throw away everything binned into a binner scene.
+ */
+void
+lp_scene_discard_bins(struct lp_scene *binner)
+{
+   struct data_block *block, *next, *blocks = NULL;
+   unsigned x, y;
+
+   for (y = 0; y < binner->tiles_y; y++) {
+      for (x = 0; x < binner->tiles_x; x++) {
+         struct cmd_bin *bin = lp_scene_get_bin(binner, x, y);
+         bin->head = NULL;
+         bin->tail = NULL;
+         bin->last_state = NULL;
+      }
+   }
+
+   for (block = binner->data.head; block != &binner->data.first; block = next) {
+      next = block->next;
+      block->next = blocks;
+      blocks = block;
+   }
+   lp_scene_pool_put(binner->pool, blocks);
+
+   binner->data.head = &binner->data.first;
+   binner->fb.zsbuf = NULL;
+}
+
+
 struct data_block *
 lp_scene_new_data_block( struct lp_scene *scene )
 {
@@ -343,13 +481,12 @@ lp_scene_new_data_block( struct lp_scene *scene )
       return NULL;
    }
    else {
-      struct data_block *block = MALLOC_STRUCT(data_block);
+      struct data_block *block = lp_scene_pool_get(scene->pool);
       if (!block)
          return NULL;
       
       scene->scene_size += sizeof *block;
 
-      block->used = 0;
       block->next = scene->data.head;
       scene->data.head = block;
 
@@ -381,6 +518,7 @@ lp_scene_data_size( const struct lp_scene *scene )
 boolean
 lp_scene_add_resource_reference(struct lp_scene *scene,
                                 struct pipe_resource *resource,
+                                boolean writable,
                                 boolean initializing_scene)
 {
    struct resource_ref *ref, **last = &scene->resources;
@@ -393,9 +531,12 @@ lp_scene_add_resource_reference(struct lp_scene *scene,
 
       /* Search for this resource:
        */
-      for (i = 0; i < ref->count; i++)
-         if (ref->resource[i] == resource)
+      for (i = 0; i < ref->count; i++) {
+         if (ref->resource[i] == resource) {
+            ref->writable[i] |= writable;
             return TRUE;
+         }
+      }
 
       if (ref->count < RESOURCE_REF_SZ) {
          /* If the block is half-empty, then append the reference here.
@@ -418,6 +559,7 @@ lp_scene_add_resource_reference(struct lp_scene *scene,
 
    /* Append the reference to the reference block.
     */
+   ref->writable[ref->count] = writable;
    pipe_resource_reference(&ref->resource[ref->count++], resource);
    scene->resource_reference_size += llvmpipe_resource_size(resource);
 
@@ -436,81 +578,208 @@ lp_scene_add_resource_reference(struct lp_scene *scene,
 
 /**
  * Does this scene have a reference to the given resource?
+ * \return  LP_REFERENCED_FOR_READ/WRITE flags.  The framebuffer surfaces
+ *          count as written to, other resources only if they were added
+ *          as writable (shader buffers and images).
  */
-boolean
+unsigned
 lp_scene_is_resource_referenced(const struct lp_scene *scene,
                                 const struct pipe_resource *resource)
 {
    const struct resource_ref *ref;
+   unsigned referenced = LP_UNREFERENCED;
    int i;
 
+   for (i = 0; i < scene->fb.nr_cbufs; i++) {
+      if (scene->fb.cbufs[i] && scene->fb.cbufs[i]->texture == resource)
+         return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
+   }
+   if (scene->fb.zsbuf && scene->fb.zsbuf->texture == resource)
+      return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
+
    for (ref = scene->resources; ref; ref = ref->next) {
-      for (i = 0; i < ref->count; i++)
-         if (ref->resource[i] == resource)
-            return TRUE;
+      for (i = 0; i < ref->count; i++) {
+         if (ref->resource[i] == resource) {
+            referenced |= LP_REFERENCED_FOR_READ;
+            if (ref->writable[i])
+               referenced |= LP_REFERENCED_FOR_WRITE;
+            return referenced;
+         }
+      }
    }
 
-   return FALSE;
+   return referenced;
 }
 
 
 
 
-/** advance curr_x,y to the next bin */
-static boolean
-next_bin(struct lp_scene *scene)
+/**
+ * Estimate the cost of rasterizing a bin from the number of commands
+ * binned into it.
+ */
+static unsigned
+bin_cost(const struct cmd_bin *bin)
 {
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
-   }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return FALSE;
+   const struct cmd_block *block;
+   unsigned cost = 0;
+
+   for (block = bin->head; block; block = block->next) {
+      unsigned k;
+
+      cost += block->count;
+
+      /* count each packed small triangle as a command of its own */
+      for (k = 0; k < block->count; k++) {
+         if (block->cmd[k] == LP_RAST_OP_SMALL_TRIANGLES)
+            cost += block->arg[k].small_tris->count - 1;
+      }
    }
-   return TRUE;
+
+   return cost;
+}
+
+
+static int
+compare_bin_cost(const void *a, const void *b)
+{
+   uint64_t ka = *(const uint64_t *)a;
+   uint64_t kb = *(const uint64_t *)b;
+
+   /* decreasing cost, then raster order */
+   if ((ka >> 32) != (kb >> 32))
+      return (ka >> 32) < (kb >> 32) ? 1 : -1;
+   return ka < kb ? -1 : ka > kb;
 }
 
 
+/**
+ * Prepare the per-thread bin queues for rasterization.
+ *
+ * The non-empty bins are split, in raster order, into one band per
+ * thread of roughly equal total cost, so the threads start out in
+ * separate regions of the screen.  Within each band the most expensive
+ * bins go first, leaving cheap ones at the end for stealing.
+ *
+ * Called once per scene, before any thread calls lp_scene_bin_iter_next().
+ */
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene )
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads )
 {
-   scene->curr_x = scene->curr_y = -1;
+   unsigned num_queues = MAX2(1, num_threads);
+   unsigned num_bins = lp_scene_get_num_bins(scene);
+   uint64_t total_cost = 0, band_cost = 0;
+   unsigned count = 0;
+   unsigned start, q, x, y, i;
+
+   if (scene->bin_queue_size < num_queues) {
+      FREE(scene->bin_queue);
+      scene->bin_queue = MALLOC(num_queues * sizeof *scene->bin_queue);
+      scene->bin_queue_size = scene->bin_queue ? num_queues : 0;
+   }
+
+   if (scene->bin_order_size < num_bins) {
+      FREE(scene->bin_order);
+      scene->bin_order = MALLOC(num_bins * sizeof *scene->bin_order);
+      scene->bin_order_size = scene->bin_order ? num_bins : 0;
+   }
+
+   if (!scene->bin_order || !scene->bin_queue) {
+      /* Hand out all the bins in raster order from a single queue. */
+      scene->num_bin_queues = 0;
+      scene->raster_order_queue.next = 0;
+      scene->raster_order_queue.end = num_bins;
+      return;
+   }
+
+   for (y = 0; y < scene->tiles_y; y++) {
+      for (x = 0; x < scene->tiles_x; x++) {
+         const struct cmd_bin *bin = lp_scene_get_bin(scene, x, y);
+         if (bin->head) {
+            uint64_t cost = bin_cost(bin);
+            scene->bin_order[count++] = (cost << 32) | (y << 16) | x;
+            total_cost += cost;
+         }
+      }
+   }
+
+   num_queues = MIN2(num_queues, MAX2(count, 1));
+
+   /* Cut the bins into bands of about total_cost / num_queues each. */
+   start = 0;
+   q = 0;
+   for (i = 0; i < count; i++) {
+      band_cost += scene->bin_order[i] >> 32;
+      if (q < num_queues - 1 &&
+          band_cost * num_queues >= total_cost * (q + 1)) {
+         scene->bin_queue[q].next = start;
+         scene->bin_queue[q].end = i + 1;
+         start = i + 1;
+         q++;
+      }
+   }
+   for (; q < num_queues; q++) {
+      scene->bin_queue[q].next = start;
+      scene->bin_queue[q].end = count;
+      start = count;
+   }
+
+   for (q = 0; q < num_queues; q++) {
+      struct lp_scene_bin_queue *queue = &scene->bin_queue[q];
+      if (queue->end - queue->next > 1)
+         qsort(&scene->bin_order[queue->next], queue->end - queue->next,
+               sizeof scene->bin_order[0], compare_bin_cost);
+   }
+
+   scene->num_bin_queues = num_queues;
 }
 
 
 /**
- * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
+ * Return pointer to next bin to be rendered by the given thread.
  * Multiple rendering threads will call this function to get a chunk
- * of work (a bin) to work on.
+ * of work (a bin) to work on.  Threads take bins from their own queue
+ * first, and then steal from the other threads' queues.
  */
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene , int *x, int *y)
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned thread_index,
+                        int *x, int *y)
 {
-   struct cmd_bin *bin = NULL;
+   unsigned num_queues = scene->num_bin_queues;
+   unsigned i;
 
-   mtx_lock(&scene->mutex);
+   if (!num_queues) {
+      struct lp_scene_bin_queue *queue = &scene->raster_order_queue;
+      unsigned slot = p_atomic_inc_return(&queue->next) - 1;
 
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
-   }
-   else if (!next_bin(scene)) {
-      /* no more bins left */
-      goto end;
+      if (slot >= queue->end)
+         return NULL;
+
+      *x = slot % scene->tiles_x;
+      *y = slot / scene->tiles_x;
+      return lp_scene_get_bin(scene, *x, *y);
    }
 
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
+   for (i = 0; i < num_queues; i++) {
+      struct lp_scene_bin_queue *queue =
+         &scene->bin_queue[(thread_index + i) % num_queues];
+      unsigned slot;
+      uint64_t pos;
+
+      if ((unsigned)p_atomic_read(&queue->next) >= queue->end)
+         continue;
+
+      slot = p_atomic_inc_return(&queue->next) - 1;
+      if (slot >= queue->end)
+         continue;
+
+      pos = scene->bin_order[slot];
+      *x = pos & 0xffff;
+      *y = (pos >> 16) & 0xffff;
+      return lp_scene_get_bin(scene, *x, *y);
+   }
 
-end:
-   /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
-   mtx_unlock(&scene->mutex);
-   return bin;
+   return NULL;
 }
 
 
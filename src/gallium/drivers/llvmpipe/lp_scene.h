@@ -40,6 +40,7 @@
 #include "lp_debug.h"
 
 struct lp_scene_queue;
+struct lp_scene_pool;
 struct lp_rast_state;
 
 /* We're limited to 2K by 2K for 32bit fixed point rasterization.
@@ -108,7 +109,8 @@ struct cmd_bin {
  * the per-tile bins will point to chunks of data in this structure.
  *
  * Include the first block of data statically to ensure we can always
- * initiate a scene without relying on malloc succeeding.
+ * initiate a scene without relying on malloc succeeding.  Binner scenes
+ * (see lp_scene_create_binner()) use it as an always-full sentinel.
  */
 struct data_block_list {
    struct data_block first;
@@ -117,6 +119,18 @@ struct data_block_list {
 
 struct resource_ref;
 
+/**
+ * Bins are handed out to the rasterizer threads through one of these per
+ * thread.  Each queue covers a separate band of the screen, with its bins
+ * sorted by decreasing estimated cost.  Slots are claimed with an atomic
+ * increment, so a thread which has drained its own queue can steal from
+ * the others without taking any lock.
+ */
+struct lp_scene_bin_queue {
+   int next;                /**< next slot in bin_order to hand out */
+   unsigned end;            /**< end of this queue's slots in bin_order */
+};
+
 /**
  * All bins and bin data are contained here.
  * Per-bin data goes into the 'tile' bins.
@@ -129,6 +143,9 @@ struct lp_scene {
    struct pipe_context *pipe;
    struct lp_fence *fence;
 
+   /** where data blocks come from and go back to */
+   struct lp_scene_pool *pool;
+
    /* The queries still active at end of scene */
    struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
    unsigned num_active_queries;
@@ -180,8 +197,15 @@ struct lp_scene {
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
-   mtx_t mutex;
+   /** For handing out bins to the rasterizer threads */
+   struct lp_scene_bin_queue *bin_queue;
+   unsigned num_bin_queues;
+   unsigned bin_queue_size;
+   /** Used to hand out bins in raster order if allocating the above failed */
+   struct lp_scene_bin_queue raster_order_queue;
+   /** Non-empty bins, (cost << 32) | (y << 16) | x, grouped by queue */
+   uint64_t *bin_order;
+   unsigned bin_order_size;
 
    struct cmd_bin tile[TILES_X][TILES_Y];
    struct data_block_list data;
@@ -193,6 +217,16 @@ struct lp_scene *lp_scene_create(struct pipe_context *pipe);
 
 void lp_scene_destroy(struct lp_scene *scene);
 
+struct lp_scene *lp_scene_create_binner(struct pipe_context *pipe);
+
+void lp_scene_begin_binner(struct lp_scene *binner,
+                           const struct lp_scene *scene,
+                           unsigned max_size);
+
+void lp_scene_merge_bins(struct lp_scene *scene, struct lp_scene *binner);
+
+void lp_scene_discard_bins(struct lp_scene *binner);
+
 boolean lp_scene_is_empty(struct lp_scene *scene );
 boolean lp_scene_is_oom(struct lp_scene *scene );
 
@@ -204,10 +238,11 @@ struct cmd_block *lp_scene_new_cmd_block( struct lp_scene *scene,
 
 boolean lp_scene_add_resource_reference(struct lp_scene *scene,
                                         struct pipe_resource *resource,
+                                        boolean writable,
                                         boolean initializing_scene);
 
-boolean lp_scene_is_resource_referenced(const struct lp_scene *scene,
-                                        const struct pipe_resource *resource );
+unsigned lp_scene_is_resource_referenced(const struct lp_scene *scene,
+                                         const struct pipe_resource *resource );
 
 
 /**
@@ -386,10 +421,11 @@ lp_scene_get_num_bins( const struct lp_scene *scene )
 
 
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene );
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads );
 
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene, int *x, int *y );
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned thread_index,
+                        int *x, int *y );
 
 
 
@@ -411,6 +447,9 @@ lp_scene_begin_rasterization(struct lp_scene *scene);
 void
 lp_scene_end_rasterization(struct lp_scene *scene);
 
+void
+lp_scene_reset(struct lp_scene *scene);
+
 
 
 
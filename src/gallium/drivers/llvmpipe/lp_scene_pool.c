@@ -0,0 +1,183 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **************************************************************************/
+
+#include "util/u_memory.h"
+#include "lp_perf.h"
+#include "lp_scene.h"
+#include "lp_scene_pool.h"
+
+
+/** Blocks allocated up front, and never trimmed below */
+#define LP_SCENE_POOL_MIN_BLOCKS 16
+
+/** Trim the pool down to the high-water mark every so many puts */
+#define LP_SCENE_POOL_TRIM_INTERVAL 64
+
+
+/**
+ * Allocate a new block and touch each of its pages, so that the page
+ * faults happen here rather than while binning.
+ */
+static struct data_block *
+alloc_block(void)
+{
+   struct data_block *block = MALLOC_STRUCT(data_block);
+   unsigned i;
+
+   if (!block)
+      return NULL;
+
+   for (i = 0; i < DATA_BLOCK_SIZE; i += 4096)
+      block->data[i] = 0;
+
+   return block;
+}
+
+
+void
+lp_scene_pool_init(struct lp_scene_pool *pool)
+{
+   unsigned i;
+
+   memset(pool, 0, sizeof *pool);
+   (void) mtx_init(&pool->mutex, mtx_plain);
+
+   for (i = 0; i < LP_SCENE_POOL_MIN_BLOCKS; i++) {
+      struct data_block *block = alloc_block();
+      if (!block)
+         break;
+      block->next = pool->free;
+      pool->free = block;
+      pool->num_free++;
+   }
+}
+
+
+/**
+ * Free the pool.  All scenes must have returned their blocks.
+ */
+void
+lp_scene_pool_fini(struct lp_scene_pool *pool)
+{
+   struct data_block *block, *next;
+
+   assert(pool->num_used == 0);
+
+   for (block = pool->free; block; block = next) {
+      next = block->next;
+      FREE(block);
+   }
+
+   mtx_destroy(&pool->mutex);
+}
+
+
+/**
+ * Get an empty block, recycled if possible.
+ */
+struct data_block *
+lp_scene_pool_get(struct lp_scene_pool *pool)
+{
+   struct data_block *block;
+
+   mtx_lock(&pool->mutex);
+
+   block = pool->free;
+   if (block) {
+      pool->free = block->next;
+      pool->num_free--;
+      LP_COUNT_ADD(scene_bytes_recycled, sizeof *block);
+   }
+
+   pool->num_used++;
+   pool->peak_used = MAX2(pool->peak_used, pool->num_used);
+
+   mtx_unlock(&pool->mutex);
+
+   if (!block) {
+      block = alloc_block();
+      if (!block) {
+         mtx_lock(&pool->mutex);
+         pool->num_used--;
+         mtx_unlock(&pool->mutex);
+         return NULL;
+      }
+      LP_COUNT_ADD(scene_bytes_allocated, sizeof *block);
+   }
+
+   block->used = 0;
+   block->next = NULL;
+
+   return block;
+}
+
+
+/**
+ * Return a NULL-terminated list of blocks to the pool.
+ */
+void
+lp_scene_pool_put(struct lp_scene_pool *pool, struct data_block *blocks)
+{
+   struct data_block *last, *trimmed = NULL;
+   unsigned count;
+
+   if (!blocks)
+      return;
+
+   for (last = blocks, count = 1; last->next; last = last->next)
+      count++;
+
+   mtx_lock(&pool->mutex);
+
+   assert(pool->num_used >= count);
+   last->next = pool->free;
+   pool->free = blocks;
+   pool->num_free += count;
+   pool->num_used -= count;
+
+   /* Keep what it takes to get back to the recent peak, free the rest. */
+   if (++pool->num_puts >= LP_SCENE_POOL_TRIM_INTERVAL) {
+      unsigned keep = MAX2(pool->peak_used - pool->num_used,
+                           LP_SCENE_POOL_MIN_BLOCKS);
+
+      while (pool->num_free > keep) {
+         struct data_block *block = pool->free;
+         pool->free = block->next;
+         pool->num_free--;
+         block->next = trimmed;
+         trimmed = block;
+      }
+
+      pool->peak_used = pool->num_used;
+      pool->num_puts = 0;
+   }
+
+   mtx_unlock(&pool->mutex);
+
+   while (trimmed) {
+      struct data_block *next = trimmed->next;
+      FREE(trimmed);
+      trimmed = next;
+   }
+}
@@ -0,0 +1,68 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Screen-wide pool of scene data blocks.
+ *
+ * Every scene allocates its bins and bin data out of DATA_BLOCK_SIZE
+ * blocks and drops them once rasterized.  With many small flushes the
+ * malloc/free (and page fault) traffic for these shows up, so finished
+ * scenes hand their blocks back here instead, and new ones take from
+ * here first.  The pool keeps enough blocks for the recent peak demand
+ * and frees the rest.
+ */
+
+#ifndef LP_SCENE_POOL_H
+#define LP_SCENE_POOL_H
+
+#include "os/os_thread.h"
+
+struct data_block;
+
+struct lp_scene_pool {
+   mtx_t mutex;
+
+   struct data_block *free;   /**< free blocks, linked through next */
+   unsigned num_free;
+
+   unsigned num_used;         /**< blocks currently owned by scenes */
+   unsigned peak_used;        /**< high-water mark of num_used since last trim */
+   unsigned num_puts;         /**< scenes returned since last trim */
+};
+
+
+void
+lp_scene_pool_init(struct lp_scene_pool *pool);
+
+void
+lp_scene_pool_fini(struct lp_scene_pool *pool);
+
+struct data_block *
+lp_scene_pool_get(struct lp_scene_pool *pool);
+
+void
+lp_scene_pool_put(struct lp_scene_pool *pool, struct data_block *blocks);
+
+
+#endif /* LP_SCENE_POOL_H */
@@ -27,20 +27,36 @@
 
 
 /**
- * Scene queue.  We'll use two queues.  One contains "full" scenes which
- * are produced by the "setup" code.  The other contains "empty" scenes
- * which are produced by the "rast" code when it finishes rendering a scene.
+ * Scene queue.  The setup code of any context puts "full" scenes in it,
+ * which the rasterizer threads take out and render.
+ *
+ * This is a bounded lock-free queue: each slot has a sequence number
+ * telling whether it's ready to be written to (sequence == position) or
+ * read from (sequence == position + 1) for the current lap around the
+ * ring.  Producers and consumers claim positions with a compare and swap
+ * on tail and head respectively.  Waiting for a free slot or a scene is
+ * done by yielding, which is fine as the rasterizer is woken up by
+ * semaphores only after a scene was queued, and the queue is sized well
+ * above the number of scenes in flight.
  */
 
 #include "os/os_thread.h"
+#include "util/u_atomic.h"
 #include "util/u_memory.h"
 #include "lp_scene_queue.h"
 #include "util/u_math.h"
 
 
 
-#define SCENE_QUEUE_SIZE 4
+#define SCENE_QUEUE_SIZE 64
+
+
 
+struct lp_scene_queue_slot
+{
+   unsigned sequence;
+   struct lp_scene *scene;
+};
 
 
 /**
@@ -48,17 +64,15 @@
  */
 struct lp_scene_queue
 {
-   struct lp_scene *scenes[SCENE_QUEUE_SIZE];
+   struct lp_scene_queue_slot slots[SCENE_QUEUE_SIZE];
 
-   mtx_t mutex;
-   cnd_t change;
-
-   /* These values wrap around, so that head == tail means empty.  When used
-    * to index the array, we use them modulo the queue size.  This scheme
-    * works because the queue size is a power of two.
+   /* These values wrap around.  When used to index the array, we use them
+    * modulo the queue size.  This scheme works because the queue size is
+    * a power of two.  Keep them on separate cache lines, as they are
+    * written to by different threads.
     */
-   unsigned head;
-   unsigned tail;
+   PIPE_ALIGN_VAR(64) unsigned head;
+   PIPE_ALIGN_VAR(64) unsigned tail;
 };
 
 
@@ -71,13 +85,14 @@ lp_scene_queue_create(void)
    STATIC_ASSERT(SCENE_QUEUE_SIZE > 0);
    STATIC_ASSERT((SCENE_QUEUE_SIZE & (SCENE_QUEUE_SIZE - 1)) == 0);
 
-   struct lp_scene_queue *queue = CALLOC_STRUCT(lp_scene_queue);
+   struct lp_scene_queue *queue = align_calloc(sizeof *queue, 64);
+   unsigned i;
 
    if (!queue)
       return NULL;
 
-   (void) mtx_init(&queue->mutex, mtx_plain);
-   cnd_init(&queue->change);
+   for (i = 0; i < SCENE_QUEUE_SIZE; i++)
+      queue->slots[i].sequence = i;
 
    return queue;
 }
@@ -87,9 +102,7 @@ lp_scene_queue_create(void)
 void
 lp_scene_queue_destroy(struct lp_scene_queue *queue)
 {
-   cnd_destroy(&queue->change);
-   mtx_destroy(&queue->mutex);
-   FREE(queue);
+   align_free(queue);
 }
 
 
@@ -97,23 +110,37 @@ lp_scene_queue_destroy(struct lp_scene_queue *queue)
 struct lp_scene *
 lp_scene_dequeue(struct lp_scene_queue *queue, boolean wait)
 {
-   mtx_lock(&queue->mutex);
-
-   if (wait) {
-      /* Wait for queue to be not empty. */
-      while (queue->head == queue->tail)
-         cnd_wait(&queue->change, &queue->mutex);
-   } else {
-      if (queue->head == queue->tail) {
-         mtx_unlock(&queue->mutex);
-         return NULL;
+   struct lp_scene_queue_slot *slot;
+   unsigned pos = p_atomic_read(&queue->head);
+
+   for (;;) {
+      slot = &queue->slots[pos % SCENE_QUEUE_SIZE];
+
+      int diff = (int)(p_atomic_read(&slot->sequence) - (pos + 1));
+
+      if (diff == 0) {
+         unsigned old = p_atomic_cmpxchg(&queue->head, pos, pos + 1);
+         if (old == pos)
+            break;
+         pos = old;
+      }
+      else if (diff < 0) {
+         /* Empty. */
+         if (!wait)
+            return NULL;
+         thrd_yield();
+         pos = p_atomic_read(&queue->head);
+      }
+      else {
+         /* Another consumer got this one. */
+         pos = p_atomic_read(&queue->head);
       }
    }
 
-   struct lp_scene *scene = queue->scenes[queue->head++ % SCENE_QUEUE_SIZE];
+   struct lp_scene *scene = slot->scene;
 
-   cnd_signal(&queue->change);
-   mtx_unlock(&queue->mutex);
+   /* Hand the slot back to the producers, for the next lap. */
+   p_atomic_set(&slot->sequence, pos + SCENE_QUEUE_SIZE);
 
    return scene;
 }
@@ -123,14 +150,33 @@ lp_scene_dequeue(struct lp_scene_queue *queue, boolean wait)
 void
 lp_scene_enqueue(struct lp_scene_queue *queue, struct lp_scene *scene)
 {
-   mtx_lock(&queue->mutex);
+   struct lp_scene_queue_slot *slot;
+   unsigned pos = p_atomic_read(&queue->tail);
+
+   for (;;) {
+      slot = &queue->slots[pos % SCENE_QUEUE_SIZE];
+
+      int diff = (int)(p_atomic_read(&slot->sequence) - pos);
 
-   /* Wait for free space. */
-   while (queue->tail - queue->head >= SCENE_QUEUE_SIZE)
-      cnd_wait(&queue->change, &queue->mutex);
+      if (diff == 0) {
+         unsigned old = p_atomic_cmpxchg(&queue->tail, pos, pos + 1);
+         if (old == pos)
+            break;
+         pos = old;
+      }
+      else if (diff < 0) {
+         /* Wait for free space. */
+         thrd_yield();
+         pos = p_atomic_read(&queue->tail);
+      }
+      else {
+         /* Another producer got this one. */
+         pos = p_atomic_read(&queue->tail);
+      }
+   }
 
-   queue->scenes[queue->tail++ % SCENE_QUEUE_SIZE] = scene;
+   slot->scene = scene;
 
-   cnd_signal(&queue->change);
-   mtx_unlock(&queue->mutex);
+   /* Publish the scene to the consumers. */
+   p_atomic_set(&slot->sequence, pos + 1);
 }
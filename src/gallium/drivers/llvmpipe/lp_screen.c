@@ -51,6 +51,7 @@
 #include "lp_limits.h"
 #include "lp_rast.h"
 #include "lp_cs_tpool.h"
+#include "lp_state_fs.h"
 
 #include "frontend/sw_winsys.h"
 
@@ -76,6 +77,7 @@ static const struct debug_named_value lp_debug_flags[] = {
    { "tgsi_ir", DEBUG_TGSI_IR, NULL },
    { "cl", DEBUG_CL, NULL },
    { "cache_stats", DEBUG_CACHE_STATS, NULL },
+   { "rast_time", DEBUG_RAST_TIME, NULL },
    DEBUG_NAMED_VALUE_END
 };
 #endif
@@ -90,6 +92,7 @@ static const struct debug_named_value lp_perf_flags[] = {
    { "no_blend",       PERF_NO_BLEND, NULL },
    { "no_depth",       PERF_NO_DEPTH, NULL },
    { "no_alphatest",   PERF_NO_ALPHATEST, NULL },
+   { "no_hiz",         PERF_NO_HIZ, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -709,6 +712,19 @@ llvmpipe_flush_frontbuffer(struct pipe_screen *_screen,
    struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
    struct sw_winsys *winsys = screen->winsys;
    struct llvmpipe_resource *texture = llvmpipe_resource(resource);
+   struct lp_fence *fence = NULL;
+
+   /* Flushing doesn't wait for the rasterizer, so the scenes rendering to
+    * the display target may still be in flight.
+    */
+   mtx_lock(&screen->rast_mutex);
+   lp_fence_reference(&fence, screen->last_fence);
+   mtx_unlock(&screen->rast_mutex);
+
+   if (fence) {
+      lp_fence_wait(fence);
+      lp_fence_reference(&fence, NULL);
+   }
 
    assert(texture->dt);
    if (texture->dt)
@@ -727,11 +743,25 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
    if (screen->rast)
       lp_rast_destroy(screen->rast);
 
+   lp_fence_reference(&screen->last_fence, NULL);
+
+   lp_scene_pool_fini(&screen->scene_pool);
+
    lp_jit_screen_cleanup(screen);
 
-   if (LP_DEBUG & DEBUG_CACHE_STATS)
+   if (LP_DEBUG & DEBUG_CACHE_STATS) {
       printf("disk shader cache:   hits = %u, misses = %u\n", screen->num_disk_shader_cache_hits,
              screen->num_disk_shader_cache_misses);
+      printf("  draw shaders:      hits = %u, misses = %u\n", screen->num_disk_draw_cache_hits,
+             screen->num_disk_draw_cache_misses);
+      printf("  setup variants:    hits = %u, misses = %u\n", screen->num_disk_setup_cache_hits,
+             screen->num_disk_setup_cache_misses);
+      printf("fs variant cache:    hits = %u, misses = %u\n", screen->num_fs_variant_cache_hits,
+             screen->num_fs_variant_cache_misses);
+   }
+   if (screen->async_compile)
+      util_queue_destroy(&screen->compile_queue);
+   lp_fs_variant_cache_destroy(screen);
    disk_cache_destroy(screen->disk_shader_cache);
    if(winsys->destroy)
       winsys->destroy(winsys);
@@ -855,6 +885,7 @@ struct pipe_screen *
 llvmpipe_create_screen(struct sw_winsys *winsys)
 {
    struct llvmpipe_screen *screen;
+   boolean pin_threads;
 
    util_cpu_detect();
 
@@ -908,8 +939,9 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
 #endif
    screen->num_threads = debug_get_num_option("LP_NUM_THREADS", screen->num_threads);
    screen->num_threads = MIN2(screen->num_threads, LP_MAX_THREADS);
+   pin_threads = debug_get_bool_option("LP_PIN_THREADS", FALSE);
 
-   screen->rast = lp_rast_create(screen->num_threads);
+   screen->rast = lp_rast_create(screen->num_threads, pin_threads);
    if (!screen->rast) {
       lp_jit_screen_cleanup(screen);
       FREE(screen);
@@ -917,15 +949,59 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    }
    (void) mtx_init(&screen->rast_mutex, mtx_plain);
 
+   lp_scene_pool_init(&screen->scene_pool);
+
+   /* Only the rasterizer threads get pinned.  The compute pool has as many
+    * threads, and pinning its thread i to the same CPU as rasterizer
+    * thread i would make them fight over it.
+    */
    screen->cs_tpool = lp_cs_tpool_create(screen->num_threads);
    if (!screen->cs_tpool) {
       lp_rast_destroy(screen->rast);
+      lp_scene_pool_fini(&screen->scene_pool);
       lp_jit_screen_cleanup(screen);
       FREE(screen);
       return NULL;
    }
    (void) mtx_init(&screen->cs_mutex, mtx_plain);
 
+   /* Triangle binning can be split up on the compute threads.  This is
+    * opt-in until it is shown to pay off on typical workloads.
+    */
+   screen->num_binner_threads =
+      debug_get_num_option("LP_NUM_BINNER_THREADS", 0);
+   screen->num_binner_threads = MIN2(screen->num_binner_threads,
+                                     screen->cs_tpool->num_threads);
+
+   /* So can the vertex shaders of large draws, also opt-in. */
+   screen->num_vs_threads =
+      debug_get_num_option("LP_NUM_VS_THREADS", 0);
+   screen->num_vs_threads = MIN2(screen->num_vs_threads,
+                                 screen->cs_tpool->num_threads);
+
+   /* Each context bins into the next of its scenes while the rasterizer
+    * is busy with the previous ones.
+    */
+   screen->num_scenes = debug_get_num_option("LP_NUM_SCENES", 3);
+   screen->num_scenes = CLAMP(screen->num_scenes, 1, LP_MAX_SCENES);
+
+   /* Leaving x/y clipping of small enough primitives to the rasterizer
+    * needs their window coordinates to keep full subpixel precision.
+    */
+   screen->guard_band = debug_get_num_option("LP_GUARD_BAND", 8192);
+   screen->guard_band = MIN2(screen->guard_band, 8192);
+
+   lp_fs_variant_cache_init(screen);
+
+   screen->async_compile = debug_get_bool_option("LP_ASYNC_COMPILE", FALSE);
+   if (screen->async_compile &&
+       !util_queue_init(&screen->compile_queue, "lpcompile", 64, 1,
+                        UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                        UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY))
+      screen->async_compile = false;
+   screen->fs_tier_up_draws = debug_get_num_option("LP_TIER_UP_DRAWS", 0);
+   screen->tiled_textures = debug_get_bool_option("LP_TILED_TEXTURES", FALSE);
+
    lp_disk_cache_create(screen);
    return &screen->base;
 }
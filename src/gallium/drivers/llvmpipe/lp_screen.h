@@ -37,11 +37,15 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_defines.h"
 #include "os/os_thread.h"
+#include "util/u_queue.h"
 #include "gallivm/lp_bld.h"
 #include "gallivm/lp_bld_misc.h"
+#include "lp_scene_pool.h"
 
 struct sw_winsys;
 struct lp_cs_tpool;
+struct lp_fence;
+struct hash_table;
 
 struct llvmpipe_screen
 {
@@ -50,6 +54,10 @@ struct llvmpipe_screen
    struct sw_winsys *winsys;
 
    unsigned num_threads;
+   unsigned num_binner_threads;
+   unsigned num_vs_threads;
+   unsigned num_scenes;
+   unsigned guard_band;
 
    /* Increments whenever textures are modified.  Contexts can track this.
     */
@@ -58,14 +66,49 @@ struct llvmpipe_screen
    struct lp_rasterizer *rast;
    mtx_t rast_mutex;
 
+   /* Fence of the last scene queued to the rasterizer by any context,
+    * protected by rast_mutex.  Scenes are rasterized in order, so once
+    * it's signalled all rendering is done.
+    */
+   struct lp_fence *last_fence;
+
+   /* Scene data blocks, shared by all contexts */
+   struct lp_scene_pool scene_pool;
+
    struct lp_cs_tpool *cs_tpool;
    mtx_t cs_mutex;
 
    bool use_tgsi;
 
+   /* Compiled fragment shader variants shared by all contexts */
+   struct hash_table *fs_variant_cache;
+   mtx_t fs_variant_cache_mutex;
+   unsigned num_fs_variant_cache_hits;
+   unsigned num_fs_variant_cache_misses;
+
+   /* Background compilation of optimized fs variants, see LP_ASYNC_COMPILE */
+   bool async_compile;
+   struct util_queue compile_queue;
+   unsigned num_fs_compile_jobs;
+
+   /* Draws before an fs variant is recompiled with full optimization, or
+    * zero to always compile that right away, see LP_TIER_UP_DRAWS
+    */
+   unsigned fs_tier_up_draws;
+
+   /* Store sampler-only textures in tiles, see LP_TILED_TEXTURES */
+   bool tiled_textures;
+
    struct disk_cache *disk_shader_cache;
    unsigned num_disk_shader_cache_hits;
    unsigned num_disk_shader_cache_misses;
+   /* Draw module (vs/gs/tcs/tes) and setup variant lookups, included in
+    * the above
+    */
+   unsigned num_disk_draw_cache_hits;
+   unsigned num_disk_draw_cache_misses;
+   unsigned num_disk_setup_cache_hits;
+   unsigned num_disk_setup_cache_misses;
 };
 
 void lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
@@ -32,6 +32,7 @@
  * lp_setup_flush().
  */
 
+#include <float.h>
 #include <limits.h>
 
 #include "pipe/p_defines.h"
@@ -70,16 +71,21 @@ lp_setup_get_empty_scene(struct lp_setup_context *setup)
    assert(setup->scene == NULL);
 
    setup->scene_idx++;
-   setup->scene_idx %= ARRAY_SIZE(setup->scenes);
+   setup->scene_idx %= setup->num_scenes;
 
    setup->scene = setup->scenes[setup->scene_idx];
 
+   /* A scene still has its fence until it's been reset, ie. it may be in
+    * flight.  Wait for the rasterizer to be done with it, then free the
+    * data it was binned into.
+    */
    if (setup->scene->fence) {
       if (LP_DEBUG & DEBUG_SETUP)
          debug_printf("%s: wait for scene %d\n",
                       __FUNCTION__, setup->scene->fence->id);
 
       lp_fence_wait(setup->scene->fence);
+      lp_scene_reset(setup->scene);
    }
 
    lp_scene_begin_binning(setup->scene, &setup->fb);
@@ -147,6 +153,27 @@ void lp_setup_reset( struct lp_setup_context *setup )
 }
 
 
+/**
+ * Are any scenes other than \p except still being rasterized?
+ */
+static boolean
+lp_setup_scenes_in_flight(const struct lp_setup_context *setup,
+                          const struct lp_scene *except)
+{
+   unsigned i;
+
+   for (i = 0; i < setup->num_scenes; i++) {
+      const struct lp_scene *scene = setup->scenes[i];
+
+      if (scene != except && scene->fence &&
+          !lp_fence_signalled(scene->fence))
+         return TRUE;
+   }
+
+   return FALSE;
+}
+
+
 /** Rasterize all scene's bins */
 static void
 lp_setup_rasterize_scene( struct lp_setup_context *setup )
@@ -165,23 +192,21 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
    if (setup->last_fence)
       setup->last_fence->issued = TRUE;
 
-   mtx_lock(&screen->rast_mutex);
+   /* If none of our other scenes is in flight, this is the time to pick
+    * up fs variants compiled in the background.
+    */
+   if (!lp_setup_scenes_in_flight(setup, scene))
+      lp_fs_swap_compiled_variants(llvmpipe_context(scene->pipe));
 
-   /* FIXME: We enqueue the scene then wait on the rasterizer to finish.
-    * This means we never actually run any vertex stuff in parallel to
-    * rasterization (not in the same context at least) which is what the
-    * multiple scenes per setup is about - when we get a new empty scene
-    * any old one is already empty again because we waited here for
-    * raster tasks to be finished. Ideally, we shouldn't need to wait here
-    * and rely on fences elsewhere when waiting is necessary.
-    * Certainly, lp_scene_end_rasterization() would need to be deferred too
-    * and there's probably other bits why this doesn't actually work.
+   /* We don't wait for the rasterizer here: the scene is reset the next
+    * time it comes round in lp_setup_get_empty_scene(), and whoever needs
+    * its results waits on its fence.  Meanwhile the next scene is binned.
     */
+   mtx_lock(&screen->rast_mutex);
+   lp_fence_reference(&screen->last_fence, scene->fence);
    lp_rast_queue_scene(screen->rast, scene);
-   lp_rast_finish(screen->rast);
    mtx_unlock(&screen->rast_mutex);
 
-   lp_scene_end_rasterization(setup->scene);
    lp_setup_reset( setup );
 
    LP_DBG(DEBUG_SETUP, "%s done \n", __FUNCTION__);
@@ -199,9 +224,10 @@ begin_binning( struct lp_setup_context *setup )
    assert(scene);
    assert(scene->fence == NULL);
 
-   /* Always create a fence:
+   /* Always create a fence.  The rasterizer signals it once, when it's
+    * done with the whole scene.
     */
-   scene->fence = lp_fence_create(MAX2(1, setup->num_threads));
+   scene->fence = lp_fence_create(1);
    if (!scene->fence)
       return FALSE;
 
@@ -342,7 +368,7 @@ set_scene_state( struct lp_setup_context *setup,
 
 fail:
    if (setup->scene) {
-      lp_scene_end_rasterization(setup->scene);
+      lp_scene_reset(setup->scene);
       setup->scene = NULL;
    }
 
@@ -873,6 +899,30 @@ lp_setup_set_viewports(struct lp_setup_context *setup,
           setup->viewports[i].max_depth = max_depth;
           setup->dirty |= LP_SETUP_NEW_VIEWPORTS;
       }
+
+      if (setup->guard_band) {
+         /* Draw no longer clips to the viewport, so scissor to it */
+         const float *scale = viewports[i].scale;
+         const float *translate = viewports[i].translate;
+         float *bounds = setup->viewport_bounds[i];
+         struct u_rect rect;
+
+         bounds[0] = translate[0] - fabsf(scale[0]);
+         bounds[1] = translate[1] - fabsf(scale[1]);
+         bounds[2] = translate[0] + fabsf(scale[0]);
+         bounds[3] = translate[1] + fabsf(scale[1]);
+
+         /* pixels whose sample position is inside the viewport */
+         rect.x0 = (int)ceilf(bounds[0] - setup->pixel_offset);
+         rect.y0 = (int)ceilf(bounds[1] - setup->pixel_offset);
+         rect.x1 = (int)ceilf(bounds[2] - setup->pixel_offset) - 1;
+         rect.y1 = (int)ceilf(bounds[3] - setup->pixel_offset) - 1;
+
+         if (memcmp(&setup->viewport_rects[i], &rect, sizeof rect) != 0) {
+            setup->viewport_rects[i] = rect;
+            setup->dirty |= LP_SETUP_NEW_SCISSOR;
+         }
+      }
    }
 }
 
@@ -1081,10 +1131,17 @@ lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
       return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
    }
 
-   /* check textures referenced by the scene */
-   for (i = 0; i < ARRAY_SIZE(setup->scenes); i++) {
-      if (lp_scene_is_resource_referenced(setup->scenes[i], texture)) {
-         return LP_REFERENCED_FOR_READ;
+   /* check the scenes being binned or rasterized, which may have been
+    * binned with another framebuffer
+    */
+   for (i = 0; i < setup->num_scenes; i++) {
+      struct lp_scene *scene = setup->scenes[i];
+
+      if (scene->fence && !lp_fence_signalled(scene->fence)) {
+         unsigned referenced = lp_scene_is_resource_referenced(scene,
+                                                               texture);
+         if (referenced)
+            return referenced;
       }
    }
 
@@ -1292,7 +1349,33 @@ try_update_scene_state( struct lp_setup_context *setup )
             if (setup->fs.current_tex[i]) {
                if (!lp_scene_add_resource_reference(scene,
                                                     setup->fs.current_tex[i],
-                                                    new_scene)) {
+                                                    FALSE, new_scene)) {
+                  assert(!new_scene);
+                  return FALSE;
+               }
+            }
+         }
+
+         /* Shader buffers and images may be written to, and the state
+          * record only has raw pointers to their data, so they need
+          * references too as long as the scene is in flight.
+          */
+         for (i = 0; i < ARRAY_SIZE(setup->ssbos); i++) {
+            if (setup->ssbos[i].current.buffer) {
+               if (!lp_scene_add_resource_reference(scene,
+                                                    setup->ssbos[i].current.buffer,
+                                                    TRUE, new_scene)) {
+                  assert(!new_scene);
+                  return FALSE;
+               }
+            }
+         }
+
+         for (i = 0; i < ARRAY_SIZE(setup->images); i++) {
+            if (setup->images[i].current.resource) {
+               if (!lp_scene_add_resource_reference(scene,
+                                                    setup->images[i].current.resource,
+                                                    TRUE, new_scene)) {
                   assert(!new_scene);
                   return FALSE;
                }
@@ -1309,6 +1392,14 @@ try_update_scene_state( struct lp_setup_context *setup )
             u_rect_possible_intersection(&setup->scissors[i],
                                          &setup->draw_regions[i]);
          }
+         /* Only triangles are scissored to the viewport.  Wide points
+          * and lines may extend past it, and draw still clips lines.
+          */
+         setup->tri_regions[i] = setup->draw_regions[i];
+         if (setup->guard_band) {
+            u_rect_possible_intersection(&setup->viewport_rects[i],
+                                         &setup->tri_regions[i]);
+         }
       }
    }
 
@@ -1417,16 +1508,25 @@ lp_setup_destroy( struct lp_setup_context *setup )
       pipe_resource_reference(&setup->ssbos[i].current.buffer, NULL);
    }
 
-   /* free the scenes in the 'empty' queue */
-   for (i = 0; i < ARRAY_SIZE(setup->scenes); i++) {
+   /* wait for the scenes in flight, then free them all */
+   for (i = 0; i < setup->num_scenes; i++) {
       struct lp_scene *scene = setup->scenes[i];
 
-      if (scene->fence)
-         lp_fence_wait(scene->fence);
+      if (scene->fence) {
+         if (lp_fence_issued(scene->fence))
+            lp_fence_wait(scene->fence);
+         lp_scene_reset(scene);
+      }
 
       lp_scene_destroy(scene);
    }
 
+   for (i = 0; i < setup->num_binners; i++) {
+      if (setup->binners[i].scene)
+         lp_scene_destroy(setup->binners[i].scene);
+   }
+   FREE(setup->binners);
+
    lp_fence_reference(&setup->last_fence, NULL);
 
    FREE( setup );
@@ -1451,14 +1551,33 @@ lp_setup_create( struct pipe_context *pipe,
       goto no_setup;
    }
 
-   lp_setup_init_vbuf(setup);
-   
    /* Used only in update_state():
     */
    setup->pipe = pipe;
 
 
    setup->num_threads = screen->num_threads;
+   setup->guard_band = screen->guard_band != 0;
+   for (i = 0; i < PIPE_MAX_VIEWPORTS; i++) {
+      setup->viewport_rects[i].x0 = 0;
+      setup->viewport_rects[i].y0 = 0;
+      setup->viewport_rects[i].x1 = INT_MAX;
+      setup->viewport_rects[i].y1 = INT_MAX;
+      setup->viewport_bounds[i][0] = -FLT_MAX;
+      setup->viewport_bounds[i][1] = -FLT_MAX;
+      setup->viewport_bounds[i][2] = FLT_MAX;
+      setup->viewport_bounds[i][3] = FLT_MAX;
+   }
+
+   if (screen->num_binner_threads) {
+      setup->binners = CALLOC(screen->num_binner_threads,
+                              sizeof(*setup->binners));
+      if (setup->binners)
+         setup->num_binners = screen->num_binner_threads;
+   }
+
+   lp_setup_init_vbuf(setup);
+
    setup->vbuf = draw_vbuf_stage(draw, &setup->base);
    if (!setup->vbuf) {
       goto no_vbuf;
@@ -1468,7 +1587,8 @@ lp_setup_create( struct pipe_context *pipe,
    draw_set_render(draw, &setup->base);
 
    /* create some empty scenes */
-   for (i = 0; i < MAX_SCENES; i++) {
+   setup->num_scenes = screen->num_scenes;
+   for (i = 0; i < setup->num_scenes; i++) {
       setup->scenes[i] = lp_scene_create( pipe );
       if (!setup->scenes[i]) {
          goto no_scenes;
@@ -1488,7 +1608,7 @@ lp_setup_create( struct pipe_context *pipe,
    return setup;
 
 no_scenes:
-   for (i = 0; i < MAX_SCENES; i++) {
+   for (i = 0; i < setup->num_scenes; i++) {
       if (setup->scenes[i]) {
          lp_scene_destroy(setup->scenes[i]);
       }
@@ -1496,6 +1616,7 @@ no_scenes:
 
    setup->vbuf->destroy(setup->vbuf);
 no_vbuf:
+   FREE(setup->binners);
    FREE(setup);
 no_setup:
    return NULL;
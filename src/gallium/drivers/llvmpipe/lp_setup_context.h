@@ -52,12 +52,7 @@
 #define LP_SETUP_NEW_SSBOS       0x20
 
 struct lp_setup_variant;
-
-
-/** Max number of scenes */
-/* XXX: make multiple scenes per context work, see lp_setup_rasterize_scene */
-#define MAX_SCENES 1
-
+struct lp_setup_binner;
 
 
 /**
@@ -87,8 +82,9 @@ struct lp_setup_context
     */
    struct draw_stage *vbuf;
    unsigned num_threads;
+   unsigned num_scenes;
    unsigned scene_idx;
-   struct lp_scene *scenes[MAX_SCENES];  /**< all the scenes */
+   struct lp_scene *scenes[LP_MAX_SCENES];  /**< all the scenes */
    struct lp_scene *scene;               /**< current scene being built */
 
    struct lp_fence *last_fence;
@@ -115,6 +111,10 @@ struct lp_setup_context
    struct u_rect framebuffer;
    struct u_rect scissors[PIPE_MAX_VIEWPORTS];
    struct u_rect draw_regions[PIPE_MAX_VIEWPORTS];   /* intersection of fb & scissor */
+   struct u_rect tri_regions[PIPE_MAX_VIEWPORTS];    /* draw_regions (& viewport) */
+   struct u_rect viewport_rects[PIPE_MAX_VIEWPORTS]; /* pixels inside the viewports */
+   float viewport_bounds[PIPE_MAX_VIEWPORTS][4];     /* x0, y0, x1, y1 */
+   boolean guard_band;  /**< x/y clipping to the viewport is done here */
    struct lp_jit_viewport viewports[PIPE_MAX_VIEWPORTS];
 
    struct {
@@ -165,6 +165,12 @@ struct lp_setup_context
 
    unsigned dirty;   /**< bitmask of LP_SETUP_NEW_x bits */
 
+   /** For binning triangles on several threads, see lp_setup_vbuf.c */
+   struct lp_setup_binner *binners;
+   unsigned num_binners;
+   /** Set in a binner's copy of the context only */
+   struct lp_setup_binner *binner;
+
    void (*point)( struct lp_setup_context *,
                   const float (*v0)[4]);
 
@@ -178,6 +184,25 @@ struct lp_setup_context
                      const float (*v2)[4]);
 };
 
+/**
+ * A binner thread bins a range of the triangles of a draw into its own
+ * scene, through a private copy of the setup context whose scene points
+ * there.  The binners' scenes are merged into the real scene in
+ * submission order once they are all done.
+ */
+struct lp_setup_binner
+{
+   struct lp_setup_context setup;
+   struct lp_scene *scene;
+
+   const void *vertex_buffer;
+   const ushort *indices;       /**< NULL for non-indexed draws */
+   unsigned stride;
+
+   unsigned start, end;         /**< range of triangles to bin */
+   boolean failed;              /**< ran out of scene memory at 'end' */
+};
+
 static inline void
 scissor_planes_needed(boolean scis_planes[4], const struct u_rect *bbox,
                       const struct u_rect *scissor)
@@ -230,6 +255,6 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
                       const struct u_rect *bboxorig,
                       const struct u_rect *bbox,
                       int nr_planes,
-                      unsigned scissor_index);
+                      const struct u_rect *region);
 
 #endif
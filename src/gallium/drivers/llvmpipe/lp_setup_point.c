@@ -373,6 +373,18 @@ try_setup_point( struct lp_setup_context *setup,
    if (0)
       print_point(setup, v0, size);
 
+   /* With the guard band draw doesn't clip points to the viewport, but
+    * a point whose center is outside of it must be discarded entirely.
+    */
+   if (setup->guard_band) {
+      const float *bounds = setup->viewport_bounds[viewport_index];
+      if (v0[0][0] < bounds[0] || v0[0][0] > bounds[2] ||
+          v0[0][1] < bounds[1] || v0[0][1] > bounds[3]) {
+         LP_COUNT(nr_culled_tris);
+         return TRUE;
+      }
+   }
+
    /* Bounding rectangle (in pixels) */
    if (!lp_context->rasterizer ||
        lp_context->rasterizer->point_quad_rasterization) {
@@ -523,7 +535,8 @@ try_setup_point( struct lp_setup_context *setup,
       plane[3].eo = 0;
    }
 
-   return lp_setup_bin_triangle(setup, point, &bbox, &bbox, nr_planes, viewport_index);
+   return lp_setup_bin_triangle(setup, point, &bbox, &bbox, nr_planes,
+                                &setup->draw_regions[viewport_index]);
 }
 
 
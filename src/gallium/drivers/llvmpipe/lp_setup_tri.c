@@ -339,7 +339,7 @@ do_triangle_ccw(struct lp_setup_context *setup,
       return TRUE;
    }
 
-   if (!u_rect_test_intersection(&setup->draw_regions[viewport_index], &bbox)) {
+   if (!u_rect_test_intersection(&setup->tri_regions[viewport_index], &bbox)) {
       if (0) debug_printf("offscreen\n");
       LP_COUNT(nr_culled_tris);
       return TRUE;
@@ -359,13 +359,13 @@ do_triangle_ccw(struct lp_setup_context *setup,
     * Determine how many scissor planes we need, that is drop scissor
     * edges if the bounding box of the tri is fully inside that edge.
     */
-   if (setup->scissor_test) {
+   if (setup->scissor_test && !setup->guard_band) {
       /* why not just use draw_regions */
       scissor = &setup->scissors[viewport_index];
       scissor_planes_needed(s_planes, &bboxpos, scissor);
       nr_planes += s_planes[0] + s_planes[1] + s_planes[2] + s_planes[3];
    } else {
-      scissor = &setup->draw_regions[viewport_index];
+      scissor = &setup->tri_regions[viewport_index];
       scissor_planes_needed(s_planes, &bboxpos, scissor);
       nr_planes += s_planes[0] + s_planes[1] + s_planes[2] + s_planes[3];
    }
@@ -732,7 +732,8 @@ do_triangle_ccw(struct lp_setup_context *setup,
       assert(plane_s == &plane[nr_planes]);
    }
 
-   return lp_setup_bin_triangle(setup, tri, &bbox, &bboxpos, nr_planes, viewport_index);
+   return lp_setup_bin_triangle(setup, tri, &bbox, &bboxpos, nr_planes,
+                                &setup->tri_regions[viewport_index]);
 }
 
 /*
@@ -763,13 +764,77 @@ floor_pot(uint32_t n)
 }
 
 
+/**
+ * Bin a 3-plane, single-sample triangle which is contained in a single
+ * 4x4 or 16x16 block of tile (ix, iy).
+ *
+ * Consecutive such triangles with the same state are packed into one
+ * LP_RAST_OP_SMALL_TRIANGLES command, so the rasterizer doesn't pay a
+ * dispatch per triangle.  A lone triangle stays a plain
+ * triangle_32_3_4/16 command, which is turned into a run when the next
+ * one arrives.
+ */
+static boolean
+lp_setup_bin_small_triangle(struct lp_setup_context *setup,
+                            struct lp_rast_triangle *tri,
+                            int ix, int iy,
+                            unsigned px, unsigned py,
+                            unsigned size)
+{
+   struct lp_scene *scene = setup->scene;
+   struct cmd_bin *bin = lp_scene_get_bin(scene, ix, iy);
+   struct cmd_block *tail = bin->tail;
+   unsigned cmd = size == 4 ? LP_RAST_OP_TRIANGLE_32_3_4 :
+                              LP_RAST_OP_TRIANGLE_32_3_16;
+
+   if (bin->last_state == setup->fs.stored && tail && tail->count) {
+      unsigned k = tail->count - 1;
+      struct lp_rast_small_tris *small = NULL;
+
+      if (tail->cmd[k] == LP_RAST_OP_SMALL_TRIANGLES) {
+         small = tail->arg[k].small_tris;
+      }
+      else if (tail->cmd[k] == LP_RAST_OP_TRIANGLE_32_3_4 ||
+               tail->cmd[k] == LP_RAST_OP_TRIANGLE_32_3_16) {
+         small = lp_scene_alloc(scene, sizeof *small);
+         if (small) {
+            unsigned pos = tail->arg[k].triangle.plane_mask;
+
+            small->count = 1;
+            small->tri[0].tri = tail->arg[k].triangle.tri;
+            small->tri[0].x = pos & 0xff;
+            small->tri[0].y = pos >> 8;
+            small->tri[0].size =
+               tail->cmd[k] == LP_RAST_OP_TRIANGLE_32_3_4 ? 4 : 16;
+
+            tail->cmd[k] = LP_RAST_OP_SMALL_TRIANGLES;
+            tail->arg[k].small_tris = small;
+         }
+      }
+
+      if (small && small->count < LP_RAST_SMALL_TRIS_MAX) {
+         struct lp_rast_small_tri *st = &small->tri[small->count++];
+         st->tri = tri;
+         st->x = px;
+         st->y = py;
+         st->size = size;
+         return TRUE;
+      }
+   }
+
+   return lp_scene_bin_cmd_with_state(scene, ix, iy,
+                                      setup->fs.stored, cmd,
+                                      lp_rast_arg_triangle_contained(tri, px, py));
+}
+
+
 boolean
 lp_setup_bin_triangle(struct lp_setup_context *setup,
                       struct lp_rast_triangle *tri,
                       const struct u_rect *bboxorig,
                       const struct u_rect *bbox,
                       int nr_planes,
-                      unsigned viewport_index)
+                      const struct u_rect *region)
 {
    struct lp_scene *scene = setup->scene;
    struct u_rect trimmed_box = *bbox;   
@@ -803,8 +868,7 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
     * the rasterizer to also respect scissor, etc, just for the rare
     * cases where a small triangle extends beyond the scissor.
     */
-   u_rect_find_intersection(&setup->draw_regions[viewport_index],
-                            &trimmed_box);
+   u_rect_find_intersection(region, &trimmed_box);
 
    /* Determine which tile(s) intersect the triangle's bounding box
     */
@@ -825,6 +889,9 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
              */
             assert(px + 4 <= TILE_SIZE);
             assert(py + 4 <= TILE_SIZE);
+            if (!setup->multisample && use_32bits)
+               return lp_setup_bin_small_triangle(setup, tri, ix0, iy0,
+                                                  px, py, 4);
             if (setup->multisample)
                cmd = LP_RAST_OP_MS_TRIANGLE_3_4;
             else
@@ -850,6 +917,9 @@ lp_setup_bin_triangle(struct lp_setup_context *setup,
             assert(px + 16 <= TILE_SIZE);
             assert(py + 16 <= TILE_SIZE);
 
+            if (!setup->multisample && use_32bits)
+               return lp_setup_bin_small_triangle(setup, tri, ix0, iy0,
+                                                  px, py, 16);
             if (setup->multisample)
                cmd = LP_RAST_OP_MS_TRIANGLE_3_16;
             else
@@ -1011,6 +1081,14 @@ static void retry_triangle_ccw( struct lp_setup_context *setup,
 {
    if (!do_triangle_ccw( setup, position, v0, v1, v2, front ))
    {
+      /* A binner thread can't flush the scene, it leaves the triangle to
+       * be binned again once its part of the draw has been merged.
+       */
+      if (setup->binner) {
+         setup->binner->failed = TRUE;
+         return;
+      }
+
       if (!lp_setup_flush_and_restart(setup))
          return;
 
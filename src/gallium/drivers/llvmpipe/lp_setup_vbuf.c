@@ -38,6 +38,8 @@
 
 #include "lp_setup_context.h"
 #include "lp_context.h"
+#include "lp_screen.h"
+#include "lp_cs_tpool.h"
 #include "draw/draw_vbuf.h"
 #include "draw/draw_vertex.h"
 #include "util/u_memory.h"
@@ -46,6 +48,16 @@
 #define LP_MAX_VBUF_INDEXES 1024
 #define LP_MAX_VBUF_SIZE    4096
 
+/* With binner threads, let the draw module hand over bigger batches of
+ * vertices so that there is enough work to split up.
+ */
+#define LP_MAX_VBUF_SIZE_BINNERS (64 * 1024)
+
+/* Don't give a binner thread fewer triangles than this, it's not worth
+ * waking it up and merging its bins for less.
+ */
+#define LP_MIN_BINNER_TRIS 32
+
   
 
 /** cast wrapper */
@@ -129,6 +141,170 @@ static inline const_float4_ptr get_vert( const void *vertex_buffer,
    return (const_float4_ptr)((char *)vertex_buffer + index * stride);
 }
 
+/**
+ * Emit the given triangle of a triangle list or strip.
+ */
+static inline void
+lp_setup_emit_triangle(struct lp_setup_context *setup,
+                       const void *vertex_buffer,
+                       const ushort *indices,
+                       unsigned stride,
+                       unsigned tri)
+{
+   unsigned v[3];
+   unsigned i;
+
+   if (setup->prim == PIPE_PRIM_TRIANGLES) {
+      i = tri * 3 + 2;
+      v[0] = i-2;
+      v[1] = i-1;
+      v[2] = i-0;
+   }
+   else if (setup->flatshade_first) {
+      /* emit first triangle vertex as first triangle vertex */
+      i = tri + 2;
+      v[0] = i-2;
+      v[1] = i+(i&1)-1;
+      v[2] = i-(i&1);
+   }
+   else {
+      /* emit last triangle vertex as last triangle vertex */
+      i = tri + 2;
+      v[0] = i+(i&1)-2;
+      v[1] = i-(i&1)-1;
+      v[2] = i-0;
+   }
+
+   if (indices) {
+      v[0] = indices[v[0]];
+      v[1] = indices[v[1]];
+      v[2] = indices[v[2]];
+   }
+
+   setup->triangle( setup,
+                    get_vert(vertex_buffer, v[0], stride),
+                    get_vert(vertex_buffer, v[1], stride),
+                    get_vert(vertex_buffer, v[2], stride) );
+}
+
+
+/**
+ * Binner thread task: bin a range of triangles through the binner's own
+ * copy of the setup context, stopping at the first one which doesn't fit
+ * in the binner's share of the scene.
+ */
+static void
+lp_setup_binner_run(void *data, int iter, struct lp_cs_local_mem *lmem)
+{
+   struct lp_setup_context *setup = data;
+   struct lp_setup_binner *binner = &setup->binners[iter];
+   unsigned tri;
+
+   for (tri = binner->start; tri < binner->end; tri++) {
+      lp_setup_emit_triangle(&binner->setup, binner->vertex_buffer,
+                             binner->indices, binner->stride, tri);
+      if (binner->failed) {
+         binner->end = tri;
+         break;
+      }
+   }
+}
+
+
+/**
+ * Split the triangles of a triangle list or strip between the binner
+ * threads, then merge what they binned into the scene in submission
+ * order.
+ *
+ * \return FALSE if the triangles should be binned on this thread instead.
+ */
+static boolean
+lp_setup_bin_triangles(struct lp_setup_context *setup,
+                       const void *vertex_buffer,
+                       const ushort *indices,
+                       unsigned stride,
+                       unsigned num_tris)
+{
+   struct llvmpipe_context *lp = llvmpipe_context(setup->pipe);
+   struct llvmpipe_screen *screen = llvmpipe_screen(setup->pipe->screen);
+   struct lp_scene *scene = setup->scene;
+   struct lp_cs_tpool_task *task;
+   unsigned num_binners, max_size, tri, i;
+
+   num_binners = MIN2(setup->num_binners, num_tris / LP_MIN_BINNER_TRIS);
+   if (num_binners < 2)
+      return FALSE;
+
+   /* The triangle functions count clipper primitives in the context. */
+   if (lp->active_statistics_queries)
+      return FALSE;
+
+   /* Each binner gets an equal share of what's left of the scene, if
+    * that's too little the scene is about to be flushed anyway.
+    */
+   max_size = (LP_SCENE_MAX_SIZE - scene->scene_size) / num_binners;
+   if (max_size < 2 * DATA_BLOCK_SIZE)
+      return FALSE;
+
+   for (i = 0; i < num_binners; i++) {
+      struct lp_setup_binner *binner = &setup->binners[i];
+
+      if (!binner->scene) {
+         binner->scene = lp_scene_create_binner(setup->pipe);
+         if (!binner->scene)
+            return FALSE;
+      }
+   }
+
+   for (i = 0; i < num_binners; i++) {
+      struct lp_setup_binner *binner = &setup->binners[i];
+
+      memcpy(&binner->setup, setup, sizeof *setup);
+      binner->setup.scene = binner->scene;
+      binner->setup.binner = binner;
+      lp_scene_begin_binner(binner->scene, scene, max_size);
+
+      binner->vertex_buffer = vertex_buffer;
+      binner->indices = indices;
+      binner->stride = stride;
+      binner->start = num_tris * i / num_binners;
+      binner->end = num_tris * (i + 1) / num_binners;
+      binner->failed = FALSE;
+   }
+
+   task = lp_cs_tpool_queue_task(screen->cs_tpool, lp_setup_binner_run,
+                                 setup, num_binners);
+   if (!task) {
+      for (i = 0; i < num_binners; i++)
+         lp_scene_discard_bins(setup->binners[i].scene);
+      return FALSE;
+   }
+   lp_cs_tpool_wait_for_task(screen->cs_tpool, &task);
+
+   /* Merge up to the first binner which ran out of memory.  Whatever
+    * comes after that is binned again here, flushing the scene as needed.
+    */
+   tri = num_tris;
+   for (i = 0; i < num_binners; i++) {
+      struct lp_setup_binner *binner = &setup->binners[i];
+
+      if (tri == num_tris) {
+         lp_scene_merge_bins(scene, binner->scene);
+         if (binner->failed)
+            tri = binner->end;
+      }
+      else {
+         lp_scene_discard_bins(binner->scene);
+      }
+   }
+
+   for (; tri < num_tris; tri++)
+      lp_setup_emit_triangle(setup, vertex_buffer, indices, stride, tri);
+
+   return TRUE;
+}
+
+
 /**
  * draw elements / indexed primitives
  */
@@ -184,6 +360,9 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
       break;
 
    case PIPE_PRIM_TRIANGLES:
+      if (lp_setup_bin_triangles(setup, vertex_buffer, indices, stride,
+                                 nr / 3))
+         break;
       for (i = 2; i < nr; i += 3) {
          setup->triangle( setup,
                           get_vert(vertex_buffer, indices[i-2], stride),
@@ -193,6 +372,10 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
       break;
 
    case PIPE_PRIM_TRIANGLE_STRIP:
+      if (nr > 2 &&
+          lp_setup_bin_triangles(setup, vertex_buffer, indices, stride,
+                                 nr - 2))
+         break;
       if (flatshade_first) {
          for (i = 2; i < nr; i += 1) {
             /* emit first triangle vertex as first triangle vertex */
@@ -382,6 +565,9 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       break;
 
    case PIPE_PRIM_TRIANGLES:
+      if (lp_setup_bin_triangles(setup, vertex_buffer, NULL, stride,
+                                 nr / 3))
+         break;
       for (i = 2; i < nr; i += 3) {
          setup->triangle( setup,
                           get_vert(vertex_buffer, i-2, stride),
@@ -391,6 +577,10 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       break;
 
    case PIPE_PRIM_TRIANGLE_STRIP:
+      if (nr > 2 &&
+          lp_setup_bin_triangles(setup, vertex_buffer, NULL, stride,
+                                 nr - 2))
+         break;
       if (flatshade_first) {
          for (i = 2; i < nr; i++) {
             /* emit first triangle vertex as first triangle vertex */
@@ -590,7 +780,8 @@ void
 lp_setup_init_vbuf(struct lp_setup_context *setup)
 {
    setup->base.max_indices = LP_MAX_VBUF_INDEXES;
-   setup->base.max_vertex_buffer_bytes = LP_MAX_VBUF_SIZE;
+   setup->base.max_vertex_buffer_bytes =
+      setup->num_binners ? LP_MAX_VBUF_SIZE_BINNERS : LP_MAX_VBUF_SIZE;
 
    setup->base.get_vertex_info = lp_setup_get_vertex_info;
    setup->base.allocate_vertices = lp_setup_allocate_vertices;
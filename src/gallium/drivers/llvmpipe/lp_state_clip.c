@@ -27,7 +27,10 @@
 
 /* Authors:  Keith Whitwell <keithw@vmware.com>
  */
+#include <float.h>
+#include "util/u_math.h"
 #include "lp_context.h"
+#include "lp_screen.h"
 #include "lp_state.h"
 #include "draw/draw_context.h"
 
@@ -50,6 +53,7 @@ llvmpipe_set_viewport_states(struct pipe_context *pipe,
                              const struct pipe_viewport_state *viewports)
 {
    struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
 
    /* pass the viewport info to the draw module */
    draw_set_viewport_states(llvmpipe->draw, start_slot, num_viewports,
@@ -58,6 +62,26 @@ llvmpipe_set_viewport_states(struct pipe_context *pipe,
    memcpy(llvmpipe->viewports + start_slot, viewports,
           sizeof(struct pipe_viewport_state) * num_viewports);
    llvmpipe->dirty |= LP_NEW_VIEWPORT;
+
+   /* Let triangles extend guard_band pixels past any of the viewports
+    * before draw clips them in x/y, setup scissors them to the viewport.
+    */
+   if (screen->guard_band) {
+      float guard_band[2] = { FLT_MAX, FLT_MAX };
+      unsigned i, j;
+
+      for (i = 0; i < PIPE_MAX_VIEWPORTS; i++) {
+         for (j = 0; j < 2; j++) {
+            float scale = fabsf(llvmpipe->viewports[i].scale[j]);
+            if (scale > 0.0f)
+               guard_band[j] = MIN2(guard_band[j],
+                                    1.0f + screen->guard_band / scale);
+         }
+      }
+
+      if (guard_band[0] != FLT_MAX && guard_band[1] != FLT_MAX)
+         draw_set_guard_band(llvmpipe->draw, guard_band[0], guard_band[1]);
+   }
 }
 
 
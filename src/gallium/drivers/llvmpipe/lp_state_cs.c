@@ -45,6 +45,7 @@
 #include "lp_memory.h"
 #include "lp_query.h"
 #include "lp_cs_tpool.h"
+#include "lp_flush.h"
 #include "frontend/sw_winsys.h"
 #include "nir/nir_to_tgsi_info.h"
 #include "util/mesa-sha1.h"
@@ -1213,6 +1214,15 @@ update_csctx_ssbo(struct llvmpipe_context *llvmpipe)
 static void
 llvmpipe_cs_update_derived(struct llvmpipe_context *llvmpipe, void *input)
 {
+   struct llvmpipe_screen *lp_screen = llvmpipe_screen(llvmpipe->pipe.screen);
+
+   /* Check for updated textures, e.g. converted from the tiled layout.
+    */
+   if (llvmpipe->cs_tex_timestamp != lp_screen->timestamp) {
+      llvmpipe->cs_tex_timestamp = lp_screen->timestamp;
+      llvmpipe->cs_dirty |= LP_CSNEW_SAMPLER_VIEW;
+   }
+
    if (llvmpipe->cs_dirty & LP_CSNEW_CONSTANTS) {
       lp_csctx_set_cs_constants(llvmpipe->csctx,
                                 ARRAY_SIZE(llvmpipe->constants[PIPE_SHADER_COMPUTE]),
@@ -1312,6 +1322,47 @@ fill_grid_size(struct pipe_context *pipe,
    pipe_buffer_unmap(pipe, transfer);
 }
 
+/**
+ * Compute shaders run on the cs thread pool, outside of the scenes, so
+ * wait for scenes in flight that still use their resources.
+ */
+static void
+llvmpipe_cs_sync_resources(struct llvmpipe_context *llvmpipe)
+{
+   struct pipe_context *pipe = &llvmpipe->pipe;
+   unsigned i;
+
+   for (i = 0; i < llvmpipe->num_sampler_views[PIPE_SHADER_COMPUTE]; i++) {
+      struct pipe_sampler_view *view =
+         llvmpipe->sampler_views[PIPE_SHADER_COMPUTE][i];
+
+      if (view)
+         llvmpipe_flush_resource(pipe, view->texture, 0, TRUE, TRUE, FALSE,
+                                 "launch_grid");
+   }
+
+   for (i = 0; i < llvmpipe->num_images[PIPE_SHADER_COMPUTE]; i++) {
+      const struct pipe_image_view *image =
+         &llvmpipe->images[PIPE_SHADER_COMPUTE][i];
+
+      if (image->resource)
+         llvmpipe_flush_resource(pipe, image->resource, 0,
+                                 !(image->access & PIPE_IMAGE_ACCESS_WRITE),
+                                 TRUE, FALSE, "launch_grid");
+   }
+
+   for (i = 0; i < ARRAY_SIZE(llvmpipe->ssbos[PIPE_SHADER_COMPUTE]); i++) {
+      struct pipe_resource *buffer =
+         llvmpipe->ssbos[PIPE_SHADER_COMPUTE][i].buffer;
+      unsigned write_mask = llvmpipe->ssbo_write_mask[PIPE_SHADER_COMPUTE];
+
+      if (buffer)
+         llvmpipe_flush_resource(pipe, buffer, 0,
+                                 !(write_mask & (1u << i)), TRUE, FALSE,
+                                 "launch_grid");
+   }
+}
+
 static void llvmpipe_launch_grid(struct pipe_context *pipe,
                                  const struct pipe_grid_info *info)
 {
@@ -1324,6 +1375,7 @@ static void llvmpipe_launch_grid(struct pipe_context *pipe,
 
    memset(&job_info, 0, sizeof(job_info));
 
+   llvmpipe_cs_sync_resources(llvmpipe);
    llvmpipe_cs_update_derived(llvmpipe, info->input);
 
    fill_grid_size(pipe, info, job_info.grid_size);
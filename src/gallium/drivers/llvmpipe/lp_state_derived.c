@@ -281,7 +281,7 @@ void llvmpipe_update_derived( struct llvmpipe_context *llvmpipe )
                                           llvmpipe->num_samplers[PIPE_SHADER_FRAGMENT],
                                           llvmpipe->samplers[PIPE_SHADER_FRAGMENT]);
 
-   if (llvmpipe->dirty & LP_NEW_VIEWPORT) {
+   if (llvmpipe->dirty & (LP_NEW_VIEWPORT | LP_NEW_RASTERIZER)) {
       /*
        * Update setup and fragment's view of the active viewport state.
        *
@@ -101,6 +101,7 @@
 #include "lp_setup.h"
 #include "lp_state.h"
 #include "lp_tex_sample.h"
+#include "lp_texture.h"
 #include "lp_flush.h"
 #include "lp_state_fs.h"
 #include "lp_rast.h"
@@ -108,6 +109,7 @@
 
 #include "lp_screen.h"
 #include "compiler/nir/nir_serialize.h"
+#include "util/hash_table.h"
 #include "util/mesa-sha1.h"
 /** Fragment shader number (for debugging) */
 static unsigned fs_no = 0;
@@ -2905,8 +2907,7 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
  * 2x2 pixels.
  */
 static void
-generate_fragment(struct llvmpipe_context *lp,
-                  struct lp_fragment_shader *shader,
+generate_fragment(struct lp_fragment_shader *shader,
                   struct lp_fragment_shader_variant *variant,
                   unsigned partial_mask)
 {
@@ -3434,31 +3435,469 @@ lp_debug_fs_variant(struct lp_fragment_shader_variant *variant)
    debug_printf("\n");
 }
 
+/**
+ * Hash the shader IR once, at shader creation.  Together with the variant
+ * key this identifies the generated code.
+ */
 static void
-lp_fs_get_ir_cache_key(struct lp_fragment_shader_variant *variant,
-                            unsigned char ir_sha1_cache_key[20])
+lp_fs_get_ir_sha1(struct lp_fragment_shader *shader)
 {
-   struct blob blob = { 0 };
-   unsigned ir_size;
-   void *ir_binary;
+   if (shader->base.type == PIPE_SHADER_IR_TGSI) {
+      _mesa_sha1_compute(shader->base.tokens,
+                         tgsi_num_tokens(shader->base.tokens) *
+                         sizeof(struct tgsi_token),
+                         shader->ir_sha1);
+   } else {
+      struct blob blob = { 0 };
 
-   blob_init(&blob);
-   nir_serialize(&blob, variant->shader->base.ir.nir, true);
-   ir_binary = blob.data;
-   ir_size = blob.size;
+      blob_init(&blob);
+      nir_serialize(&blob, shader->base.ir.nir, true);
+      _mesa_sha1_compute(blob.data, blob.size, shader->ir_sha1);
+      blob_finish(&blob);
+   }
+}
 
+static void
+lp_fs_get_variant_cache_key(const struct lp_fragment_shader *shader,
+                            const struct lp_fragment_shader_variant_key *key,
+                            unsigned char sha1[20])
+{
    struct mesa_sha1 ctx;
    _mesa_sha1_init(&ctx);
-   _mesa_sha1_update(&ctx, &variant->key, variant->shader->variant_key_size);
-   _mesa_sha1_update(&ctx, ir_binary, ir_size);
-   _mesa_sha1_final(&ctx, ir_sha1_cache_key);
+   _mesa_sha1_update(&ctx, key, shader->variant_key_size);
+   _mesa_sha1_update(&ctx, shader->ir_sha1, sizeof shader->ir_sha1);
+   _mesa_sha1_final(&ctx, sha1);
+}
+
+
+static uint32_t
+lp_fs_variant_cache_hash(const void *key)
+{
+   return _mesa_hash_data(key, 20);
+}
+
+static bool
+lp_fs_variant_cache_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, 20) == 0;
+}
+
+void
+lp_fs_variant_cache_init(struct llvmpipe_screen *screen)
+{
+   (void) mtx_init(&screen->fs_variant_cache_mutex, mtx_plain);
+   screen->fs_variant_cache =
+      _mesa_hash_table_create(NULL, lp_fs_variant_cache_hash,
+                              lp_fs_variant_cache_equal);
+}
+
+void
+lp_fs_variant_cache_destroy(struct llvmpipe_screen *screen)
+{
+   /* All contexts are gone, so every entry must have been released. */
+   assert(!screen->fs_variant_cache ||
+          _mesa_hash_table_num_entries(screen->fs_variant_cache) == 0);
+   _mesa_hash_table_destroy(screen->fs_variant_cache, NULL);
+   mtx_destroy(&screen->fs_variant_cache_mutex);
+}
+
+
+/**
+ * Look up compiled code in the screen's variant cache, returning a new
+ * reference to it, or NULL if it must be compiled.
+ */
+static struct lp_fs_variant_code *
+lp_fs_variant_cache_find(struct llvmpipe_screen *screen,
+                         const unsigned char sha1[20])
+{
+   struct lp_fs_variant_code *code = NULL;
+   struct hash_entry *entry;
+
+   if (!screen->fs_variant_cache)
+      return NULL;
+
+   mtx_lock(&screen->fs_variant_cache_mutex);
+   entry = _mesa_hash_table_search(screen->fs_variant_cache, sha1);
+   if (entry) {
+      code = entry->data;
+      pipe_reference(NULL, &code->reference);
+      screen->num_fs_variant_cache_hits++;
+   } else {
+      screen->num_fs_variant_cache_misses++;
+   }
+   mtx_unlock(&screen->fs_variant_cache_mutex);
+
+   return code;
+}
+
+
+static void
+lp_fs_variant_code_destroy(struct lp_fs_variant_code *code)
+{
+   gallivm_destroy(code->gallivm);
+   FREE(code);
+}
+
+
+/**
+ * Publish freshly compiled code in the screen's variant cache.
+ *
+ * Another context may have compiled the same variant concurrently, in which
+ * case the code already in the cache wins and ours is discarded.
+ */
+static struct lp_fs_variant_code *
+lp_fs_variant_cache_insert(struct llvmpipe_screen *screen,
+                           struct lp_fs_variant_code *code)
+{
+   struct hash_entry *entry;
+
+   if (!screen->fs_variant_cache)
+      return code;
+
+   mtx_lock(&screen->fs_variant_cache_mutex);
+   entry = _mesa_hash_table_search(screen->fs_variant_cache, code->sha1);
+   if (entry) {
+      struct lp_fs_variant_code *cached = entry->data;
+      pipe_reference(NULL, &cached->reference);
+      mtx_unlock(&screen->fs_variant_cache_mutex);
+      lp_fs_variant_code_destroy(code);
+      return cached;
+   }
+   _mesa_hash_table_insert(screen->fs_variant_cache, code->sha1, code);
+   mtx_unlock(&screen->fs_variant_cache_mutex);
+
+   return code;
+}
+
+
+/**
+ * Drop a reference to shared variant code, freeing it when the last
+ * context lets go of it.  The cache lock is held so that a concurrent
+ * lookup can't resurrect code that is being destroyed.
+ */
+static void
+lp_fs_variant_code_release(struct llvmpipe_screen *screen,
+                           struct lp_fs_variant_code *code)
+{
+   boolean destroy;
+
+   mtx_lock(&screen->fs_variant_cache_mutex);
+   destroy = pipe_reference(&code->reference, NULL);
+   if (destroy && screen->fs_variant_cache)
+      _mesa_hash_table_remove_key(screen->fs_variant_cache, code->sha1);
+   mtx_unlock(&screen->fs_variant_cache_mutex);
+
+   if (destroy)
+      lp_fs_variant_code_destroy(code);
+}
+
+
+/**
+ * Compile the code for a fragment shader variant.
+ *
+ * Code compiled below GALLIVM_OPT_FULL only stands in until the optimized
+ * code is ready, see lp_fs_variant_count_draw().  It is private to the variant
+ * and never cached.
+ */
+static struct lp_fs_variant_code *
+compile_variant(struct llvmpipe_screen *screen,
+                LLVMContextRef context,
+                struct lp_fragment_shader *shader,
+                struct lp_fragment_shader_variant *variant,
+                const unsigned char sha1[20],
+                enum gallivm_opt_level opt_level)
+{
+   static const char *opt_suffix[] = { "", "_fast", "_noopt" };
+   struct lp_fs_variant_code *code;
+   char module_name[64];
+   struct lp_cached_code cached = { 0 };
+   bool needs_caching = false;
+
+   code = CALLOC_STRUCT(lp_fs_variant_code);
+   if (!code)
+      return NULL;
+
+   pipe_reference_init(&code->reference, 1);
+   memcpy(code->sha1, sha1, sizeof code->sha1);
+
+   snprintf(module_name, sizeof(module_name), "fs%u_variant%u%s",
+            shader->no, variant->no, opt_suffix[opt_level]);
+
+   if (shader->base.ir.nir && opt_level == GALLIVM_OPT_FULL) {
+      lp_disk_cache_find_shader(screen, &cached, code->sha1);
+      if (!cached.data_size)
+         needs_caching = true;
+   }
+   variant->gallivm = gallivm_create(module_name, context,
+                                     opt_level == GALLIVM_OPT_FULL ?
+                                     &cached : NULL);
+   if (!variant->gallivm) {
+      FREE(code);
+      return NULL;
+   }
+   variant->gallivm->opt_level = opt_level;
+
+   lp_jit_init_types(variant);
+
+   /* Left over from compiling a lower tier */
+   variant->function[RAST_EDGE_TEST] = NULL;
+   variant->function[RAST_WHOLE] = NULL;
+
+   generate_fragment(shader, variant, RAST_EDGE_TEST);
+
+   if (variant->opaque) {
+      /* Specialized shader, which doesn't need to read the color buffer. */
+      generate_fragment(shader, variant, RAST_WHOLE);
+   }
+
+   /*
+    * Compile everything
+    */
+
+   gallivm_compile_module(variant->gallivm);
+
+   code->nr_instrs = lp_build_count_ir_module(variant->gallivm->module);
+
+   if (variant->function[RAST_EDGE_TEST]) {
+      code->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
+            gallivm_jit_function(variant->gallivm,
+                                 variant->function[RAST_EDGE_TEST]);
+   }
+
+   if (variant->function[RAST_WHOLE]) {
+         code->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
+               gallivm_jit_function(variant->gallivm,
+                                    variant->function[RAST_WHOLE]);
+   } else if (!code->jit_function[RAST_WHOLE]) {
+      code->jit_function[RAST_WHOLE] = code->jit_function[RAST_EDGE_TEST];
+   }
+
+   if (needs_caching) {
+      lp_disk_cache_insert_shader(screen, &cached, code->sha1);
+   }
+
+   gallivm_free_ir(variant->gallivm);
+
+   code->gallivm = variant->gallivm;
+   variant->gallivm = NULL;
+
+   return code;
+}
+
+
+/**
+ * A variant's optimized code being compiled on the screen's compile queue,
+ * see LP_ASYNC_COMPILE.
+ */
+struct lp_fs_compile_job
+{
+   struct util_queue_fence fence;
+   struct llvmpipe_screen *screen;
+
+   /* Private copies of the shader and variant, as generating code modifies
+    * the NIR and the variant's LLVM state, which the application thread
+    * must not see change underneath it.
+    */
+   struct lp_fragment_shader shader;
+   struct lp_fragment_shader_variant *variant;
+
+   unsigned char sha1[20];
+
+   /* The result, NULL if compilation failed */
+   struct lp_fs_variant_code *code;
+};
+
+
+static void
+lp_fs_compile_job_execute(void *data, int thread_index)
+{
+   struct lp_fs_compile_job *job = data;
+   LLVMContextRef context;
+
+   context = LLVMContextCreate();
+   if (!context)
+      return;
 
-   blob_finish(&blob);
+   job->code = compile_variant(job->screen, context, &job->shader,
+                               job->variant, job->sha1, GALLIVM_OPT_FULL);
+   if (job->code)
+      job->code = lp_fs_variant_cache_insert(job->screen, job->code);
+
+   /* The JIT'ed code doesn't depend on the context once the IR is freed. */
+   LLVMContextDispose(context);
+}
+
+
+static struct lp_fs_compile_job *
+lp_fs_queue_compile_job(struct llvmpipe_screen *screen,
+                        struct lp_fragment_shader *shader,
+                        const struct lp_fragment_shader_variant *variant,
+                        const unsigned char sha1[20])
+{
+   size_t variant_size =
+      sizeof *variant + shader->variant_key_size - sizeof variant->key;
+   struct lp_fs_compile_job *job;
+
+   job = CALLOC_STRUCT(lp_fs_compile_job);
+   if (!job)
+      return NULL;
+
+   job->variant = MALLOC(variant_size);
+   if (!job->variant) {
+      FREE(job);
+      return NULL;
+   }
+
+   job->shader = *shader;
+   if (shader->base.ir.nir) {
+      job->shader.base.ir.nir = nir_shader_clone(NULL, shader->base.ir.nir);
+      if (!job->shader.base.ir.nir) {
+         FREE(job->variant);
+         FREE(job);
+         return NULL;
+      }
+   }
+
+   memcpy(job->variant, variant, variant_size);
+   job->variant->shader = &job->shader;
+   job->screen = screen;
+   memcpy(job->sha1, sha1, sizeof job->sha1);
+
+   util_queue_fence_init(&job->fence);
+   p_atomic_inc(&screen->num_fs_compile_jobs);
+   util_queue_add_job(&screen->compile_queue, job, &job->fence,
+                      lp_fs_compile_job_execute, NULL, 0);
+
+   return job;
+}
+
+
+/**
+ * Free a compile job, which must have completed or been dropped.  The
+ * caller takes over job->code.
+ */
+static void
+lp_fs_compile_job_destroy(struct lp_fs_compile_job *job)
+{
+   struct llvmpipe_screen *screen = job->screen;
+
+   util_queue_fence_destroy(&job->fence);
+   ralloc_free(job->shader.base.ir.nir);
+   FREE(job->variant);
+   FREE(job);
+
+   p_atomic_dec(&screen->num_fs_compile_jobs);
+}
+
+
+static void
+lp_fs_variant_use_code(struct lp_fragment_shader_variant *variant,
+                       const struct lp_fs_variant_code *code)
+{
+   variant->jit_function[RAST_WHOLE] = code->jit_function[RAST_WHOLE];
+   variant->jit_function[RAST_EDGE_TEST] = code->jit_function[RAST_EDGE_TEST];
+   variant->nr_instrs = code->nr_instrs;
+}
+
+
+/**
+ * Switch the context's variants whose background compilation finished over
+ * to the optimized code.
+ *
+ * Must be called between scenes, with no scene of this context being
+ * rasterized, as the rasterizer reads the variants' jit functions.
+ */
+void
+lp_fs_swap_compiled_variants(struct llvmpipe_context *lp)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   struct lp_fs_variant_list_item *li;
+
+   if (!p_atomic_read(&screen->num_fs_compile_jobs))
+      return;
+
+   foreach(li, &lp->fs_variants_list) {
+      struct lp_fragment_shader_variant *variant = li->base;
+      struct lp_fs_compile_job *job = variant->compile_job;
+
+      if (!job || !util_queue_fence_is_signalled(&job->fence))
+         continue;
+
+      if (job->code) {
+         variant->code = job->code;
+         lp->nr_fs_instrs -= variant->nr_instrs;
+         lp_fs_variant_use_code(variant, variant->code);
+         lp->nr_fs_instrs += variant->nr_instrs;
+      }
+
+      variant->compile_job = NULL;
+      lp_fs_compile_job_destroy(job);
+   }
+}
+
+
+/**
+ * Count a draw with the bound fs variant, and once a variant still running
+ * fast tier code has been drawn with LP_TIER_UP_DRAWS times, replace that
+ * with fully optimized code.  With LP_ASYNC_COMPILE the optimized code is
+ * compiled in the background, and picked up by
+ * lp_fs_swap_compiled_variants().
+ */
+void
+lp_fs_variant_count_draw(struct llvmpipe_context *lp)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   struct lp_fragment_shader_variant *variant = lp->fs_variant;
+   struct lp_fs_variant_code *code;
+   unsigned char sha1[20];
+   int64_t t0, t1;
+
+   if (!variant || variant->code || variant->compile_job ||
+       ++variant->draws < screen->fs_tier_up_draws)
+      return;
+
+   lp_fs_get_variant_cache_key(variant->shader, &variant->key, sha1);
+
+   if (screen->async_compile) {
+      /* Retried on the next draw if this fails. */
+      variant->compile_job = lp_fs_queue_compile_job(screen, variant->shader,
+                                                     variant, sha1);
+      if (variant->compile_job)
+         LP_COUNT(nr_fs_tier_ups);
+      return;
+   }
+
+   code = lp_fs_variant_cache_find(screen, sha1);
+   if (code) {
+      LP_COUNT(nr_fs_tier_up_cache_hits);
+   }
+   else {
+      t0 = os_time_get();
+      code = compile_variant(screen, lp->context, variant->shader, variant,
+                             sha1, GALLIVM_OPT_FULL);
+      if (!code) {
+         /* Keep drawing with the fast tier, try again later. */
+         variant->draws = 0;
+         return;
+      }
+      t1 = os_time_get();
+      LP_COUNT_ADD(llvm_compile_time, t1 - t0);
+      LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
+      code = lp_fs_variant_cache_insert(screen, code);
+   }
+   LP_COUNT(nr_fs_tier_ups);
+
+   variant->code = code;
+   lp->nr_fs_instrs -= variant->nr_instrs;
+   lp_fs_variant_use_code(variant, code);
+   lp->nr_fs_instrs += variant->nr_instrs;
 }
 
+
 /**
  * Generate a new fragment shader variant from the shader code and
- * other state indicated by the key.
+ * other state indicated by the key.  The code is shared with other
+ * contexts through the screen's variant cache whenever possible.
  */
 static struct lp_fragment_shader_variant *
 generate_variant(struct llvmpipe_context *lp,
@@ -3469,40 +3908,22 @@ generate_variant(struct llvmpipe_context *lp,
    struct lp_fragment_shader_variant *variant;
    const struct util_format_description *cbuf0_format_desc = NULL;
    boolean fullcolormask;
-   char module_name[64];
-   unsigned char ir_sha1_cache_key[20];
-   struct lp_cached_code cached = { 0 };
-   bool needs_caching = false;
+   unsigned char sha1[20];
+   struct lp_fs_variant_code *code;
+
    variant = MALLOC(sizeof *variant + shader->variant_key_size - sizeof variant->key);
    if (!variant)
       return NULL;
 
    memset(variant, 0, sizeof(*variant));
-   snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
-            shader->no, shader->variants_created);
 
    variant->shader = shader;
    memcpy(&variant->key, key, shader->variant_key_size);
 
-   if (shader->base.ir.nir) {
-      lp_fs_get_ir_cache_key(variant, ir_sha1_cache_key);
-
-      lp_disk_cache_find_shader(screen, &cached, ir_sha1_cache_key);
-      if (!cached.data_size)
-         needs_caching = true;
-   }
-   variant->gallivm = gallivm_create(module_name, lp->context, &cached);
-   if (!variant->gallivm) {
-      FREE(variant);
-      return NULL;
-   }
-
    variant->list_item_global.base = variant;
    variant->list_item_local.base = variant;
    variant->no = shader->variants_created++;
 
-
-
    /*
     * Determine whether we are touching all channels in the color buffer.
     */
@@ -3529,45 +3950,51 @@ generate_variant(struct llvmpipe_context *lp,
       lp_debug_fs_variant(variant);
    }
 
-   lp_jit_init_types(variant);
-   
-   if (variant->jit_function[RAST_EDGE_TEST] == NULL)
-      generate_fragment(lp, shader, variant, RAST_EDGE_TEST);
-
-   if (variant->jit_function[RAST_WHOLE] == NULL) {
-      if (variant->opaque) {
-         /* Specialized shader, which doesn't need to read the color buffer. */
-         generate_fragment(lp, shader, variant, RAST_WHOLE);
-      }
-   }
-
-   /*
-    * Compile everything
-    */
+   lp_fs_get_variant_cache_key(shader, key, sha1);
 
-   gallivm_compile_module(variant->gallivm);
+   code = lp_fs_variant_cache_find(screen, sha1);
+   if (!code && (screen->async_compile || screen->fs_tier_up_draws)) {
+      /*
+       * Draw with quickly compiled code until the variant is replaced by
+       * optimized code, see lp_fs_variant_count_draw().  Without tiering,
+       * the optimized code is compiled in the background right away, and
+       * in the meantime the quickest code will do.
+       */
+      enum gallivm_opt_level opt_level = GALLIVM_OPT_FAST;
 
-   variant->nr_instrs += lp_build_count_ir_module(variant->gallivm->module);
+      if (!screen->fs_tier_up_draws) {
+         variant->compile_job = lp_fs_queue_compile_job(screen, shader,
+                                                        variant, sha1);
+         opt_level = GALLIVM_OPT_NONE;
+      }
 
-   if (variant->function[RAST_EDGE_TEST]) {
-      variant->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
-            gallivm_jit_function(variant->gallivm,
-                                 variant->function[RAST_EDGE_TEST]);
-   }
+      variant->fallback_code = compile_variant(screen, lp->context, shader,
+                                               variant, sha1, opt_level);
+      if (variant->fallback_code) {
+         lp_fs_variant_use_code(variant, variant->fallback_code);
+         return variant;
+      }
 
-   if (variant->function[RAST_WHOLE]) {
-         variant->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
-               gallivm_jit_function(variant->gallivm,
-                                    variant->function[RAST_WHOLE]);
-   } else if (!variant->jit_function[RAST_WHOLE]) {
-      variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
+      if (variant->compile_job) {
+         util_queue_fence_wait(&variant->compile_job->fence);
+         code = variant->compile_job->code;
+         lp_fs_compile_job_destroy(variant->compile_job);
+         variant->compile_job = NULL;
+      }
    }
 
-   if (needs_caching) {
-      lp_disk_cache_insert_shader(screen, &cached, ir_sha1_cache_key);
+   if (!code) {
+      code = compile_variant(screen, lp->context, shader, variant, sha1,
+                             GALLIVM_OPT_FULL);
+      if (!code) {
+         FREE(variant);
+         return NULL;
+      }
+      code = lp_fs_variant_cache_insert(screen, code);
    }
 
-   gallivm_free_ir(variant->gallivm);
+   variant->code = code;
+   lp_fs_variant_use_code(variant, code);
 
    return variant;
 }
@@ -3603,6 +4030,8 @@ llvmpipe_create_fs_state(struct pipe_context *pipe,
       nir_tgsi_scan_shader(templ->ir.nir, &shader->info.base, true);
    }
 
+   lp_fs_get_ir_sha1(shader);
+
    shader->draw_data = draw_create_fragment_shader(llvmpipe->draw, templ);
    if (shader->draw_data == NULL) {
       FREE((void *) shader->base.tokens);
@@ -3701,6 +4130,11 @@ static void
 llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                                struct lp_fragment_shader_variant *variant)
 {
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+
+   if (lp->fs_variant == variant)
+      lp->fs_variant = NULL;
+
    if ((LP_DEBUG & DEBUG_FS) || (gallivm_debug & GALLIVM_DEBUG_IR)) {
       debug_printf("llvmpipe: del fs #%u var %u v created %u v cached %u "
                    "v total cached %u inst %u total inst %u\n",
@@ -3710,7 +4144,21 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                    lp->nr_fs_variants, variant->nr_instrs, lp->nr_fs_instrs);
    }
 
-   gallivm_destroy(variant->gallivm);
+   if (variant->compile_job) {
+      struct lp_fs_compile_job *job = variant->compile_job;
+
+      util_queue_drop_job(&screen->compile_queue, &job->fence);
+      if (job->code)
+         lp_fs_variant_code_release(screen, job->code);
+      lp_fs_compile_job_destroy(job);
+   }
+
+   if (variant->code)
+      lp_fs_variant_code_release(screen, variant->code);
+
+   /* Never in the cache, and possibly sharing its sha1 with cached code. */
+   if (variant->fallback_code)
+      lp_fs_variant_code_destroy(variant->fallback_code);
 
    /* remove from shader's list */
    remove_from_list(&variant->list_item_local);
@@ -3828,6 +4276,10 @@ llvmpipe_set_shader_buffers(struct pipe_context *pipe,
       const struct pipe_shader_buffer *buffer = buffers ? &buffers[idx] : NULL;
 
       util_copy_shader_buffer(&llvmpipe->ssbos[shader][i], buffer);
+      if (writable_bitmask & (1 << idx))
+         llvmpipe->ssbo_write_mask[shader] |= 1u << i;
+      else
+         llvmpipe->ssbo_write_mask[shader] &= ~(1u << i);
 
       if (shader == PIPE_SHADER_VERTEX ||
           shader == PIPE_SHADER_GEOMETRY ||
@@ -3861,6 +4313,9 @@ llvmpipe_set_shader_images(struct pipe_context *pipe,
    for (i = start_slot, idx = 0; i < start_slot + count; i++, idx++) {
       const struct pipe_image_view *image = images ? &images[idx] : NULL;
 
+      if (image)
+         llvmpipe_resource_untile(pipe, image->resource);
+
       util_copy_image_view(&llvmpipe->images[shader][i], image);
    }
 
@@ -3905,8 +4360,8 @@ force_dst_alpha_one(unsigned factor, boolean clamped_zero)
  * We need to generate several variants of the fragment pipeline to match
  * all the combinations of the contributing state atoms.
  *
- * TODO: there is actually no reason to tie this to context state -- the
- * generated code could be cached globally in the screen.
+ * The generated code only depends on the key and the shader IR, so it is
+ * shared between contexts through the screen's variant cache.
  */
 static struct lp_fragment_shader_variant_key *
 make_variant_key(struct llvmpipe_context *lp,
@@ -4223,8 +4678,14 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
       variant = generate_variant(lp, shader, key);
       t1 = os_time_get();
       dt = t1 - t0;
-      LP_COUNT_ADD(llvm_compile_time, dt);
-      LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
+      if (variant && variant->fallback_code) {
+         LP_COUNT_ADD(llvm_fast_compile_time, dt);
+         LP_COUNT_ADD(nr_llvm_fast_compiles, 2);
+      }
+      else {
+         LP_COUNT_ADD(llvm_compile_time, dt);
+         LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
+      }
 
       /* Put the new variant into the list */
       if (variant) {
@@ -4237,6 +4698,7 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
    }
 
    /* Bind this variant */
+   lp->fs_variant = variant;
    lp_setup_set_fs_variant(lp->setup, variant);
 }
 
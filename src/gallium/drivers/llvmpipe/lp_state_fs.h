@@ -40,6 +40,9 @@
 
 struct tgsi_token;
 struct lp_fragment_shader;
+struct llvmpipe_screen;
+struct llvmpipe_context;
+struct lp_fs_compile_job;
 
 
 /** Indexes into jit_function[] array */
@@ -118,6 +121,29 @@ lp_fs_variant_key_images(struct lp_fragment_shader_variant_key *key)
       &key->samplers[key->nr_samplers];
 }
 
+/**
+ * The compiled code of a fragment shader variant.
+ *
+ * This doesn't depend on any context state, so it is shared by all the
+ * contexts of a screen through the screen's variant cache, and kept alive
+ * for as long as any context's variant references it.
+ */
+struct lp_fs_variant_code
+{
+   struct pipe_reference reference;
+
+   /** Key in the screen's variant cache, see lp_fs_get_variant_cache_key() */
+   unsigned char sha1[20];
+
+   struct gallivm_state *gallivm;
+
+   lp_jit_frag_func jit_function[2];
+
+   /* Total number of LLVM instructions generated */
+   unsigned nr_instrs;
+};
+
+
 /** doubly-linked list item */
 struct lp_fs_variant_list_item
 {
@@ -131,8 +157,23 @@ struct lp_fragment_shader_variant
 
    boolean opaque;
 
+   /* Only valid while the variant is being generated, afterwards the
+    * gallivm state is owned by the (shared) code.
+    */
    struct gallivm_state *gallivm;
 
+   struct lp_fs_variant_code *code;
+
+   /* With LP_ASYNC_COMPILE or LP_TIER_UP_DRAWS, less optimized code to draw
+    * with until 'code' is compiled, possibly by compile_job.  Kept until the
+    * variant is destroyed, as scenes binned with it may still be in flight.
+    */
+   struct lp_fs_variant_code *fallback_code;
+   struct lp_fs_compile_job *compile_job;
+
+   /* Draws done with fallback_code, see lp_fs_variant_count_draw() */
+   unsigned draws;
+
    LLVMTypeRef jit_context_ptr_type;
    LLVMTypeRef jit_thread_data_ptr_type;
    LLVMTypeRef jit_linear_context_ptr_type;
@@ -172,6 +213,9 @@ struct lp_fragment_shader
    unsigned variants_created;
    unsigned variants_cached;
 
+   /** Hash of the shader IR, combined with the variant key for caching */
+   unsigned char ir_sha1[20];
+
    /** Fragment shader input interpolation info */
    struct lp_shader_input inputs[PIPE_MAX_SHADER_INPUTS];
 };
@@ -180,4 +224,16 @@ struct lp_fragment_shader
 void
 lp_debug_fs_variant(struct lp_fragment_shader_variant *variant);
 
+void
+lp_fs_variant_cache_init(struct llvmpipe_screen *screen);
+
+void
+lp_fs_variant_cache_destroy(struct llvmpipe_screen *screen);
+
+void
+lp_fs_swap_compiled_variants(struct llvmpipe_context *lp);
+
+void
+lp_fs_variant_count_draw(struct llvmpipe_context *lp);
+
 #endif /* LP_STATE_FS_H_ */
@@ -186,6 +186,9 @@ llvmpipe_create_surface(struct pipe_context *pipe,
       }
    }
 
+   if (!llvmpipe_resource_untile(pipe, pt))
+      return NULL;
+
    ps = CALLOC_STRUCT(pipe_surface);
    if (ps) {
       pipe_reference_init(&ps->reference, 1);
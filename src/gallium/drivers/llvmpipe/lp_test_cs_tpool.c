@@ -0,0 +1,199 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Correctness test and dispatch microbenchmark for the compute shader
+ * thread pool.
+ *
+ * Every workgroup only bumps its own counter, so the numbers measure the
+ * overhead of handing out and completing workgroups.
+ */
+
+
+#include "util/u_memory.h"
+#include "util/u_cpu_detect.h"
+#include "util/os_time.h"
+#include "lp_cs_tpool.h"
+#include "lp_test.h"
+
+
+struct cs_tpool_test_job
+{
+   uint32_t *counts;
+   unsigned spin;
+};
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "ns_per_workgroup\t"
+           "threads\t"
+           "workgroups\t"
+           "spin\n");
+
+   fflush(fp);
+}
+
+
+static void
+cs_tpool_test_work(void *data, int iter_idx, struct lp_cs_local_mem *lmem)
+{
+   struct cs_tpool_test_job *job = data;
+   volatile unsigned sink = 0;
+
+   for (unsigned i = 0; i < job->spin; i++)
+      sink += i;
+
+   job->counts[iter_idx]++;
+}
+
+
+static boolean
+test_dispatch(unsigned verbose, FILE *fp,
+              struct lp_cs_tpool *pool, unsigned num_threads,
+              unsigned num_iters, unsigned spin)
+{
+   struct cs_tpool_test_job job;
+   struct lp_cs_tpool_task *task;
+   int64_t start, end;
+   double ns_per_workgroup;
+   boolean success = TRUE;
+
+   job.counts = CALLOC(MAX2(num_iters, 1), sizeof(uint32_t));
+   job.spin = spin;
+   if (!job.counts)
+      return FALSE;
+
+   start = os_time_get_nano();
+   task = lp_cs_tpool_queue_task(pool, cs_tpool_test_work, &job, num_iters);
+   lp_cs_tpool_wait_for_task(pool, &task);
+   end = os_time_get_nano();
+
+   for (unsigned i = 0; i < num_iters; i++) {
+      if (job.counts[i] != 1) {
+         success = FALSE;
+         break;
+      }
+   }
+
+   ns_per_workgroup = num_iters ? (double)(end - start) / num_iters : 0.0;
+
+   if (verbose >= 1 || !success) {
+      printf("threads %3u workgroups %7u spin %4u: %8.1f ns/workgroup%s\n",
+             num_threads, num_iters, spin, ns_per_workgroup,
+             success ? "" : " FAILED");
+      fflush(stdout);
+   }
+
+   if (fp) {
+      fprintf(fp, "%s\t%.1f\t%u\t%u\t%u\n",
+              success ? "pass" : "fail", ns_per_workgroup,
+              num_threads, num_iters, spin);
+      fflush(fp);
+   }
+
+   FREE(job.counts);
+
+   return success;
+}
+
+
+static boolean
+test_pool(unsigned verbose, FILE *fp, unsigned num_threads,
+          const unsigned *iters, unsigned num_iters_tests)
+{
+   static const unsigned spins[] = { 0, 256 };
+   struct lp_cs_tpool *pool;
+   boolean success = TRUE;
+
+   pool = lp_cs_tpool_create(num_threads);
+   if (!pool)
+      return FALSE;
+
+   for (unsigned i = 0; i < num_iters_tests; i++) {
+      for (unsigned j = 0; j < ARRAY_SIZE(spins); j++) {
+         if (!test_dispatch(verbose, fp, pool, num_threads,
+                            iters[i], spins[j]))
+            success = FALSE;
+      }
+   }
+
+   lp_cs_tpool_destroy(pool);
+
+   return success;
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   static const unsigned iters[] = { 0, 1, 7, 64, 1000, 4096, 65536, 1 << 20 };
+   unsigned max_threads = MAX2(util_cpu_caps.nr_cpus, 1);
+   boolean success = TRUE;
+
+   for (unsigned num_threads = 0; num_threads <= max_threads;
+        num_threads = num_threads ? num_threads * 2 : 1) {
+      if (!test_pool(verbose, fp, num_threads, iters, ARRAY_SIZE(iters)))
+         success = FALSE;
+   }
+
+   if (!util_is_power_of_two_or_zero(max_threads)) {
+      if (!test_pool(verbose, fp, max_threads, iters, ARRAY_SIZE(iters)))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   static const unsigned iters[] = { 0, 1, 7, 64, 1000, 4096 };
+   unsigned max_threads = MAX2(util_cpu_caps.nr_cpus, 1);
+   boolean success = TRUE;
+
+   if (!test_pool(verbose, fp, 0, iters, ARRAY_SIZE(iters)))
+      success = FALSE;
+   if (!test_pool(verbose, fp, max_threads, iters, ARRAY_SIZE(iters)))
+      success = FALSE;
+
+   return success;
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   static const unsigned iters[] = { 65536 };
+
+   return test_pool(verbose, fp, MAX2(util_cpu_caps.nr_cpus, 1),
+                    iters, ARRAY_SIZE(iters));
+}
@@ -0,0 +1,266 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Compares the AVX2 and AVX-512 triangle mask builders against the plain
+ * C reference, and times them.
+ *
+ * Variants the CPU (or the build) can't run are skipped.
+ */
+
+
+#include <stdlib.h>
+#include "util/u_memory.h"
+#include "util/u_cpu_detect.h"
+#include "util/os_time.h"
+#include "lp_rast_priv.h"
+#include "lp_test.h"
+
+
+typedef void
+(*build_masks_func)(int c, int cdiff, int dcdx, int dcdy,
+                    unsigned *outmask, unsigned *partmask);
+
+typedef unsigned
+(*build_mask_linear_func)(int c, int dcdx, int dcdy);
+
+
+struct mask_variant
+{
+   const char *name;
+   boolean supported;
+   build_masks_func build_masks;
+   build_mask_linear_func build_mask_linear;
+};
+
+
+/**
+ * Reference: bit (4 * j + i) is set if the edge function is negative at
+ * pixel (i, j) of the 4x4 block.
+ */
+static unsigned
+ref_build_mask_linear(int c, int dcdx, int dcdy)
+{
+   unsigned mask = 0;
+   unsigned i, j;
+
+   for (j = 0; j < 4; j++) {
+      for (i = 0; i < 4; i++) {
+         int32_t v = (int32_t)((uint32_t)c + i * (uint32_t)dcdx +
+                               j * (uint32_t)dcdy);
+         if (v < 0)
+            mask |= 1 << (4 * j + i);
+      }
+   }
+
+   return mask;
+}
+
+
+static void
+ref_build_masks(int c, int cdiff, int dcdx, int dcdy,
+                unsigned *outmask, unsigned *partmask)
+{
+   *outmask |= ref_build_mask_linear(c, dcdx, dcdy);
+   *partmask |= ref_build_mask_linear((int)((uint32_t)c + (uint32_t)cdiff),
+                                      dcdx, dcdy);
+}
+
+
+static unsigned
+get_variants(struct mask_variant *variants)
+{
+   unsigned n = 0;
+
+#if defined(USE_AVX2)
+   variants[n].name = "avx2";
+   variants[n].supported = util_cpu_caps.has_avx2;
+   variants[n].build_masks = lp_rast_build_masks_avx2;
+   variants[n].build_mask_linear = lp_rast_build_mask_linear_avx2;
+   n++;
+#endif
+#if defined(USE_AVX512)
+   variants[n].name = "avx512";
+   variants[n].supported = util_cpu_caps.has_avx512f;
+   variants[n].build_masks = lp_rast_build_masks_avx512;
+   variants[n].build_mask_linear = lp_rast_build_mask_linear_avx512;
+   n++;
+#endif
+
+   return n;
+}
+
+
+static int
+random_range(int range)
+{
+   return (int)(((unsigned)rand() << 16 ^ (unsigned)rand()) %
+                (2u * range + 1)) - range;
+}
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "variant\t"
+           "cases\t"
+           "ns_per_call\n");
+
+   fflush(fp);
+}
+
+
+static boolean
+test_case(unsigned verbose, const struct mask_variant *variant,
+          int c, int cdiff, int dcdx, int dcdy)
+{
+   unsigned ref_out = 0, ref_part = 0;
+   unsigned out = 0, part = 0;
+   unsigned ref_linear, linear;
+
+   ref_build_masks(c, cdiff, dcdx, dcdy, &ref_out, &ref_part);
+   variant->build_masks(c, cdiff, dcdx, dcdy, &out, &part);
+   ref_linear = ref_build_mask_linear(c, dcdx, dcdy);
+   linear = variant->build_mask_linear(c, dcdx, dcdy);
+
+   if (out != ref_out || part != ref_part || linear != ref_linear) {
+      printf("%s: c %d cdiff %d dcdx %d dcdy %d: "
+             "out %04x (expected %04x) part %04x (expected %04x) "
+             "linear %04x (expected %04x)\n",
+             variant->name, c, cdiff, dcdx, dcdy,
+             out, ref_out, part, ref_part, linear, ref_linear);
+      fflush(stdout);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+static boolean
+test_variant(unsigned verbose, FILE *fp,
+             const struct mask_variant *variant, unsigned long n)
+{
+   static const int edge_c[] = { 0, -1, 1, INT32_MIN / 4, INT32_MAX / 4 };
+   static const int edge_d[] = { 0, -1, 1, -16, 16, 1 << 20, -(1 << 20) };
+   boolean success = TRUE;
+   unsigned long cases = 0;
+   unsigned long i;
+   int64_t start, end;
+   double ns_per_call;
+   volatile unsigned sink = 0;
+
+   if (!variant->supported) {
+      if (verbose >= 1)
+         printf("%s: not supported by this CPU, skipped\n", variant->name);
+      return TRUE;
+   }
+
+   /* Boundary values: rows and columns crossing zero. */
+   for (unsigned a = 0; a < ARRAY_SIZE(edge_c); a++)
+      for (unsigned b = 0; b < ARRAY_SIZE(edge_d); b++)
+         for (unsigned d = 0; d < ARRAY_SIZE(edge_d); d++)
+            for (int off = -3; off <= 3; off++) {
+               int dcdx = edge_d[b], dcdy = edge_d[d];
+               int c = edge_c[a] + off * (dcdx ? dcdx : 1);
+               success &= test_case(verbose, variant, c, -c, dcdx, dcdy);
+               success &= test_case(verbose, variant, c, dcdx * 3 + dcdy * 3,
+                                    dcdx, dcdy);
+               cases += 2;
+            }
+
+   /* Random values small enough not to overflow across the block, like
+    * the ones setup produces.
+    */
+   for (i = 0; i < n; i++) {
+      int c = random_range(1 << 28);
+      int cdiff = random_range(1 << 26);
+      int dcdx = random_range(1 << 24);
+      int dcdy = random_range(1 << 24);
+      success &= test_case(verbose, variant, c, cdiff, dcdx, dcdy);
+      cases++;
+   }
+
+   /* Timing */
+   start = os_time_get_nano();
+   for (i = 0; i < n; i++) {
+      unsigned out = 0, part = 0;
+      variant->build_masks((int)i - (int)(n / 2), 64, -3, 5, &out, &part);
+      sink += out ^ part;
+   }
+   end = os_time_get_nano();
+   ns_per_call = n ? (double)(end - start) / n : 0.0;
+
+   if (verbose >= 1 || !success) {
+      printf("%s: %lu cases, %.2f ns/call%s\n",
+             variant->name, cases, ns_per_call, success ? "" : " FAILED");
+      fflush(stdout);
+   }
+
+   if (fp) {
+      fprintf(fp, "%s\t%s\t%lu\t%.2f\n",
+              success ? "pass" : "fail", variant->name, cases, ns_per_call);
+      fflush(fp);
+   }
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   struct mask_variant variants[2];
+   unsigned num_variants = get_variants(variants);
+   boolean success = TRUE;
+
+   if (!num_variants && verbose >= 1)
+      printf("no AVX2/AVX-512 mask builders in this build\n");
+
+   for (unsigned i = 0; i < num_variants; i++) {
+      if (!test_variant(verbose, fp, &variants[i], n))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   return test_some(verbose, fp, 1 << 20);
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_some(verbose, fp, 1);
+}
@@ -0,0 +1,604 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Sampling round-trip test for the linear and tiled texture layouts.
+ *
+ * Textures are filled from C, laid out as described for LP_TEXEL_TILE_SIZE,
+ * then sampled with nearest and bilinear filtering through both the AoS
+ * and the SoA samplers, and the results compared with filtering done in C.
+ */
+
+
+#include "util/u_memory.h"
+#include "util/u_math.h"
+#include "util/format/u_format.h"
+
+#include "gallivm/lp_bld.h"
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_debug.h"
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_sample.h"
+#include "gallivm/lp_bld_type.h"
+
+#include "lp_jit.h"
+#include "lp_test.h"
+
+
+/**
+ * Dynamic sampler state reading a lp_jit_texture and lp_jit_sampler in
+ * the test's memory, rather than from a jit context.
+ */
+struct sample_test_dynamic_state
+{
+   struct lp_sampler_dynamic_state base;
+
+   const struct lp_jit_texture *texture;
+   const struct lp_jit_sampler *sampler;
+};
+
+
+typedef void
+(*sample_ptr_t)(const void *context, const float *s, const float *t,
+                float *texels);
+
+
+static const enum pipe_format formats[] = {
+   PIPE_FORMAT_R8G8B8A8_UNORM,
+   PIPE_FORMAT_R32G32B32A32_FLOAT,
+};
+
+static const unsigned sizes[][2] = {
+   { 16, 8 },
+   { 13, 7 },
+};
+
+
+static LLVMValueRef
+sample_test_member(struct gallivm_state *gallivm,
+                   const void *member,
+                   LLVMTypeRef type,
+                   boolean emit_load)
+{
+   LLVMValueRef ptr;
+
+   ptr = LLVMBuildBitCast(gallivm->builder,
+                          lp_build_const_int_pointer(gallivm, member),
+                          LLVMPointerType(type, 0), "");
+
+   return emit_load ? LLVMBuildLoad(gallivm->builder, ptr, "") : ptr;
+}
+
+
+static LLVMTypeRef
+int32_type(struct gallivm_state *gallivm)
+{
+   return LLVMInt32TypeInContext(gallivm->context);
+}
+
+
+static LLVMTypeRef
+level_array_type(struct gallivm_state *gallivm)
+{
+   return LLVMArrayType(int32_type(gallivm), LP_MAX_TEXTURE_LEVELS);
+}
+
+
+static LLVMTypeRef
+base_ptr_type(struct gallivm_state *gallivm)
+{
+   return LLVMPointerType(LLVMInt8TypeInContext(gallivm->context), 0);
+}
+
+
+static LLVMTypeRef
+float_type(struct gallivm_state *gallivm)
+{
+   return LLVMFloatTypeInContext(gallivm->context);
+}
+
+
+static LLVMTypeRef
+border_color_type(struct gallivm_state *gallivm)
+{
+   return LLVMArrayType(float_type(gallivm), 4);
+}
+
+
+#define SAMPLE_TEST_TEXTURE_MEMBER(_name, _type, _emit_load) \
+   static LLVMValueRef \
+   sample_test_texture_##_name(const struct lp_sampler_dynamic_state *base, \
+                               struct gallivm_state *gallivm, \
+                               LLVMValueRef context_ptr, \
+                               unsigned texture_unit, \
+                               LLVMValueRef texture_unit_offset) \
+   { \
+      const struct sample_test_dynamic_state *state = \
+         (const struct sample_test_dynamic_state *)base; \
+      return sample_test_member(gallivm, &state->texture->_name, \
+                                _type(gallivm), _emit_load); \
+   }
+
+
+SAMPLE_TEST_TEXTURE_MEMBER(width,         int32_type, TRUE)
+SAMPLE_TEST_TEXTURE_MEMBER(height,        int32_type, TRUE)
+SAMPLE_TEST_TEXTURE_MEMBER(depth,         int32_type, TRUE)
+SAMPLE_TEST_TEXTURE_MEMBER(first_level,   int32_type, TRUE)
+SAMPLE_TEST_TEXTURE_MEMBER(last_level,    int32_type, TRUE)
+SAMPLE_TEST_TEXTURE_MEMBER(base,          base_ptr_type, TRUE)
+SAMPLE_TEST_TEXTURE_MEMBER(row_stride,    level_array_type, FALSE)
+SAMPLE_TEST_TEXTURE_MEMBER(img_stride,    level_array_type, FALSE)
+SAMPLE_TEST_TEXTURE_MEMBER(mip_offsets,   level_array_type, FALSE)
+SAMPLE_TEST_TEXTURE_MEMBER(num_samples,   int32_type, TRUE)
+SAMPLE_TEST_TEXTURE_MEMBER(sample_stride, int32_type, TRUE)
+
+
+#define SAMPLE_TEST_SAMPLER_MEMBER(_name, _type, _emit_load) \
+   static LLVMValueRef \
+   sample_test_sampler_##_name(const struct lp_sampler_dynamic_state *base, \
+                               struct gallivm_state *gallivm, \
+                               LLVMValueRef context_ptr, \
+                               unsigned sampler_unit) \
+   { \
+      const struct sample_test_dynamic_state *state = \
+         (const struct sample_test_dynamic_state *)base; \
+      return sample_test_member(gallivm, &state->sampler->_name, \
+                                _type(gallivm), _emit_load); \
+   }
+
+
+SAMPLE_TEST_SAMPLER_MEMBER(min_lod,      float_type, TRUE)
+SAMPLE_TEST_SAMPLER_MEMBER(max_lod,      float_type, TRUE)
+SAMPLE_TEST_SAMPLER_MEMBER(lod_bias,     float_type, TRUE)
+SAMPLE_TEST_SAMPLER_MEMBER(border_color, border_color_type, FALSE)
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "format\t"
+           "layout\t"
+           "sampler\t"
+           "filter\t"
+           "wrap\t"
+           "size\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              const struct util_format_description *desc,
+              boolean tiled,
+              boolean aos,
+              unsigned filter,
+              unsigned wrap,
+              unsigned width,
+              unsigned height,
+              boolean success)
+{
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+
+   fprintf(fp, "%s\t%s\t%s\t%s\t%s\t%ux%u\n",
+           desc->short_name,
+           tiled ? "tiled" : "linear",
+           aos ? "aos" : "soa",
+           util_str_tex_filter(filter, TRUE),
+           util_str_tex_wrap(wrap, TRUE),
+           width, height);
+
+   fflush(fp);
+}
+
+
+/**
+ * Byte offset of the texel at (x, y) in a level with the given row stride.
+ */
+static unsigned
+texel_offset(boolean tiled, unsigned block_size, unsigned row_stride,
+             unsigned x, unsigned y)
+{
+   const unsigned tile_mask = LP_TEXEL_TILE_SIZE - 1;
+
+   if (!tiled)
+      return y * row_stride + x * block_size;
+
+   return (y & ~tile_mask) * row_stride +
+          (x & ~tile_mask) * LP_TEXEL_TILE_SIZE * block_size +
+          ((y & tile_mask) * LP_TEXEL_TILE_SIZE + (x & tile_mask)) * block_size;
+}
+
+
+static int
+wrap_coord(unsigned wrap, int coord, int length)
+{
+   if (wrap == PIPE_TEX_WRAP_REPEAT)
+      return ((coord % length) + length) % length;
+
+   return CLAMP(coord, 0, length - 1);
+}
+
+
+static void
+read_texel(const struct util_format_description *desc,
+           const uint8_t *data, unsigned offset, float texel[4])
+{
+   unsigned chan;
+
+   for (chan = 0; chan < 4; ++chan) {
+      if (desc->format == PIPE_FORMAT_R32G32B32A32_FLOAT)
+         texel[chan] = ((const float *)(data + offset))[chan];
+      else
+         texel[chan] = ubyte_to_float(data[offset + chan]);
+   }
+}
+
+
+static LLVMValueRef
+add_sample_test(struct gallivm_state *gallivm,
+                const struct lp_static_texture_state *texture_state,
+                const struct lp_static_sampler_state *sampler_state,
+                struct lp_sampler_dynamic_state *dynamic_state)
+{
+   LLVMContextRef context = gallivm->context;
+   LLVMModuleRef module = gallivm->module;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_type type = lp_float32_vec4_type();
+   LLVMTypeRef vec_type = lp_build_vec_type(gallivm, type);
+   LLVMTypeRef float_ptr_type = LLVMPointerType(float_type(gallivm), 0);
+   LLVMTypeRef args[4];
+   LLVMValueRef func;
+   LLVMValueRef texels_ptr;
+   LLVMValueRef coords[5];
+   LLVMValueRef offsets[3] = { NULL };
+   LLVMValueRef texel[4];
+   LLVMBasicBlockRef block;
+   struct lp_sampler_params params;
+   unsigned chan;
+
+   args[0] = base_ptr_type(gallivm);
+   args[1] = args[2] = args[3] = float_ptr_type;
+
+   func = LLVMAddFunction(module, "sample",
+                          LLVMFunctionType(LLVMVoidTypeInContext(context),
+                                           args, ARRAY_SIZE(args), 0));
+   LLVMSetFunctionCallConv(func, LLVMCCallConv);
+
+   block = LLVMAppendBasicBlockInContext(context, func, "entry");
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   coords[0] = LLVMBuildLoad(builder,
+                             LLVMBuildBitCast(builder, LLVMGetParam(func, 1),
+                                              LLVMPointerType(vec_type, 0), ""),
+                             "s");
+   coords[1] = LLVMBuildLoad(builder,
+                             LLVMBuildBitCast(builder, LLVMGetParam(func, 2),
+                                              LLVMPointerType(vec_type, 0), ""),
+                             "t");
+   coords[2] = coords[3] = coords[4] = LLVMGetUndef(vec_type);
+
+   memset(&params, 0, sizeof params);
+   params.type = type;
+   params.sample_key = (LP_SAMPLER_OP_TEXTURE << LP_SAMPLER_OP_TYPE_SHIFT) |
+                       (LP_SAMPLER_LOD_SCALAR << LP_SAMPLER_LOD_PROPERTY_SHIFT);
+   /* Only passed through to the texture function, if one is used */
+   params.context_ptr = LLVMGetParam(func, 0);
+   params.coords = coords;
+   params.offsets = offsets;
+   params.texel = texel;
+
+   lp_build_sample_soa(texture_state, sampler_state, dynamic_state,
+                       gallivm, &params);
+
+   texels_ptr = LLVMBuildBitCast(builder, LLVMGetParam(func, 3),
+                                 LLVMPointerType(vec_type, 0), "");
+   for (chan = 0; chan < 4; ++chan) {
+      LLVMValueRef index = lp_build_const_int32(gallivm, chan);
+      LLVMBuildStore(builder, texel[chan],
+                     LLVMBuildGEP(builder, texels_ptr, &index, 1, ""));
+   }
+
+   LLVMBuildRetVoid(builder);
+
+   gallivm_verify_function(gallivm, func);
+
+   return func;
+}
+
+
+PIPE_ALIGN_STACK
+static boolean
+test_one(unsigned verbose, FILE *fp,
+         const struct util_format_description *desc,
+         boolean tiled, boolean aos,
+         unsigned filter, unsigned wrap,
+         unsigned width, unsigned height)
+{
+   const unsigned block_size = desc->block.bits / 8;
+   const unsigned row_stride = align(width, LP_TEXEL_TILE_SIZE) * block_size;
+   const unsigned img_stride = row_stride * align(height, LP_TEXEL_TILE_SIZE);
+   const boolean bilinear = filter == PIPE_TEX_FILTER_LINEAR;
+   const float eps = desc->format == PIPE_FORMAT_R32G32B32A32_FLOAT ?
+                     1e-5f : 2.0f / 255.0f;
+   struct lp_static_texture_state texture_state;
+   struct lp_static_sampler_state sampler_state;
+   struct sample_test_dynamic_state dynamic_state;
+   struct lp_jit_texture texture;
+   struct lp_jit_sampler sampler;
+   LLVMContextRef context;
+   struct gallivm_state *gallivm;
+   LLVMValueRef func;
+   sample_ptr_t sample_ptr;
+   uint8_t *data;
+   unsigned saved_perf = gallivm_perf;
+   boolean success = TRUE;
+   int x0, y0, x, y;
+
+   if (verbose >= 1)
+      printf("Testing %s %s %s %s %s %ux%u ...\n",
+             desc->short_name,
+             tiled ? "tiled" : "linear",
+             aos ? "aos" : "soa",
+             util_str_tex_filter(filter, TRUE),
+             util_str_tex_wrap(wrap, TRUE),
+             width, height);
+
+   data = align_malloc(img_stride, 16);
+   if (!data)
+      return FALSE;
+
+   for (y = 0; y < (int)height; ++y) {
+      for (x = 0; x < (int)width; ++x) {
+         uint8_t *texel = data + texel_offset(tiled, block_size, row_stride,
+                                              x, y);
+         unsigned chan;
+
+         for (chan = 0; chan < 4; ++chan) {
+            if (desc->format == PIPE_FORMAT_R32G32B32A32_FLOAT)
+               ((float *)texel)[chan] = (float)(rand() % 256) / 256.0f;
+            else
+               texel[chan] = rand() & 0xff;
+         }
+      }
+   }
+
+   memset(&texture, 0, sizeof texture);
+   texture.width = width;
+   texture.height = height;
+   texture.depth = 1;
+   texture.base = data;
+   texture.row_stride[0] = row_stride;
+   texture.img_stride[0] = img_stride;
+   texture.num_samples = 1;
+   texture.sample_stride = img_stride;
+
+   memset(&sampler, 0, sizeof sampler);
+
+   memset(&texture_state, 0, sizeof texture_state);
+   texture_state.format = desc->format;
+   texture_state.swizzle_r = PIPE_SWIZZLE_X;
+   texture_state.swizzle_g = PIPE_SWIZZLE_Y;
+   texture_state.swizzle_b = PIPE_SWIZZLE_Z;
+   texture_state.swizzle_a = PIPE_SWIZZLE_W;
+   texture_state.target = PIPE_TEXTURE_2D;
+   texture_state.pot_width = util_is_power_of_two_or_zero(width);
+   texture_state.pot_height = util_is_power_of_two_or_zero(height);
+   texture_state.pot_depth = 1;
+   texture_state.level_zero_only = 1;
+   texture_state.tiled = tiled;
+
+   memset(&sampler_state, 0, sizeof sampler_state);
+   sampler_state.wrap_s = wrap;
+   sampler_state.wrap_t = wrap;
+   sampler_state.wrap_r = wrap;
+   sampler_state.min_img_filter = filter;
+   sampler_state.mag_img_filter = filter;
+   sampler_state.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+   sampler_state.normalized_coords = 1;
+
+   memset(&dynamic_state, 0, sizeof dynamic_state);
+   dynamic_state.base.width = sample_test_texture_width;
+   dynamic_state.base.height = sample_test_texture_height;
+   dynamic_state.base.depth = sample_test_texture_depth;
+   dynamic_state.base.first_level = sample_test_texture_first_level;
+   dynamic_state.base.last_level = sample_test_texture_last_level;
+   dynamic_state.base.base_ptr = sample_test_texture_base;
+   dynamic_state.base.row_stride = sample_test_texture_row_stride;
+   dynamic_state.base.img_stride = sample_test_texture_img_stride;
+   dynamic_state.base.mip_offsets = sample_test_texture_mip_offsets;
+   dynamic_state.base.num_samples = sample_test_texture_num_samples;
+   dynamic_state.base.sample_stride = sample_test_texture_sample_stride;
+   dynamic_state.base.min_lod = sample_test_sampler_min_lod;
+   dynamic_state.base.max_lod = sample_test_sampler_max_lod;
+   dynamic_state.base.lod_bias = sample_test_sampler_lod_bias;
+   dynamic_state.base.border_color = sample_test_sampler_border_color;
+   dynamic_state.texture = &texture;
+   dynamic_state.sampler = &sampler;
+
+   if (!aos)
+      gallivm_perf |= GALLIVM_PERF_NO_AOS_SAMPLING;
+
+   context = LLVMContextCreate();
+   gallivm = gallivm_create("test_module_sample", context, NULL);
+
+   func = add_sample_test(gallivm, &texture_state, &sampler_state,
+                          &dynamic_state.base);
+
+   gallivm_compile_module(gallivm);
+
+   sample_ptr = (sample_ptr_t) gallivm_jit_function(gallivm, func);
+
+   gallivm_free_ir(gallivm);
+
+   gallivm_perf = saved_perf;
+
+   /*
+    * Sample at the texel centers for nearest filtering, at the texel
+    * corners for bilinear filtering, so that the result doesn't depend on
+    * rounding. Go one texel past the edges to exercise the wrap modes.
+    */
+   for (y0 = -1; y0 <= (int)height; ++y0) {
+      for (x0 = -1; x0 <= (int)width; x0 += 4) {
+         PIPE_ALIGN_VAR(16) float s[4];
+         PIPE_ALIGN_VAR(16) float t[4];
+         PIPE_ALIGN_VAR(16) float texels[4][4];
+         unsigned i, chan;
+
+         for (i = 0; i < 4; ++i) {
+            x = MIN2(x0 + (int)i, (int)width);
+            s[i] = ((float)x + (bilinear ? 0.0f : 0.5f)) / width;
+            t[i] = ((float)y0 + (bilinear ? 0.0f : 0.5f)) / height;
+         }
+
+         sample_ptr(NULL, s, t, &texels[0][0]);
+
+         for (i = 0; i < 4; ++i) {
+            float expected[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            boolean match = TRUE;
+
+            x = MIN2(x0 + (int)i, (int)width);
+
+            if (bilinear) {
+               unsigned j;
+
+               for (j = 0; j < 4; ++j) {
+                  float texel[4];
+                  int tx = wrap_coord(wrap, x - 1 + (int)(j & 1), width);
+                  int ty = wrap_coord(wrap, y0 - 1 + (int)(j >> 1), height);
+
+                  read_texel(desc, data,
+                             texel_offset(tiled, block_size, row_stride,
+                                          tx, ty),
+                             texel);
+                  for (chan = 0; chan < 4; ++chan)
+                     expected[chan] += 0.25f * texel[chan];
+               }
+            }
+            else {
+               read_texel(desc, data,
+                          texel_offset(tiled, block_size, row_stride,
+                                       wrap_coord(wrap, x, width),
+                                       wrap_coord(wrap, y0, height)),
+                          expected);
+            }
+
+            for (chan = 0; chan < 4; ++chan) {
+               if (fabsf(texels[chan][i] - expected[chan]) > eps)
+                  match = FALSE;
+            }
+
+            if (!match) {
+               printf("FAILED\n");
+               printf("  %s %s %s %s %s %ux%u at (%d, %d):\n",
+                      desc->short_name,
+                      tiled ? "tiled" : "linear",
+                      aos ? "aos" : "soa",
+                      util_str_tex_filter(filter, TRUE),
+                      util_str_tex_wrap(wrap, TRUE),
+                      width, height, x, y0);
+               printf("    %.9g %.9g %.9g %.9g obtained\n",
+                      texels[0][i], texels[1][i], texels[2][i], texels[3][i]);
+               printf("    %.9g %.9g %.9g %.9g expected\n",
+                      expected[0], expected[1], expected[2], expected[3]);
+               fflush(stdout);
+               success = FALSE;
+            }
+         }
+      }
+   }
+
+   gallivm_destroy(gallivm);
+   LLVMContextDispose(context);
+
+   align_free(data);
+
+   if (fp)
+      write_tsv_row(fp, desc, tiled, aos, filter, wrap, width, height,
+                    success);
+
+   return success;
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   static const unsigned filters[] = {
+      PIPE_TEX_FILTER_NEAREST,
+      PIPE_TEX_FILTER_LINEAR,
+   };
+   static const unsigned wraps[] = {
+      PIPE_TEX_WRAP_CLAMP_TO_EDGE,
+      PIPE_TEX_WRAP_REPEAT,
+   };
+   boolean success = TRUE;
+   unsigned i, tiled, aos, j, k, l;
+
+   for (i = 0; i < ARRAY_SIZE(formats); ++i) {
+      const struct util_format_description *desc =
+         util_format_description(formats[i]);
+
+      for (tiled = 0; tiled < 2; ++tiled) {
+         for (aos = 0; aos < 2; ++aos) {
+            /* Only 8 bit unorm formats can take the AoS path */
+            if (aos && !util_format_fits_8unorm(desc))
+               continue;
+
+            for (j = 0; j < ARRAY_SIZE(filters); ++j) {
+               for (k = 0; k < ARRAY_SIZE(wraps); ++k) {
+                  for (l = 0; l < ARRAY_SIZE(sizes); ++l) {
+                     if (!test_one(verbose, fp, desc, tiled, aos,
+                                   filters[j], wraps[k],
+                                   sizes[l][0], sizes[l][1]))
+                        success = FALSE;
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   printf("no test_single()");
+   return TRUE;
+}
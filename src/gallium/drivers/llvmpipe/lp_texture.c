@@ -35,6 +35,7 @@
 #include "pipe/p_context.h"
 #include "pipe/p_defines.h"
 
+#include "util/u_box.h"
 #include "util/u_inlines.h"
 #include "util/u_cpu_detect.h"
 #include "util/format/u_format.h"
@@ -60,6 +61,51 @@ static struct llvmpipe_resource resource_list;
 static unsigned id_counter = 0;
 
 
+/**
+ * Whether a texture can be stored in tiles: it must be sampled from, and
+ * may only otherwise be rendered to or bound as a shader image, which
+ * convert it to the linear layout first (see llvmpipe_resource_untile()).
+ */
+static boolean
+llvmpipe_can_tile(const struct llvmpipe_screen *screen,
+                  const struct pipe_resource *pt)
+{
+   const unsigned untile_binds = PIPE_BIND_RENDER_TARGET |
+                                 PIPE_BIND_SHADER_IMAGE;
+   const struct util_format_description *desc;
+
+   if (!screen->tiled_textures ||
+       !(pt->bind & PIPE_BIND_SAMPLER_VIEW) ||
+       (pt->bind & ~(PIPE_BIND_SAMPLER_VIEW | untile_binds)) ||
+       pt->usage == PIPE_USAGE_STAGING ||
+       pt->nr_samples > 1)
+      return FALSE;
+
+   switch (pt->target) {
+   case PIPE_TEXTURE_2D:
+   case PIPE_TEXTURE_RECT:
+   case PIPE_TEXTURE_2D_ARRAY:
+   case PIPE_TEXTURE_CUBE:
+   case PIPE_TEXTURE_CUBE_ARRAY:
+      break;
+   default:
+      return FALSE;
+   }
+
+   desc = util_format_description(pt->format);
+   switch (desc->layout) {
+   case UTIL_FORMAT_LAYOUT_PLAIN:
+   case UTIL_FORMAT_LAYOUT_S3TC:
+   case UTIL_FORMAT_LAYOUT_RGTC:
+   case UTIL_FORMAT_LAYOUT_ETC:
+   case UTIL_FORMAT_LAYOUT_BPTC:
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+
 /**
  * Conventional allocation path for non-display textures:
  * Compute strides and allocate data (unless asked not to).
@@ -90,6 +136,10 @@ llvmpipe_texture_layout(struct llvmpipe_screen *screen,
    assert(LP_MAX_TEXTURE_2D_LEVELS <= LP_MAX_TEXTURE_LEVELS);
    assert(LP_MAX_TEXTURE_3D_LEVELS <= LP_MAX_TEXTURE_LEVELS);
 
+   pt->flags &= ~LP_RESOURCE_FLAG_TILED;
+   if (llvmpipe_can_tile(screen, pt))
+      pt->flags |= LP_RESOURCE_FLAG_TILED;
+
    for (level = 0; level <= pt->last_level; level++) {
       uint64_t mipsize;
       unsigned align_x, align_y, nblocksx, nblocksy, block_size, num_slices;
@@ -114,6 +164,14 @@ llvmpipe_texture_layout(struct llvmpipe_screen *screen,
             align_y = LP_RASTER_BLOCK_SIZE;
       }
 
+      /* Tiled images are made of whole tiles */
+      if (llvmpipe_resource_is_tiled(pt)) {
+         align_x = MAX2(align_x, util_format_get_blockwidth(pt->format) *
+                                 LP_TEXEL_TILE_SIZE);
+         align_y = MAX2(align_y, util_format_get_blockheight(pt->format) *
+                                 LP_TEXEL_TILE_SIZE);
+      }
+
       nblocksx = util_format_get_nblocksx(pt->format,
                                           align(width, align_x));
       nblocksy = util_format_get_nblocksy(pt->format,
@@ -252,6 +310,7 @@ llvmpipe_resource_create_front(struct pipe_screen *_screen,
       return NULL;
 
    lpr->base = *templat;
+   lpr->base.flags &= ~LP_RESOURCE_FLAG_TILED;
    pipe_reference_init(&lpr->base.reference, 1);
    lpr->base.screen = &screen->base;
 
@@ -456,6 +515,7 @@ llvmpipe_resource_from_handle(struct pipe_screen *screen,
    }
 
    lpr->base = *template;
+   lpr->base.flags &= ~LP_RESOURCE_FLAG_TILED;
    pipe_reference_init(&lpr->base.reference, 1);
    lpr->base.screen = screen;
 
@@ -509,6 +569,118 @@ llvmpipe_resource_get_handle(struct pipe_screen *screen,
 }
 
 
+/**
+ * Copy the blocks of a box between a level of a tiled texture and a linear
+ * buffer with the given strides.
+ */
+static void
+llvmpipe_tiled_copy_box(struct llvmpipe_resource *lpr,
+                        unsigned level,
+                        const struct pipe_box *box,
+                        uint8_t *linear,
+                        unsigned stride,
+                        unsigned layer_stride,
+                        boolean to_tiled)
+{
+   const enum pipe_format format = lpr->base.format;
+   const unsigned block_size = util_format_get_blocksize(format);
+   const unsigned x0 = box->x / util_format_get_blockwidth(format);
+   const unsigned y0 = box->y / util_format_get_blockheight(format);
+   const unsigned width = util_format_get_nblocksx(format, box->width);
+   const unsigned height = util_format_get_nblocksy(format, box->height);
+   const unsigned row_stride = lpr->row_stride[level];
+   const unsigned tile_mask = LP_TEXEL_TILE_SIZE - 1;
+   unsigned x, y, z;
+
+   for (z = 0; z < box->depth; z++) {
+      uint8_t *image = (uint8_t *)lpr->tex_data + lpr->mip_offsets[level] +
+                       (box->z + z) * lpr->img_stride[level];
+
+      for (y = 0; y < height; y++) {
+         uint8_t *row = linear + z * layer_stride + y * stride;
+         const unsigned ty = y0 + y;
+
+         /* Copy the runs of blocks which are contiguous within a tile */
+         for (x = 0; x < width; ) {
+            const unsigned tx = x0 + x;
+            const unsigned run = MIN2(LP_TEXEL_TILE_SIZE - (tx & tile_mask),
+                                      width - x);
+            uint8_t *tiled = image +
+                             (ty & ~tile_mask) * row_stride +
+                             (tx & ~tile_mask) * LP_TEXEL_TILE_SIZE * block_size +
+                             ((ty & tile_mask) * LP_TEXEL_TILE_SIZE +
+                              (tx & tile_mask)) * block_size;
+
+            if (to_tiled)
+               memcpy(tiled, row + x * block_size, run * block_size);
+            else
+               memcpy(row + x * block_size, tiled, run * block_size);
+
+            x += run;
+         }
+      }
+   }
+}
+
+
+/**
+ * Convert a tiled texture to the linear layout, in place.
+ *
+ * The rasterizer and the image code only know about linear textures, so
+ * this is done the first time a tiled texture gets a surface or is bound
+ * as a shader image. The texture then stays linear.
+ *
+ * \return FALSE if out of memory
+ */
+boolean
+llvmpipe_resource_untile(struct pipe_context *pipe,
+                         struct pipe_resource *resource)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
+   struct llvmpipe_resource *lpr = llvmpipe_resource(resource);
+   uint8_t *linear;
+   unsigned level;
+
+   if (!resource || !llvmpipe_resource_is_tiled(resource))
+      return TRUE;
+
+   /* Wait for the scenes still sampling from the tiles */
+   llvmpipe_flush_resource(pipe, resource, 0,
+                           FALSE, /* read_only */
+                           TRUE, /* cpu_access */
+                           FALSE, /* do_not_block */
+                           __FUNCTION__);
+
+   /* Keep tex_data, the sampler views and the jit contexts point into it */
+   linear = MALLOC(lpr->sample_stride);
+   if (!linear)
+      return FALSE;
+
+   for (level = 0; level <= resource->last_level; level++) {
+      struct pipe_box box;
+
+      u_box_3d(0, 0, 0,
+               u_minify(resource->width0, level),
+               u_minify(resource->height0, level),
+               resource->array_size, &box);
+      llvmpipe_tiled_copy_box(lpr, level, &box,
+                              linear + lpr->mip_offsets[level],
+                              lpr->row_stride[level],
+                              lpr->img_stride[level], FALSE);
+   }
+
+   memcpy(lpr->tex_data, linear, lpr->sample_stride);
+   FREE(linear);
+
+   resource->flags &= ~LP_RESOURCE_FLAG_TILED;
+
+   /* Have all contexts rebuild the shader keys of their sampler views */
+   screen->timestamp++;
+
+   return TRUE;
+}
+
+
 void *
 llvmpipe_transfer_map_ms( struct pipe_context *pipe,
                           struct pipe_resource *resource,
@@ -602,6 +774,31 @@ llvmpipe_transfer_map_ms( struct pipe_context *pipe,
 
    format = lpr->base.format;
 
+   if (llvmpipe_resource_is_tiled(resource)) {
+      /* Map a linear copy of the box, written back when unmapping. */
+      assert(sample == 0);
+
+      pt->stride = util_format_get_stride(format, box->width);
+      pt->layer_stride = util_format_get_2d_size(format, pt->stride,
+                                                 box->height);
+      lpt->staging = MALLOC(pt->layer_stride * box->depth);
+      if (!lpt->staging) {
+         pipe_resource_reference(&pt->resource, NULL);
+         FREE(lpt);
+         return NULL;
+      }
+
+      if (!(usage & (PIPE_TRANSFER_DISCARD_RANGE |
+                     PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE)))
+         llvmpipe_tiled_copy_box(lpr, level, box, lpt->staging,
+                                 pt->stride, pt->layer_stride, FALSE);
+
+      if (usage & PIPE_TRANSFER_WRITE)
+         screen->timestamp++;
+
+      return lpt->staging;
+   }
+
    map = llvmpipe_resource_map(resource,
                                level,
                                box->z,
@@ -640,8 +837,19 @@ static void
 llvmpipe_transfer_unmap(struct pipe_context *pipe,
                         struct pipe_transfer *transfer)
 {
+   struct llvmpipe_transfer *lpt = llvmpipe_transfer(transfer);
+
    assert(transfer->resource);
 
+   if (lpt->staging) {
+      if (transfer->usage & PIPE_TRANSFER_WRITE)
+         llvmpipe_tiled_copy_box(llvmpipe_resource(transfer->resource),
+                                 transfer->level, &transfer->box,
+                                 lpt->staging, transfer->stride,
+                                 transfer->layer_stride, TRUE);
+      FREE(lpt->staging);
+   }
+
    llvmpipe_resource_unmap(transfer->resource,
                            transfer->level,
                            transfer->box.z);
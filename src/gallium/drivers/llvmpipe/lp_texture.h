@@ -31,6 +31,7 @@
 
 #include "pipe/p_state.h"
 #include "util/u_debug.h"
+#include "gallivm/lp_bld_sample.h"
 #include "lp_limits.h"
 
 
@@ -103,6 +104,9 @@ struct llvmpipe_transfer
    struct pipe_transfer base;
 
    unsigned long offset;
+
+   /** Linear copy of the mapped box, for tiled textures */
+   uint8_t *staging;
 };
 
 
@@ -132,6 +136,14 @@ void llvmpipe_init_screen_resource_funcs(struct pipe_screen *screen);
 void llvmpipe_init_context_resource_funcs(struct pipe_context *pipe);
 
 
+/** Is the texture stored in tiles? See LP_TEXEL_TILE_SIZE */
+static inline boolean
+llvmpipe_resource_is_tiled(const struct pipe_resource *resource)
+{
+   return (resource->flags & LP_RESOURCE_FLAG_TILED) != 0;
+}
+
+
 static inline boolean
 llvmpipe_resource_is_texture(const struct pipe_resource *resource)
 {
@@ -243,6 +255,10 @@ llvmpipe_is_resource_referenced( struct pipe_context *pipe,
 unsigned
 llvmpipe_get_format_alignment(enum pipe_format format);
 
+boolean
+llvmpipe_resource_untile(struct pipe_context *pipe,
+                         struct pipe_resource *resource);
+
 void *
 llvmpipe_transfer_map_ms( struct pipe_context *pipe,
 			  struct pipe_resource *resource,
@@ -49,6 +49,7 @@ struct pipe_debug_callback;
 struct pipe_depth_stencil_alpha_state;
 struct pipe_device_reset_callback;
 struct pipe_draw_info;
+struct pipe_draw_start_count;
 struct pipe_grid_info;
 struct pipe_fence_handle;
 struct pipe_framebuffer_state;
@@ -108,6 +109,21 @@ struct pipe_context {
    /*@{*/
    void (*draw_vbo)( struct pipe_context *pipe,
                      const struct pipe_draw_info *info );
+
+   /**
+    * Draw several vertex ranges with the same state, as one draw_vbo call
+    * per element of \p draws.  info->start, count and index_bias are
+    * ignored.  Draw i uses drawid info->drawid + i if
+    * info->increment_draw_id is set and info->drawid otherwise.  Draws
+    * with a zero count are skipped.  info must not be indirect or use
+    * count_from_stream_output.
+    *
+    * Optional.  util_draw_multi implements it with draw_vbo.
+    */
+   void (*multi_draw)(struct pipe_context *pipe,
+                      const struct pipe_draw_info *info,
+                      const struct pipe_draw_start_count *draws,
+                      unsigned num_draws);
    /*@}*/
 
    /**
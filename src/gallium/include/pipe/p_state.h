@@ -726,6 +726,7 @@ struct pipe_draw_info
    enum pipe_prim_type mode:8;  /**< the mode of the primitive */
    unsigned primitive_restart:1;
    unsigned has_user_indices:1; /**< if true, use index.user_buffer */
+   unsigned increment_draw_id:1; /**< multi_draw: drawid += 1 per draw */
    ubyte vertices_per_patch; /**< the number of vertices per patch */
 
    /**
@@ -786,6 +787,18 @@ struct pipe_draw_info
 };
 
 
+/**
+ * One draw of a multi_draw call.  The fields have the same meaning as the
+ * ones of the same names in pipe_draw_info.
+ */
+struct pipe_draw_start_count
+{
+   unsigned start;
+   unsigned count;
+   int index_bias;
+};
+
+
 /**
  * Information to describe a blit call.
  */
@@ -0,0 +1,146 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Measures the CPU cost of texture binding between small draws through
+ * the GL state tracker: NUM_UNITS fixed-function texture units stay
+ * bound, and the texture on unit 0 is swapped every "period" draws.
+ * Each swap dirties the st sampler and sampler view atoms, so this
+ * exercises their per-slot diffing of the bound resources.
+ *
+ * Usage: osmesa-tex-bind [period [draws]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "GL/osmesa.h"
+#include "util/macros.h"
+#include "util/os_time.h"
+
+#define WIDTH 64
+#define HEIGHT 64
+#define NUM_UNITS 8
+
+static GLuint textures[NUM_UNITS + 1];
+
+static void
+init_textures(unsigned num_units)
+{
+   const GLubyte texel[4] = { 0xff, 0x80, 0x40, 0xff };
+   unsigned i;
+
+   glGenTextures(ARRAY_SIZE(textures), textures);
+
+   for (i = 0; i < ARRAY_SIZE(textures); i++) {
+      glBindTexture(GL_TEXTURE_2D, textures[i]);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, texel);
+   }
+
+   /* textures[NUM_UNITS] is the spare one swapped onto unit 0, units
+    * other than 0 keep their texture for the whole run
+    */
+   for (i = 0; i < num_units; i++) {
+      glActiveTexture(GL_TEXTURE0 + i);
+      glBindTexture(GL_TEXTURE_2D, textures[i]);
+      glEnable(GL_TEXTURE_2D);
+   }
+   glActiveTexture(GL_TEXTURE0);
+}
+
+static void
+draw(unsigned n)
+{
+   /* swap the texture on unit 0 */
+   glBindTexture(GL_TEXTURE_2D, textures[(n & 1) ? NUM_UNITS : 0]);
+   glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+int
+main(int argc, char **argv)
+{
+   static const GLfloat verts[3][2] = {
+      { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.0f, 0.5f },
+   };
+   static GLubyte pixels[WIDTH * HEIGHT * 4];
+   OSMesaContext ctx;
+   GLint max_units;
+   unsigned num_units;
+   unsigned period = 1;
+   unsigned draws = 100000;
+   unsigned i;
+   int64_t start, end;
+   double secs;
+
+   if (argc > 1)
+      period = MAX2(atoi(argv[1]), 1);
+   if (argc > 2)
+      draws = MAX2(atoi(argv[2]), 1);
+
+   ctx = OSMesaCreateContextExt(OSMESA_RGBA, 0, 0, 0, NULL);
+   if (!ctx) {
+      fprintf(stderr, "failed to create an OSMesa context\n");
+      return 1;
+   }
+
+   if (!OSMesaMakeCurrent(ctx, pixels, GL_UNSIGNED_BYTE, WIDTH, HEIGHT)) {
+      fprintf(stderr, "failed to make the OSMesa context current\n");
+      OSMesaDestroyContext(ctx);
+      return 1;
+   }
+
+   glGetIntegerv(GL_MAX_TEXTURE_UNITS, &max_units);
+   num_units = MIN2(max_units, NUM_UNITS);
+
+   init_textures(num_units);
+
+   glEnableClientState(GL_VERTEX_ARRAY);
+   glVertexPointer(2, GL_FLOAT, 0, verts);
+
+   /* warm up: shader compilation etc. */
+   draw(0);
+   draw(1);
+   glFinish();
+
+   start = os_time_get_nano();
+   for (i = 0; i < draws; i++)
+      draw(i / period);
+   glFinish();
+   end = os_time_get_nano();
+
+   secs = (end - start) / 1e9;
+   printf("%u units, unit 0 swapped every %u draws: %.3f us/draw, %.2f Kdraws/s\n",
+          num_units, period,
+          secs * 1e6 / draws,
+          draws / secs / 1e3);
+
+   glDeleteTextures(ARRAY_SIZE(textures), textures);
+   OSMesaDestroyContext(ctx);
+
+   return 0;
+}
@@ -0,0 +1,74 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#include "bench.h"
+
+/* pipe_context */
+#include "pipe/p_context.h"
+/* pipe_screen */
+#include "pipe/p_screen.h"
+/* PIPE_TIMEOUT_INFINITE */
+#include "pipe/p_defines.h"
+
+/* constant state object helper */
+#include "cso_cache/cso_context.h"
+
+/* to get a hardware pipe driver */
+#include "pipe-loader/pipe_loader.h"
+
+void bench_init(struct bench_context *b)
+{
+	int ret;
+
+	/* find a hardware device */
+	ret = pipe_loader_probe(&b->dev, 1);
+	assert(ret);
+
+	/* init a pipe screen */
+	b->screen = pipe_loader_create_screen(b->dev);
+	assert(b->screen);
+
+	/* create the pipe driver context and cso context */
+	b->pipe = b->screen->context_create(b->screen, NULL, 0);
+	b->cso = cso_create_context(b->pipe, 0);
+}
+
+void bench_fini(struct bench_context *b)
+{
+	cso_destroy_context(b->cso);
+
+	b->pipe->destroy(b->pipe);
+	b->screen->destroy(b->screen);
+	pipe_loader_release(&b->dev, 1);
+}
+
+void bench_finish(struct bench_context *b)
+{
+	struct pipe_fence_handle *fence = NULL;
+
+	b->pipe->flush(b->pipe, &fence, 0);
+	b->screen->fence_finish(b->screen, NULL, fence, PIPE_TIMEOUT_INFINITE);
+	b->screen->fence_reference(b->screen, &fence, NULL);
+}
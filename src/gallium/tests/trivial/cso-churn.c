@@ -0,0 +1,171 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Measures the CPU cost of cso_set_blend/depth_stencil_alpha/rasterizer
+ * and cso_set_samplers while cycling through a set of distinct states,
+ * i.e. the cso cache lookup (and, for sets larger than the cache, eviction
+ * and re-creation) plus the driver bind.  Nothing is drawn.
+ *
+ * Usage: cso-churn [states [iterations]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* pipe_*_state structs */
+#include "pipe/p_state.h"
+/* pipe_context */
+#include "pipe/p_context.h"
+/* pipe_screen */
+#include "pipe/p_screen.h"
+/* PIPE_* */
+#include "pipe/p_defines.h"
+
+/* constant state object helper */
+#include "cso_cache/cso_context.h"
+
+/* FREE & CALLOC_STRUCT */
+#include "util/u_memory.h"
+/* os_time_get_nano */
+#include "util/os_time.h"
+/* bench_init & friends */
+#include "bench.h"
+
+struct program
+{
+	struct bench_context b;
+
+	unsigned num_states;
+	struct pipe_blend_state *blend;
+	struct pipe_depth_stencil_alpha_state *depthstencil;
+	struct pipe_rasterizer_state *rasterizer;
+	struct pipe_sampler_state *sampler;
+};
+
+static void init_prog(struct program *p)
+{
+	unsigned i, j;
+
+	bench_init(&p->b);
+
+	p->blend = CALLOC(p->num_states, sizeof(*p->blend));
+	p->depthstencil = CALLOC(p->num_states, sizeof(*p->depthstencil));
+	p->rasterizer = CALLOC(p->num_states, sizeof(*p->rasterizer));
+	p->sampler = CALLOC(p->num_states, sizeof(*p->sampler));
+
+	/* num_states distinct states of each kind */
+	for (i = 0; i < p->num_states; i++) {
+		struct pipe_blend_state *blend = &p->blend[i];
+		struct pipe_depth_stencil_alpha_state *dsa = &p->depthstencil[i];
+		struct pipe_rasterizer_state *rast = &p->rasterizer[i];
+		struct pipe_sampler_state *samp = &p->sampler[i];
+
+		/* spread the index over the per-RT color masks */
+		blend->independent_blend_enable = 1;
+		for (j = 0; j < PIPE_MAX_COLOR_BUFS; j++)
+			blend->rt[j].colormask = (i >> (j * 4)) & PIPE_MASK_RGBA;
+
+		dsa->alpha.enabled = 1;
+		dsa->alpha.func = PIPE_FUNC_GREATER;
+		dsa->alpha.ref_value = (float)i / p->num_states;
+
+		rast->cull_face = PIPE_FACE_NONE;
+		rast->half_pixel_center = 1;
+		rast->bottom_edge_rule = 1;
+		rast->depth_clip_near = 1;
+		rast->depth_clip_far = 1;
+		rast->point_size = 1.0f + i;
+		rast->line_width = 1.0f;
+
+		samp->wrap_s = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+		samp->wrap_t = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+		samp->wrap_r = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+		samp->min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+		samp->min_img_filter = PIPE_TEX_FILTER_NEAREST;
+		samp->mag_img_filter = PIPE_TEX_FILTER_NEAREST;
+		samp->normalized_coords = 1;
+		samp->lod_bias = (float)i / 256.0f;
+	}
+}
+
+static void close_prog(struct program *p)
+{
+	FREE(p->blend);
+	FREE(p->depthstencil);
+	FREE(p->rasterizer);
+	FREE(p->sampler);
+
+	bench_fini(&p->b);
+
+	FREE(p);
+}
+
+static void churn(struct program *p, unsigned n)
+{
+	const struct pipe_sampler_state *samplers[1];
+	unsigned i = n % p->num_states;
+
+	cso_set_blend(p->b.cso, &p->blend[i]);
+	cso_set_depth_stencil_alpha(p->b.cso, &p->depthstencil[i]);
+	cso_set_rasterizer(p->b.cso, &p->rasterizer[i]);
+
+	samplers[0] = &p->sampler[i];
+	cso_set_samplers(p->b.cso, PIPE_SHADER_FRAGMENT, 1, samplers);
+}
+
+int main(int argc, char** argv)
+{
+	struct program *p = CALLOC_STRUCT(program);
+	unsigned iterations = 1000000;
+	unsigned i;
+	int64_t start, end;
+	double secs;
+
+	p->num_states = 64;
+	if (argc > 1)
+		p->num_states = MAX2(atoi(argv[1]), 1);
+	if (argc > 2)
+		iterations = MAX2(atoi(argv[2]), 1);
+
+	init_prog(p);
+
+	/* warm up: create every state once */
+	for (i = 0; i < p->num_states; i++)
+		churn(p, i);
+
+	start = os_time_get_nano();
+	for (i = 0; i < iterations; i++)
+		churn(p, i);
+	end = os_time_get_nano();
+
+	secs = (end - start) / 1e9;
+	printf("%u states of each kind: %.1f ns/cso_set_* call\n",
+	       p->num_states, secs * 1e9 / (iterations * 4.0));
+
+	close_prog(p);
+
+	return 0;
+}
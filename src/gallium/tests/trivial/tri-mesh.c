@@ -0,0 +1,314 @@
+/**************************************************************************
+ *
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ * Microbenchmark for small triangles: renders a regular mesh of
+ * CELL x CELL pixel quads (two triangles each) covering the whole
+ * render target, a number of times, and reports the triangle rate.
+ *
+ * Usage: tri-mesh [cell size in pixels] [frames]
+ */
+
+#define WIDTH 1024
+#define HEIGHT 1024
+#define NEAR 0
+#define FAR 1
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* pipe_*_state structs */
+#include "pipe/p_state.h"
+/* pipe_context */
+#include "pipe/p_context.h"
+/* pipe_screen */
+#include "pipe/p_screen.h"
+/* PIPE_* */
+#include "pipe/p_defines.h"
+/* TGSI_SEMANTIC_{POSITION|GENERIC} */
+#include "pipe/p_shader_tokens.h"
+/* pipe_buffer_* helpers */
+#include "util/u_inlines.h"
+
+/* constant state object helper */
+#include "cso_cache/cso_context.h"
+
+/* util_draw_vertex_buffer helper */
+#include "util/u_draw_quad.h"
+/* FREE & CALLOC_STRUCT */
+#include "util/u_memory.h"
+/* util_make_[fragment|vertex]_passthrough_shader */
+#include "util/u_simple_shaders.h"
+/* os_time_get_nano */
+#include "util/os_time.h"
+/* bench_init & friends */
+#include "bench.h"
+
+struct program
+{
+	struct bench_context b;
+
+	struct pipe_blend_state blend;
+	struct pipe_depth_stencil_alpha_state depthstencil;
+	struct pipe_rasterizer_state rasterizer;
+	struct pipe_viewport_state viewport;
+	struct pipe_framebuffer_state framebuffer;
+	struct cso_velems_state velem;
+
+	void *vs;
+	void *fs;
+
+	union pipe_color_union clear_color;
+
+	struct pipe_resource *vbuf;
+	struct pipe_resource *target;
+
+	unsigned cell;
+	unsigned num_verts;
+};
+
+static void init_mesh(struct program *p)
+{
+	unsigned cols = WIDTH / p->cell;
+	unsigned rows = HEIGHT / p->cell;
+	float (*vertices)[2][4];
+	unsigned x, y, i, n = 0;
+
+	p->num_verts = cols * rows * 6;
+	vertices = MALLOC(p->num_verts * sizeof(*vertices));
+	assert(vertices);
+
+	for (y = 0; y < rows; y++) {
+		for (x = 0; x < cols; x++) {
+			/* corners of the cell in NDC */
+			float x0 = -1.0f + 2.0f * x / cols;
+			float x1 = -1.0f + 2.0f * (x + 1) / cols;
+			float y0 = -1.0f + 2.0f * y / rows;
+			float y1 = -1.0f + 2.0f * (y + 1) / rows;
+			const float quad[6][2] = {
+				{ x0, y0 }, { x1, y0 }, { x0, y1 },
+				{ x0, y1 }, { x1, y0 }, { x1, y1 },
+			};
+
+			for (i = 0; i < 6; i++, n++) {
+				vertices[n][0][0] = quad[i][0];
+				vertices[n][0][1] = quad[i][1];
+				vertices[n][0][2] = 0.0f;
+				vertices[n][0][3] = 1.0f;
+				vertices[n][1][0] = (float)x / cols;
+				vertices[n][1][1] = (float)y / rows;
+				vertices[n][1][2] = i < 3 ? 1.0f : 0.0f;
+				vertices[n][1][3] = 1.0f;
+			}
+		}
+	}
+
+	p->vbuf = pipe_buffer_create(p->b.screen, PIPE_BIND_VERTEX_BUFFER,
+				     PIPE_USAGE_DEFAULT,
+				     p->num_verts * sizeof(*vertices));
+	pipe_buffer_write(p->b.pipe, p->vbuf, 0,
+			  p->num_verts * sizeof(*vertices), vertices);
+
+	FREE(vertices);
+}
+
+static void init_prog(struct program *p)
+{
+	struct pipe_surface surf_tmpl;
+
+	bench_init(&p->b);
+
+	/* set clear color */
+	p->clear_color.f[0] = 0.3;
+	p->clear_color.f[1] = 0.1;
+	p->clear_color.f[2] = 0.3;
+	p->clear_color.f[3] = 1.0;
+
+	init_mesh(p);
+
+	/* render target texture */
+	{
+		struct pipe_resource tmplt;
+		memset(&tmplt, 0, sizeof(tmplt));
+		tmplt.target = PIPE_TEXTURE_2D;
+		tmplt.format = PIPE_FORMAT_B8G8R8A8_UNORM; /* All drivers support this */
+		tmplt.width0 = WIDTH;
+		tmplt.height0 = HEIGHT;
+		tmplt.depth0 = 1;
+		tmplt.array_size = 1;
+		tmplt.last_level = 0;
+		tmplt.bind = PIPE_BIND_RENDER_TARGET;
+
+		p->target = p->b.screen->resource_create(p->b.screen, &tmplt);
+	}
+
+	/* disabled blending/masking */
+	memset(&p->blend, 0, sizeof(p->blend));
+	p->blend.rt[0].colormask = PIPE_MASK_RGBA;
+
+	/* no-op depth/stencil/alpha */
+	memset(&p->depthstencil, 0, sizeof(p->depthstencil));
+
+	/* rasterizer */
+	memset(&p->rasterizer, 0, sizeof(p->rasterizer));
+	p->rasterizer.cull_face = PIPE_FACE_NONE;
+	p->rasterizer.half_pixel_center = 1;
+	p->rasterizer.bottom_edge_rule = 1;
+	p->rasterizer.depth_clip_near = 1;
+	p->rasterizer.depth_clip_far = 1;
+
+	surf_tmpl.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+	surf_tmpl.u.tex.level = 0;
+	surf_tmpl.u.tex.first_layer = 0;
+	surf_tmpl.u.tex.last_layer = 0;
+	/* drawing destination */
+	memset(&p->framebuffer, 0, sizeof(p->framebuffer));
+	p->framebuffer.width = WIDTH;
+	p->framebuffer.height = HEIGHT;
+	p->framebuffer.nr_cbufs = 1;
+	p->framebuffer.cbufs[0] = p->b.pipe->create_surface(p->b.pipe, p->target, &surf_tmpl);
+
+	/* viewport */
+	{
+		float half_width = (float)WIDTH / 2.0f;
+		float half_height = (float)HEIGHT / 2.0f;
+		float half_depth = ((float)FAR - (float)NEAR) / 2.0f;
+
+		p->viewport.scale[0] = half_width;
+		p->viewport.scale[1] = half_height;
+		p->viewport.scale[2] = half_depth;
+
+		p->viewport.translate[0] = half_width;
+		p->viewport.translate[1] = half_height;
+		p->viewport.translate[2] = half_depth + NEAR;
+	}
+
+	/* vertex elements state */
+	memset(&p->velem, 0, sizeof(p->velem));
+	p->velem.count = 2;
+
+	p->velem.velems[0].src_offset = 0 * 4 * sizeof(float); /* offset 0, first element */
+	p->velem.velems[0].instance_divisor = 0;
+	p->velem.velems[0].vertex_buffer_index = 0;
+	p->velem.velems[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+	p->velem.velems[1].src_offset = 1 * 4 * sizeof(float); /* offset 16, second element */
+	p->velem.velems[1].instance_divisor = 0;
+	p->velem.velems[1].vertex_buffer_index = 0;
+	p->velem.velems[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+	/* vertex shader */
+	{
+		const enum tgsi_semantic semantic_names[] =
+			{ TGSI_SEMANTIC_POSITION, TGSI_SEMANTIC_COLOR };
+		const uint semantic_indexes[] = { 0, 0 };
+		p->vs = util_make_vertex_passthrough_shader(p->b.pipe, 2, semantic_names, semantic_indexes, FALSE);
+	}
+
+	/* fragment shader */
+	p->fs = util_make_fragment_passthrough_shader(p->b.pipe,
+		    TGSI_SEMANTIC_COLOR, TGSI_INTERPOLATE_PERSPECTIVE, TRUE);
+}
+
+static void close_prog(struct program *p)
+{
+	p->b.pipe->delete_vs_state(p->b.pipe, p->vs);
+	p->b.pipe->delete_fs_state(p->b.pipe, p->fs);
+
+	pipe_surface_reference(&p->framebuffer.cbufs[0], NULL);
+	pipe_resource_reference(&p->target, NULL);
+	pipe_resource_reference(&p->vbuf, NULL);
+
+	bench_fini(&p->b);
+
+	FREE(p);
+}
+
+static void draw(struct program *p)
+{
+	/* set the render target */
+	cso_set_framebuffer(p->b.cso, &p->framebuffer);
+
+	/* clear the render target */
+	p->b.pipe->clear(p->b.pipe, PIPE_CLEAR_COLOR, NULL, &p->clear_color, 0, 0);
+
+	/* set misc state we care about */
+	cso_set_blend(p->b.cso, &p->blend);
+	cso_set_depth_stencil_alpha(p->b.cso, &p->depthstencil);
+	cso_set_rasterizer(p->b.cso, &p->rasterizer);
+	cso_set_viewport(p->b.cso, &p->viewport);
+
+	/* shaders */
+	cso_set_fragment_shader_handle(p->b.cso, p->fs);
+	cso_set_vertex_shader_handle(p->b.cso, p->vs);
+
+	/* vertex element data */
+	cso_set_vertex_elements(p->b.cso, &p->velem);
+
+	util_draw_vertex_buffer(p->b.pipe, p->b.cso,
+				p->vbuf, 0, 0,
+				PIPE_PRIM_TRIANGLES,
+				p->num_verts,
+				2); /* attribs/vert */
+}
+
+int main(int argc, char** argv)
+{
+	struct program *p = CALLOC_STRUCT(program);
+	unsigned frames = 100;
+	unsigned i;
+	int64_t start, end;
+	double secs;
+
+	p->cell = 4;
+	if (argc > 1)
+		p->cell = CLAMP(atoi(argv[1]), 1, WIDTH);
+	if (argc > 2)
+		frames = MAX2(atoi(argv[2]), 1);
+
+	init_prog(p);
+
+	/* warm up: shader compilation etc. */
+	draw(p);
+	bench_finish(&p->b);
+
+	start = os_time_get_nano();
+	for (i = 0; i < frames; i++) {
+		draw(p);
+		bench_finish(&p->b);
+	}
+	end = os_time_get_nano();
+
+	secs = (end - start) / 1e9;
+	printf("%ux%u pixel cells, %u triangles/frame: %.3f ms/frame, %.2f Mtri/s\n",
+	       p->cell, p->cell, p->num_verts / 3,
+	       secs * 1e3 / frames,
+	       (double)p->num_verts / 3 * frames / secs / 1e6);
+
+	close_prog(p);
+
+	return 0;
+}
@@ -88,9 +88,12 @@ class PrintCode(gl_XML.gl_print_base):
             out('{0};'.format(call))
             if func.marshal_call_after and not unmarshal:
                 out(func.marshal_call_after);
+        elif func.marshal_call_after and not unmarshal:
+            out('{0} result = {1};'.format(func.return_type, call))
+            out(func.marshal_call_after);
+            out('return result;')
         else:
             out('return {0};'.format(call))
-            assert not func.marshal_call_after
 
     def print_sync_dispatch(self, func):
         self.print_sync_call(func)
@@ -102,6 +105,8 @@ class PrintCode(gl_XML.gl_print_base):
         out('{')
         with indent():
             out('GET_CURRENT_CONTEXT(ctx);')
+            if func.marshal_call_before:
+                out(func.marshal_call_before);
             out('_mesa_glthread_finish_before(ctx, "{0}");'.format(func.name))
             self.print_sync_call(func)
         out('}')
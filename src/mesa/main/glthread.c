@@ -93,8 +93,22 @@ _mesa_glthread_init(struct gl_context *ctx)
    _mesa_glthread_reset_vao(&glthread->DefaultVAO);
    glthread->CurrentVAO = &glthread->DefaultVAO;
 
+   glthread->TextureBindings =
+      calloc(MAX_COMBINED_TEXTURE_IMAGE_UNITS * NUM_TEXTURE_TARGETS,
+             sizeof(GLuint));
+   if (!glthread->TextureBindings) {
+      _mesa_DeleteHashTable(glthread->VAOs);
+      util_queue_destroy(&glthread->queue);
+      return;
+   }
+
+   /* The context may have changed while glthread was disabled. */
+   glthread->ShadowValid = false;
+
    ctx->MarshalExec = _mesa_create_marshal_table(ctx);
    if (!ctx->MarshalExec) {
+      free(glthread->TextureBindings);
+      glthread->TextureBindings = NULL;
       _mesa_DeleteHashTable(glthread->VAOs);
       util_queue_destroy(&glthread->queue);
       return;
@@ -153,6 +167,8 @@ _mesa_glthread_destroy(struct gl_context *ctx)
 
    _mesa_HashDeleteAll(glthread->VAOs, free_vao, NULL);
    _mesa_DeleteHashTable(glthread->VAOs);
+   free(glthread->TextureBindings);
+   glthread->TextureBindings = NULL;
 
    ctx->GLThread.enabled = false;
 
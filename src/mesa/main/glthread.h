@@ -53,6 +53,10 @@
 #include "compiler/shader_enums.h"
 #include "main/config.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct gl_context;
 struct gl_buffer_object;
 struct _mesa_HashTable;
@@ -108,6 +112,20 @@ struct glthread_batch
    uint8_t buffer[MARSHAL_MAX_CMD_SIZE];
 };
 
+/** Enable flags shadowed by glthread, see glthread_get.c. */
+enum glthread_enable {
+   GLTHREAD_ENABLE_CULL_FACE,
+   GLTHREAD_ENABLE_DEPTH_TEST,
+   GLTHREAD_ENABLE_DITHER,
+   GLTHREAD_ENABLE_FRAMEBUFFER_SRGB,
+   GLTHREAD_ENABLE_POLYGON_OFFSET_FILL,
+   GLTHREAD_ENABLE_RASTERIZER_DISCARD,
+   GLTHREAD_ENABLE_SAMPLE_ALPHA_TO_COVERAGE,
+   GLTHREAD_ENABLE_SAMPLE_COVERAGE,
+   GLTHREAD_ENABLE_STENCIL_TEST,
+   GLTHREAD_NUM_ENABLES,
+};
+
 struct glthread_client_attrib {
    struct glthread_vao VAO;
    GLuint CurrentArrayBufferName;
@@ -175,6 +193,38 @@ struct glthread_state
    /** Currently-bound buffer object IDs. */
    GLuint CurrentArrayBufferName;
    GLuint CurrentDrawIndirectBufferName;
+   GLuint CurrentPixelPackBufferName;
+   GLuint CurrentPixelUnpackBufferName;
+
+   /**
+    * State shadowed for glGet*, glIsEnabled* and glGetError, so that they
+    * can be answered without waiting for the server thread.
+    *
+    * It's only used when ShadowValid is set.  Calls which change the state
+    * in ways glthread doesn't follow (display lists, glPopAttrib, ...)
+    * clear it, and the next query reloads everything from the context
+    * after a sync.
+    */
+   bool ShadowValid;
+
+   /** Queries known not to generate errors in this context, learnt from
+    * the first synchronous call of each.  Bits are glthread_get.c slots.
+    */
+   uint64_t ValidGetQueries;
+   uint64_t ValidEnableQueries;
+
+   GLuint ActiveTexture;            /**< Texture unit, not GL_TEXTUREi. */
+   GLuint *TextureBindings;         /**< [unit * NUM_TEXTURE_TARGETS + target] */
+   GLuint NumTextureUnitsBound;     /**< Units beyond this have no bindings. */
+   GLuint CurrentProgram;
+   GLfloat Viewport[4];
+   GLint Scissor[4];
+   GLbitfield Enables;              /**< 1 << glthread_enable */
+   GLbitfield BlendEnabled;         /**< Per draw buffer. */
+   GLbitfield ScissorEnabled;       /**< Per viewport. */
+
+   /** Error generated by glthread itself, returned by the next glGetError. */
+   GLenum GLError;
 };
 
 void _mesa_glthread_init(struct gl_context *ctx);
@@ -240,9 +290,40 @@ void _mesa_glthread_DSAAttribBinding(struct gl_context *ctx, GLuint vaobj,
                                      GLuint attribindex, GLuint bindingindex);
 void _mesa_glthread_DSAElementBuffer(struct gl_context *ctx, GLuint vaobj,
                                      GLuint buffer);
+bool _mesa_glthread_GetBooleanv(struct gl_context *ctx, GLenum pname,
+                                GLboolean *params);
+bool _mesa_glthread_GetIntegerv(struct gl_context *ctx, GLenum pname,
+                                GLint *params);
+bool _mesa_glthread_GetInteger64v(struct gl_context *ctx, GLenum pname,
+                                  GLint64 *params);
+bool _mesa_glthread_GetFloatv(struct gl_context *ctx, GLenum pname,
+                              GLfloat *params);
+bool _mesa_glthread_GetDoublev(struct gl_context *ctx, GLenum pname,
+                               GLdouble *params);
+bool _mesa_glthread_IsEnabled(struct gl_context *ctx, GLenum cap,
+                              GLboolean *result);
+bool _mesa_glthread_IsEnabledi(struct gl_context *ctx, GLenum cap,
+                               GLuint index, GLboolean *result);
+bool _mesa_glthread_GetError(struct gl_context *ctx, GLenum *result);
+void _mesa_glthread_Enable(struct gl_context *ctx, GLenum cap, bool state);
+void _mesa_glthread_Enablei(struct gl_context *ctx, GLenum cap, GLuint index,
+                            bool state);
+void _mesa_glthread_ActiveTexture(struct gl_context *ctx, GLenum texture);
+void _mesa_glthread_BindTexture(struct gl_context *ctx, GLuint unit,
+                                GLenum target, GLuint texture);
+void _mesa_glthread_DeleteTextures(struct gl_context *ctx, GLsizei n,
+                                   const GLuint *textures);
+void _mesa_glthread_Viewport(struct gl_context *ctx, GLint x, GLint y,
+                             GLsizei width, GLsizei height);
+void _mesa_glthread_Scissor(struct gl_context *ctx, GLint x, GLint y,
+                            GLsizei width, GLsizei height);
 void _mesa_glthread_PushClientAttrib(struct gl_context *ctx, GLbitfield mask,
                                      bool set_default);
 void _mesa_glthread_PopClientAttrib(struct gl_context *ctx);
 void _mesa_glthread_ClientAttribDefault(struct gl_context *ctx, GLbitfield mask);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _GLTHREAD_H*/
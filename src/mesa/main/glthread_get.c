@@ -0,0 +1,726 @@
+/*
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* glGet*, glIsEnabled* and glGetError for glthread.
+ *
+ * Apps query state like the current texture binding or viewport every
+ * frame, and each such query used to wait for the server thread.  glthread
+ * shadows the most common state instead and answers those queries on the
+ * app thread.
+ *
+ * glthread doesn't know which pnames are valid in the context, so each
+ * pname is executed synchronously the first time it's queried.  If that
+ * doesn't generate an error, the pname is remembered as valid and all later
+ * queries of it are answered from the shadow state.
+ */
+
+#include <math.h>
+
+#include "main/glthread_marshal.h"
+#include "main/dispatch.h"
+#include "main/extensions.h"
+#include "main/texobj.h"
+#include "main/texstate.h"
+
+/* Bits of glthread_state::ValidGetQueries and ValidEnableQueries. */
+enum {
+   SLOT_ACTIVE_TEXTURE,
+   SLOT_ARRAY_BUFFER_BINDING,
+   SLOT_ELEMENT_ARRAY_BUFFER_BINDING,
+   SLOT_DRAW_INDIRECT_BUFFER_BINDING,
+   SLOT_PIXEL_PACK_BUFFER_BINDING,
+   SLOT_PIXEL_UNPACK_BUFFER_BINDING,
+   SLOT_VERTEX_ARRAY_BINDING,
+   SLOT_CURRENT_PROGRAM,
+   SLOT_VIEWPORT,
+   SLOT_SCISSOR_BOX,
+   SLOT_BLEND,
+   SLOT_SCISSOR_TEST,
+   SLOT_ENABLE,                                    /* + glthread_enable */
+   SLOT_TEXTURE_BINDING = SLOT_ENABLE + GLTHREAD_NUM_ENABLES, /* + target */
+   SLOT_BLEND_INDEXED = SLOT_TEXTURE_BINDING + NUM_TEXTURE_TARGETS,
+   SLOT_SCISSOR_TEST_INDEXED,
+   NUM_SLOTS,
+};
+
+/* A shadowed value, in the type get.c stores it in. */
+struct shadow_value {
+   unsigned count;
+   bool is_float;
+   union {
+      GLint i[4];
+      GLfloat f[4];
+   };
+};
+
+static int
+get_enable_index(GLenum cap)
+{
+   switch (cap) {
+   case GL_CULL_FACE:
+      return GLTHREAD_ENABLE_CULL_FACE;
+   case GL_DEPTH_TEST:
+      return GLTHREAD_ENABLE_DEPTH_TEST;
+   case GL_DITHER:
+      return GLTHREAD_ENABLE_DITHER;
+   case GL_FRAMEBUFFER_SRGB:
+      return GLTHREAD_ENABLE_FRAMEBUFFER_SRGB;
+   case GL_POLYGON_OFFSET_FILL:
+      return GLTHREAD_ENABLE_POLYGON_OFFSET_FILL;
+   case GL_RASTERIZER_DISCARD:
+      return GLTHREAD_ENABLE_RASTERIZER_DISCARD;
+   case GL_SAMPLE_ALPHA_TO_COVERAGE:
+      return GLTHREAD_ENABLE_SAMPLE_ALPHA_TO_COVERAGE;
+   case GL_SAMPLE_COVERAGE:
+      return GLTHREAD_ENABLE_SAMPLE_COVERAGE;
+   case GL_STENCIL_TEST:
+      return GLTHREAD_ENABLE_STENCIL_TEST;
+   default:
+      return -1;
+   }
+}
+
+/* Return the slot of a capability shadowed for glIsEnabled and glGet*,
+ * or -1.
+ */
+static int
+get_enable_slot(GLenum cap)
+{
+   switch (cap) {
+   case GL_BLEND:
+      return SLOT_BLEND;
+   case GL_SCISSOR_TEST:
+      return SLOT_SCISSOR_TEST;
+   default: {
+      int index = get_enable_index(cap);
+      return index >= 0 ? SLOT_ENABLE + index : -1;
+   }
+   }
+}
+
+/* Return the slot of a pname shadowed for glGet*, or -1. */
+static int
+get_query_slot(struct gl_context *ctx, GLenum pname)
+{
+   switch (pname) {
+   case GL_ACTIVE_TEXTURE:
+      return SLOT_ACTIVE_TEXTURE;
+   case GL_CURRENT_PROGRAM:
+      return SLOT_CURRENT_PROGRAM;
+   case GL_VIEWPORT:
+      return SLOT_VIEWPORT;
+   case GL_SCISSOR_BOX:
+      return SLOT_SCISSOR_BOX;
+   case GL_TEXTURE_BINDING_2D_MULTISAMPLE:
+      return SLOT_TEXTURE_BINDING + TEXTURE_2D_MULTISAMPLE_INDEX;
+   case GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY:
+      return SLOT_TEXTURE_BINDING + TEXTURE_2D_MULTISAMPLE_ARRAY_INDEX;
+   case GL_TEXTURE_BINDING_CUBE_MAP_ARRAY:
+      return SLOT_TEXTURE_BINDING + TEXTURE_CUBE_ARRAY_INDEX;
+   case GL_TEXTURE_BINDING_2D_ARRAY:
+      return SLOT_TEXTURE_BINDING + TEXTURE_2D_ARRAY_INDEX;
+   case GL_TEXTURE_BINDING_1D_ARRAY:
+      return SLOT_TEXTURE_BINDING + TEXTURE_1D_ARRAY_INDEX;
+   case GL_TEXTURE_BINDING_EXTERNAL_OES:
+      return SLOT_TEXTURE_BINDING + TEXTURE_EXTERNAL_INDEX;
+   case GL_TEXTURE_BINDING_CUBE_MAP:
+      return SLOT_TEXTURE_BINDING + TEXTURE_CUBE_INDEX;
+   case GL_TEXTURE_BINDING_3D:
+      return SLOT_TEXTURE_BINDING + TEXTURE_3D_INDEX;
+   case GL_TEXTURE_BINDING_RECTANGLE:
+      return SLOT_TEXTURE_BINDING + TEXTURE_RECT_INDEX;
+   case GL_TEXTURE_BINDING_2D:
+      return SLOT_TEXTURE_BINDING + TEXTURE_2D_INDEX;
+   case GL_TEXTURE_BINDING_1D:
+      return SLOT_TEXTURE_BINDING + TEXTURE_1D_INDEX;
+   }
+
+   /* Buffer and vertex array bindings are only tracked in compatibility
+    * contexts, see the COMPAT conditions in the XML.
+    */
+   if (ctx->API != API_OPENGL_CORE) {
+      switch (pname) {
+      case GL_ARRAY_BUFFER_BINDING:
+         return SLOT_ARRAY_BUFFER_BINDING;
+      case GL_ELEMENT_ARRAY_BUFFER_BINDING:
+         return SLOT_ELEMENT_ARRAY_BUFFER_BINDING;
+      case GL_DRAW_INDIRECT_BUFFER_BINDING:
+         return SLOT_DRAW_INDIRECT_BUFFER_BINDING;
+      case GL_PIXEL_PACK_BUFFER_BINDING:
+         return SLOT_PIXEL_PACK_BUFFER_BINDING;
+      case GL_PIXEL_UNPACK_BUFFER_BINDING:
+         return SLOT_PIXEL_UNPACK_BUFFER_BINDING;
+      case GL_VERTEX_ARRAY_BINDING:
+         return SLOT_VERTEX_ARRAY_BINDING;
+      }
+   }
+
+   return get_enable_slot(pname);
+}
+
+static GLuint *
+texture_binding(struct glthread_state *glthread, unsigned unit,
+                unsigned target)
+{
+   return &glthread->TextureBindings[unit * NUM_TEXTURE_TARGETS + target];
+}
+
+/* Reload the shadow state from the context.  The server thread must be
+ * idle.
+ */
+static void
+sync_shadow_state(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   unsigned num_units = _mesa_max_tex_unit(ctx);
+
+   glthread->ActiveTexture = ctx->Texture.CurrentUnit;
+   glthread->NumTextureUnitsBound = 0;
+
+   for (unsigned unit = 0; unit < num_units; unit++) {
+      for (unsigned target = 0; target < NUM_TEXTURE_TARGETS; target++) {
+         GLuint name = ctx->Texture.Unit[unit].CurrentTex[target]->Name;
+
+         *texture_binding(glthread, unit, target) = name;
+         if (name)
+            glthread->NumTextureUnitsBound = unit + 1;
+      }
+   }
+
+   glthread->CurrentPixelPackBufferName =
+      ctx->Pack.BufferObj ? ctx->Pack.BufferObj->Name : 0;
+   glthread->CurrentPixelUnpackBufferName =
+      ctx->Unpack.BufferObj ? ctx->Unpack.BufferObj->Name : 0;
+   glthread->CurrentProgram =
+      ctx->Shader.ActiveProgram ? ctx->Shader.ActiveProgram->Name : 0;
+
+   glthread->Viewport[0] = ctx->ViewportArray[0].X;
+   glthread->Viewport[1] = ctx->ViewportArray[0].Y;
+   glthread->Viewport[2] = ctx->ViewportArray[0].Width;
+   glthread->Viewport[3] = ctx->ViewportArray[0].Height;
+   glthread->Scissor[0] = ctx->Scissor.ScissorArray[0].X;
+   glthread->Scissor[1] = ctx->Scissor.ScissorArray[0].Y;
+   glthread->Scissor[2] = ctx->Scissor.ScissorArray[0].Width;
+   glthread->Scissor[3] = ctx->Scissor.ScissorArray[0].Height;
+
+   glthread->BlendEnabled = ctx->Color.BlendEnabled;
+   glthread->ScissorEnabled = ctx->Scissor.EnableFlags;
+   glthread->Enables =
+      (ctx->Polygon.CullFlag << GLTHREAD_ENABLE_CULL_FACE) |
+      (ctx->Depth.Test << GLTHREAD_ENABLE_DEPTH_TEST) |
+      (ctx->Color.DitherFlag << GLTHREAD_ENABLE_DITHER) |
+      (ctx->Color.sRGBEnabled << GLTHREAD_ENABLE_FRAMEBUFFER_SRGB) |
+      (ctx->Polygon.OffsetFill << GLTHREAD_ENABLE_POLYGON_OFFSET_FILL) |
+      (ctx->RasterDiscard << GLTHREAD_ENABLE_RASTERIZER_DISCARD) |
+      (ctx->Multisample.SampleAlphaToCoverage <<
+       GLTHREAD_ENABLE_SAMPLE_ALPHA_TO_COVERAGE) |
+      (ctx->Multisample.SampleCoverage << GLTHREAD_ENABLE_SAMPLE_COVERAGE) |
+      (ctx->Stencil.Enabled << GLTHREAD_ENABLE_STENCIL_TEST);
+
+   glthread->ShadowValid = true;
+}
+
+static bool
+get_enabled(struct glthread_state *glthread, int slot)
+{
+   switch (slot) {
+   case SLOT_BLEND:
+      return glthread->BlendEnabled & 1;
+   case SLOT_SCISSOR_TEST:
+      return glthread->ScissorEnabled & 1;
+   default:
+      return (glthread->Enables >> (slot - SLOT_ENABLE)) & 1;
+   }
+}
+
+static void
+get_shadow_value(struct gl_context *ctx, int slot, struct shadow_value *v)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   v->count = 1;
+   v->is_float = false;
+
+   switch (slot) {
+   case SLOT_ACTIVE_TEXTURE:
+      v->i[0] = GL_TEXTURE0 + glthread->ActiveTexture;
+      break;
+   case SLOT_ARRAY_BUFFER_BINDING:
+      v->i[0] = glthread->CurrentArrayBufferName;
+      break;
+   case SLOT_ELEMENT_ARRAY_BUFFER_BINDING:
+      v->i[0] = glthread->CurrentVAO->CurrentElementBufferName;
+      break;
+   case SLOT_DRAW_INDIRECT_BUFFER_BINDING:
+      v->i[0] = glthread->CurrentDrawIndirectBufferName;
+      break;
+   case SLOT_PIXEL_PACK_BUFFER_BINDING:
+      v->i[0] = glthread->CurrentPixelPackBufferName;
+      break;
+   case SLOT_PIXEL_UNPACK_BUFFER_BINDING:
+      v->i[0] = glthread->CurrentPixelUnpackBufferName;
+      break;
+   case SLOT_VERTEX_ARRAY_BINDING:
+      v->i[0] = glthread->CurrentVAO->Name;
+      break;
+   case SLOT_CURRENT_PROGRAM:
+      v->i[0] = glthread->CurrentProgram;
+      break;
+   case SLOT_VIEWPORT:
+      v->count = 4;
+      v->is_float = true;
+      memcpy(v->f, glthread->Viewport, sizeof(v->f));
+      break;
+   case SLOT_SCISSOR_BOX:
+      v->count = 4;
+      memcpy(v->i, glthread->Scissor, sizeof(v->i));
+      break;
+   default:
+      if (slot >= SLOT_TEXTURE_BINDING) {
+         v->i[0] = *texture_binding(glthread, glthread->ActiveTexture,
+                                    slot - SLOT_TEXTURE_BINDING);
+      } else {
+         v->i[0] = get_enabled(glthread, slot);
+      }
+      break;
+   }
+}
+
+/* Sync with the server thread before executing a query synchronously, and
+ * return the error state it has to be compared against.
+ */
+static GLenum
+begin_sync_query(struct gl_context *ctx, const char *func)
+{
+   _mesa_glthread_finish_before(ctx, func);
+
+   /* The server thread is idle, so refresh the shadow state while here. */
+   if (!ctx->GLThread.ShadowValid)
+      sync_shadow_state(ctx);
+
+   return ctx->ErrorValue;
+}
+
+/* If the synchronous query generated no error, all later queries of the
+ * same slot can be answered from the shadow state.
+ */
+static void
+end_sync_query(struct gl_context *ctx, uint64_t *valid, int slot,
+               GLenum prev_error)
+{
+   STATIC_ASSERT(NUM_SLOTS <= 64);
+
+   if (prev_error == GL_NO_ERROR && ctx->ErrorValue == GL_NO_ERROR)
+      *valid |= BITFIELD64_BIT(slot);
+}
+
+/* Return the shadow slot if pname can be answered by the shadow state now,
+ * -1 if the query must be executed by the caller after begin_sync_query,
+ * or -2 if it must be marshalled normally.
+ */
+static int
+lookup_query(struct gl_context *ctx, GLenum pname)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   int slot = get_query_slot(ctx, pname);
+
+   if (slot < 0 || glthread->inside_dlist)
+      return -2;
+
+   if (!(glthread->ValidGetQueries & BITFIELD64_BIT(slot)))
+      return -1;
+
+   if (!glthread->ShadowValid) {
+      _mesa_glthread_finish_before(ctx, "reload shadow state");
+      sync_shadow_state(ctx);
+   }
+   return slot;
+}
+
+/* The conversions below match get.c. */
+
+bool
+_mesa_glthread_GetBooleanv(struct gl_context *ctx, GLenum pname,
+                           GLboolean *params)
+{
+   int slot = lookup_query(ctx, pname);
+   struct shadow_value v;
+
+   if (slot == -2)
+      return false;
+
+   if (slot == -1) {
+      GLenum error = begin_sync_query(ctx, "GetBooleanv");
+      CALL_GetBooleanv(ctx->CurrentServerDispatch, (pname, params));
+      end_sync_query(ctx, &ctx->GLThread.ValidGetQueries,
+                     get_query_slot(ctx, pname), error);
+      return true;
+   }
+
+   get_shadow_value(ctx, slot, &v);
+   for (unsigned i = 0; i < v.count; i++)
+      params[i] = (v.is_float ? v.f[i] != 0.0f : v.i[i] != 0) ?
+                  GL_TRUE : GL_FALSE;
+   return true;
+}
+
+bool
+_mesa_glthread_GetIntegerv(struct gl_context *ctx, GLenum pname,
+                           GLint *params)
+{
+   int slot = lookup_query(ctx, pname);
+   struct shadow_value v;
+
+   if (slot == -2)
+      return false;
+
+   if (slot == -1) {
+      GLenum error = begin_sync_query(ctx, "GetIntegerv");
+      CALL_GetIntegerv(ctx->CurrentServerDispatch, (pname, params));
+      end_sync_query(ctx, &ctx->GLThread.ValidGetQueries,
+                     get_query_slot(ctx, pname), error);
+      return true;
+   }
+
+   get_shadow_value(ctx, slot, &v);
+   for (unsigned i = 0; i < v.count; i++)
+      params[i] = v.is_float ? lroundf(v.f[i]) : v.i[i];
+   return true;
+}
+
+bool
+_mesa_glthread_GetInteger64v(struct gl_context *ctx, GLenum pname,
+                             GLint64 *params)
+{
+   int slot = lookup_query(ctx, pname);
+   struct shadow_value v;
+
+   if (slot == -2)
+      return false;
+
+   if (slot == -1) {
+      GLenum error = begin_sync_query(ctx, "GetInteger64v");
+      CALL_GetInteger64v(ctx->CurrentServerDispatch, (pname, params));
+      end_sync_query(ctx, &ctx->GLThread.ValidGetQueries,
+                     get_query_slot(ctx, pname), error);
+      return true;
+   }
+
+   get_shadow_value(ctx, slot, &v);
+   for (unsigned i = 0; i < v.count; i++)
+      params[i] = v.is_float ? llround(v.f[i]) : v.i[i];
+   return true;
+}
+
+bool
+_mesa_glthread_GetFloatv(struct gl_context *ctx, GLenum pname,
+                         GLfloat *params)
+{
+   int slot = lookup_query(ctx, pname);
+   struct shadow_value v;
+
+   if (slot == -2)
+      return false;
+
+   if (slot == -1) {
+      GLenum error = begin_sync_query(ctx, "GetFloatv");
+      CALL_GetFloatv(ctx->CurrentServerDispatch, (pname, params));
+      end_sync_query(ctx, &ctx->GLThread.ValidGetQueries,
+                     get_query_slot(ctx, pname), error);
+      return true;
+   }
+
+   get_shadow_value(ctx, slot, &v);
+   for (unsigned i = 0; i < v.count; i++)
+      params[i] = v.is_float ? v.f[i] : (GLfloat) v.i[i];
+   return true;
+}
+
+bool
+_mesa_glthread_GetDoublev(struct gl_context *ctx, GLenum pname,
+                          GLdouble *params)
+{
+   int slot = lookup_query(ctx, pname);
+   struct shadow_value v;
+
+   if (slot == -2)
+      return false;
+
+   if (slot == -1) {
+      GLenum error = begin_sync_query(ctx, "GetDoublev");
+      CALL_GetDoublev(ctx->CurrentServerDispatch, (pname, params));
+      end_sync_query(ctx, &ctx->GLThread.ValidGetQueries,
+                     get_query_slot(ctx, pname), error);
+      return true;
+   }
+
+   get_shadow_value(ctx, slot, &v);
+   for (unsigned i = 0; i < v.count; i++)
+      params[i] = v.is_float ? v.f[i] : (GLdouble) v.i[i];
+   return true;
+}
+
+bool
+_mesa_glthread_IsEnabled(struct gl_context *ctx, GLenum cap,
+                         GLboolean *result)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   int slot = get_enable_slot(cap);
+
+   if (slot < 0 || glthread->inside_dlist)
+      return false;
+
+   if (!(glthread->ValidEnableQueries & BITFIELD64_BIT(slot))) {
+      GLenum error = begin_sync_query(ctx, "IsEnabled");
+      *result = CALL_IsEnabled(ctx->CurrentServerDispatch, (cap));
+      end_sync_query(ctx, &glthread->ValidEnableQueries, slot, error);
+      return true;
+   }
+
+   if (!glthread->ShadowValid) {
+      _mesa_glthread_finish_before(ctx, "reload shadow state");
+      sync_shadow_state(ctx);
+   }
+
+   *result = get_enabled(glthread, slot);
+   return true;
+}
+
+bool
+_mesa_glthread_IsEnabledi(struct gl_context *ctx, GLenum cap, GLuint index,
+                          GLboolean *result)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   unsigned max_index;
+   GLbitfield *enabled;
+   int slot;
+
+   switch (cap) {
+   case GL_BLEND:
+      slot = SLOT_BLEND_INDEXED;
+      max_index = ctx->Const.MaxDrawBuffers;
+      enabled = &glthread->BlendEnabled;
+      break;
+   case GL_SCISSOR_TEST:
+      slot = SLOT_SCISSOR_TEST_INDEXED;
+      max_index = ctx->Const.MaxViewports;
+      enabled = &glthread->ScissorEnabled;
+      break;
+   default:
+      return false;
+   }
+
+   if (glthread->inside_dlist)
+      return false;
+
+   if (!(glthread->ValidEnableQueries & BITFIELD64_BIT(slot))) {
+      GLenum error = begin_sync_query(ctx, "IsEnabledi");
+      *result = CALL_IsEnabledi(ctx->CurrentServerDispatch, (cap, index));
+      /* An out-of-range index says nothing about the query itself. */
+      if (index < max_index)
+         end_sync_query(ctx, &glthread->ValidEnableQueries, slot, error);
+      return true;
+   }
+
+   /* The query is valid, so only the index can be wrong.  The error is
+    * reported by the next glGetError.
+    */
+   if (index >= max_index) {
+      if (glthread->GLError == GL_NO_ERROR)
+         glthread->GLError = GL_INVALID_VALUE;
+      *result = GL_FALSE;
+      return true;
+   }
+
+   if (!glthread->ShadowValid) {
+      _mesa_glthread_finish_before(ctx, "reload shadow state");
+      sync_shadow_state(ctx);
+   }
+
+   *result = (*enabled >> index) & 1;
+   return true;
+}
+
+bool
+_mesa_glthread_GetError(struct gl_context *ctx, GLenum *result)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   /* Errors are returned in any order if several are recorded, so the one
+    * generated by glthread can be returned before the server thread's.
+    */
+   if (glthread->GLError != GL_NO_ERROR) {
+      *result = glthread->GLError;
+      glthread->GLError = GL_NO_ERROR;
+      return true;
+   }
+   return false;
+}
+
+void
+_mesa_glthread_Enable(struct gl_context *ctx, GLenum cap, bool state)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   int index;
+
+   switch (cap) {
+   case GL_BLEND:
+      glthread->BlendEnabled = state * ((1 << ctx->Const.MaxDrawBuffers) - 1);
+      break;
+   case GL_SCISSOR_TEST:
+      glthread->ScissorEnabled = state * ((1 << ctx->Const.MaxViewports) - 1);
+      break;
+   default:
+      index = get_enable_index(cap);
+      if (index < 0)
+         return;
+
+      if (state)
+         glthread->Enables |= 1u << index;
+      else
+         glthread->Enables &= ~(1u << index);
+      break;
+   }
+}
+
+void
+_mesa_glthread_Enablei(struct gl_context *ctx, GLenum cap, GLuint index,
+                       bool state)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   GLbitfield *enabled;
+
+   switch (cap) {
+   case GL_BLEND:
+      if (!ctx->Extensions.EXT_draw_buffers2 ||
+          index >= ctx->Const.MaxDrawBuffers)
+         return;
+      enabled = &glthread->BlendEnabled;
+      break;
+   case GL_SCISSOR_TEST:
+      if (index >= ctx->Const.MaxViewports)
+         return;
+      enabled = &glthread->ScissorEnabled;
+      break;
+   default:
+      return;
+   }
+
+   if (state)
+      *enabled |= 1u << index;
+   else
+      *enabled &= ~(1u << index);
+}
+
+void
+_mesa_glthread_ActiveTexture(struct gl_context *ctx, GLenum texture)
+{
+   GLuint unit = texture - GL_TEXTURE0;
+
+   if (unit < _mesa_max_tex_unit(ctx))
+      ctx->GLThread.ActiveTexture = unit;
+}
+
+void
+_mesa_glthread_BindTexture(struct gl_context *ctx, GLuint unit,
+                           GLenum target, GLuint texture)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   int index;
+
+   if (unit >= _mesa_max_tex_unit(ctx))
+      return;
+
+   index = _mesa_tex_target_to_index(ctx, target);
+   if (index < 0)
+      return;
+
+   *texture_binding(glthread, unit, index) = texture;
+   if (texture)
+      glthread->NumTextureUnitsBound =
+         MAX2(glthread->NumTextureUnitsBound, unit + 1);
+}
+
+void
+_mesa_glthread_DeleteTextures(struct gl_context *ctx, GLsizei n,
+                              const GLuint *textures)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   unsigned num = glthread->NumTextureUnitsBound * NUM_TEXTURE_TARGETS;
+
+   if (!textures || n < 0)
+      return;
+
+   /* Deleted textures are unbound from all units. */
+   for (unsigned i = 0; i < n; i++) {
+      if (!textures[i])
+         continue;
+
+      for (unsigned j = 0; j < num; j++) {
+         if (glthread->TextureBindings[j] == textures[i])
+            glthread->TextureBindings[j] = 0;
+      }
+   }
+}
+
+void
+_mesa_glthread_Viewport(struct gl_context *ctx, GLint x, GLint y,
+                        GLsizei width, GLsizei height)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+   GLfloat fx = x, fy = y;
+
+   if (width < 0 || height < 0)
+      return;
+
+   /* Same as clamp_viewport in viewport.c. */
+   if (_mesa_has_ARB_viewport_array(ctx) ||
+       _mesa_has_OES_viewport_array(ctx)) {
+      fx = CLAMP(fx, ctx->Const.ViewportBounds.Min,
+                 ctx->Const.ViewportBounds.Max);
+      fy = CLAMP(fy, ctx->Const.ViewportBounds.Min,
+                 ctx->Const.ViewportBounds.Max);
+   }
+
+   glthread->Viewport[0] = fx;
+   glthread->Viewport[1] = fy;
+   glthread->Viewport[2] = MIN2((GLfloat) width,
+                                (GLfloat) ctx->Const.MaxViewportWidth);
+   glthread->Viewport[3] = MIN2((GLfloat) height,
+                                (GLfloat) ctx->Const.MaxViewportHeight);
+}
+
+void
+_mesa_glthread_Scissor(struct gl_context *ctx, GLint x, GLint y,
+                       GLsizei width, GLsizei height)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   if (width < 0 || height < 0)
+      return;
+
+   glthread->Scissor[0] = x;
+   glthread->Scissor[1] = y;
+   glthread->Scissor[2] = width;
+   glthread->Scissor[3] = height;
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2026 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \name glthread_get.cpp
+ *
+ * Verify that the glGet* and glIsEnabled queries glthread answers from its
+ * shadow state return what the context would, including after calls that
+ * change state behind glthread's back: glPopAttrib, display list replay and
+ * multi-bind.
+ *
+ * Each pname is queried once before the calls under test, so that glthread
+ * has marked it as valid and answers all later queries itself.
+ */
+
+#include <gtest/gtest.h>
+
+#include "GL/gl.h"
+#include "GL/glext.h"
+#include "util/compiler.h"
+#include "main/api_exec.h"
+#include "main/context.h"
+#include "main/glthread.h"
+#include "main/remap.h"
+#include "main/vtxfmt.h"
+#include "glapi/glapi.h"
+#include "drivers/common/driverfuncs.h"
+
+#include "vbo/vbo.h"
+
+#ifndef GLAPIENTRYP
+#define GLAPIENTRYP GL_APIENTRYP
+#endif
+
+#include "main/dispatch.h"
+
+class GLThreadGet_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   void expect_viewport(GLint x, GLint y, GLint w, GLint h);
+   GLint get_integer(GLenum pname);
+   GLboolean is_enabled(GLenum cap);
+   GLenum get_error();
+
+   struct _glapi_table *dispatch() { return ctx.CurrentClientDispatch; }
+
+   struct gl_config visual;
+   struct dd_function_table driver_functions;
+   struct gl_context ctx;
+};
+
+static void
+set_background_context(struct gl_context *ctx,
+                       struct util_queue_monitoring *queue_info)
+{
+   /* The test context has no driver state to set up. */
+}
+
+void
+GLThreadGet_test::SetUp()
+{
+   memset(&visual, 0, sizeof(visual));
+   memset(&driver_functions, 0, sizeof(driver_functions));
+   memset(&ctx, 0, sizeof(ctx));
+
+   _mesa_init_driver_functions(&driver_functions);
+   driver_functions.SetBackgroundContext = set_background_context;
+
+   _mesa_initialize_context(&ctx,
+                            API_OPENGL_COMPAT,
+                            &visual,
+                            NULL, // share_list
+                            &driver_functions);
+   _vbo_CreateContext(&ctx, false);
+
+   _mesa_override_extensions(&ctx);
+   ctx.Version = 45;
+
+   _mesa_initialize_dispatch_tables(&ctx);
+   _mesa_initialize_vbo_vtxfmt(&ctx);
+
+   _mesa_make_current(&ctx, NULL, NULL);
+
+   _mesa_glthread_init(&ctx);
+   ASSERT_TRUE(ctx.GLThread.enabled);
+   _glapi_set_dispatch(ctx.CurrentClientDispatch);
+}
+
+void
+GLThreadGet_test::TearDown()
+{
+   _mesa_glthread_destroy(&ctx);
+   _mesa_make_current(NULL, NULL, NULL);
+   _mesa_free_context_data(&ctx, true);
+}
+
+GLint
+GLThreadGet_test::get_integer(GLenum pname)
+{
+   GLint value = -1;
+
+   CALL_GetIntegerv(dispatch(), (pname, &value));
+   return value;
+}
+
+GLboolean
+GLThreadGet_test::is_enabled(GLenum cap)
+{
+   return CALL_IsEnabled(dispatch(), (cap));
+}
+
+GLenum
+GLThreadGet_test::get_error()
+{
+   return CALL_GetError(dispatch(), ());
+}
+
+void
+GLThreadGet_test::expect_viewport(GLint x, GLint y, GLint w, GLint h)
+{
+   GLint vp[4] = { -1, -1, -1, -1 };
+
+   CALL_GetIntegerv(dispatch(), (GL_VIEWPORT, vp));
+   EXPECT_EQ(x, vp[0]);
+   EXPECT_EQ(y, vp[1]);
+   EXPECT_EQ(w, vp[2]);
+   EXPECT_EQ(h, vp[3]);
+}
+
+TEST_F(GLThreadGet_test, shadow_matches_setters)
+{
+   CALL_Viewport(dispatch(), (1, 2, 3, 4));
+   CALL_Enable(dispatch(), (GL_DEPTH_TEST));
+
+   /* The first query of each pname is synchronous, the second one comes
+    * from the shadow state.
+    */
+   for (unsigned i = 0; i < 2; i++) {
+      expect_viewport(1, 2, 3, 4);
+      EXPECT_EQ(GL_TRUE, is_enabled(GL_DEPTH_TEST));
+   }
+
+   CALL_Viewport(dispatch(), (5, 6, 7, 8));
+   CALL_Disable(dispatch(), (GL_DEPTH_TEST));
+   expect_viewport(5, 6, 7, 8);
+   EXPECT_EQ(GL_FALSE, is_enabled(GL_DEPTH_TEST));
+
+   EXPECT_EQ((GLenum) GL_NO_ERROR, get_error());
+}
+
+TEST_F(GLThreadGet_test, pop_attrib)
+{
+   CALL_Viewport(dispatch(), (1, 2, 3, 4));
+   expect_viewport(1, 2, 3, 4);
+   EXPECT_EQ(GL_FALSE, is_enabled(GL_DEPTH_TEST));
+
+   CALL_PushAttrib(dispatch(), (GL_VIEWPORT_BIT | GL_ENABLE_BIT));
+   CALL_Viewport(dispatch(), (5, 6, 7, 8));
+   CALL_Enable(dispatch(), (GL_DEPTH_TEST));
+   expect_viewport(5, 6, 7, 8);
+   EXPECT_EQ(GL_TRUE, is_enabled(GL_DEPTH_TEST));
+
+   /* glthread doesn't follow glPopAttrib, it has to reload its state. */
+   CALL_PopAttrib(dispatch(), ());
+   expect_viewport(1, 2, 3, 4);
+   EXPECT_EQ(GL_FALSE, is_enabled(GL_DEPTH_TEST));
+
+   EXPECT_EQ((GLenum) GL_NO_ERROR, get_error());
+}
+
+TEST_F(GLThreadGet_test, display_list)
+{
+   GLuint list;
+
+   CALL_Viewport(dispatch(), (1, 2, 3, 4));
+   expect_viewport(1, 2, 3, 4);
+   EXPECT_EQ(GL_FALSE, is_enabled(GL_DEPTH_TEST));
+
+   list = CALL_GenLists(dispatch(), (1));
+   ASSERT_NE(0u, list);
+
+   /* Compiling the list must not change the state. */
+   CALL_NewList(dispatch(), (list, GL_COMPILE));
+   CALL_Viewport(dispatch(), (5, 6, 7, 8));
+   CALL_Enable(dispatch(), (GL_DEPTH_TEST));
+   CALL_EndList(dispatch(), ());
+   expect_viewport(1, 2, 3, 4);
+   EXPECT_EQ(GL_FALSE, is_enabled(GL_DEPTH_TEST));
+
+   /* Replaying it must. */
+   CALL_CallList(dispatch(), (list));
+   expect_viewport(5, 6, 7, 8);
+   EXPECT_EQ(GL_TRUE, is_enabled(GL_DEPTH_TEST));
+
+   CALL_DeleteLists(dispatch(), (list, 1));
+   EXPECT_EQ((GLenum) GL_NO_ERROR, get_error());
+}
+
+TEST_F(GLThreadGet_test, multi_bind)
+{
+   GLuint tex[2];
+
+   CALL_GenTextures(dispatch(), (2, tex));
+
+   /* Binding creates the texture objects with their target. */
+   CALL_BindTexture(dispatch(), (GL_TEXTURE_2D, tex[1]));
+   CALL_BindTexture(dispatch(), (GL_TEXTURE_2D, tex[0]));
+   EXPECT_EQ((GLint) tex[0], get_integer(GL_TEXTURE_BINDING_2D));
+   EXPECT_EQ((GLint) tex[0], get_integer(GL_TEXTURE_BINDING_2D));
+   EXPECT_EQ(GL_TEXTURE0, get_integer(GL_ACTIVE_TEXTURE));
+
+   /* glthread doesn't follow glBindTextures, it has to reload its state. */
+   CALL_BindTextures(dispatch(), (0, 2, tex));
+   EXPECT_EQ((GLint) tex[0], get_integer(GL_TEXTURE_BINDING_2D));
+   CALL_ActiveTexture(dispatch(), (GL_TEXTURE1));
+   EXPECT_EQ(GL_TEXTURE1, get_integer(GL_ACTIVE_TEXTURE));
+   EXPECT_EQ((GLint) tex[1], get_integer(GL_TEXTURE_BINDING_2D));
+
+   CALL_BindTextures(dispatch(), (0, 2, NULL));
+   EXPECT_EQ(0, get_integer(GL_TEXTURE_BINDING_2D));
+   CALL_ActiveTexture(dispatch(), (GL_TEXTURE0));
+   EXPECT_EQ(0, get_integer(GL_TEXTURE_BINDING_2D));
+
+   CALL_DeleteTextures(dispatch(), (2, tex));
+   EXPECT_EQ((GLenum) GL_NO_ERROR, get_error());
+}
@@ -200,6 +200,8 @@ st_bind_ubos(struct st_context *st, struct gl_program *prog,
 {
    unsigned i;
    struct pipe_constant_buffer cb = { 0 };
+   struct pipe_constant_buffer *bound = st->state.ubos[shader_type];
+   uint32_t *valid = &st->state.valid_ubos[shader_type];
 
    if (!prog)
       return;
@@ -229,6 +231,15 @@ st_bind_ubos(struct st_context *st, struct gl_program *prog,
          cb.buffer_size = 0;
       }
 
+      /* Only rebind the slots that changed. */
+      if (*valid & BITFIELD_BIT(i) && !memcmp(&bound[i], &cb, sizeof(cb)))
+         continue;
+
+      pipe_resource_reference(&bound[i].buffer, cb.buffer);
+      bound[i].buffer_offset = cb.buffer_offset;
+      bound[i].buffer_size = cb.buffer_size;
+      *valid |= BITFIELD_BIT(i);
+
       cso_set_constant_buffer(st->cso_context, shader_type, 1 + i, &cb);
    }
 }
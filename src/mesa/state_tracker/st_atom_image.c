@@ -161,6 +161,9 @@ st_bind_images(struct st_context *st, struct gl_program *prog,
 {
    unsigned i;
    struct pipe_image_view images[MAX_IMAGE_UNIFORMS];
+   struct pipe_image_view *bound = st->state.images[shader_type];
+   uint32_t *valid = &st->state.valid_images[shader_type];
+   unsigned dirty = 0;
    struct gl_program_constants *c;
 
    if (!prog || !st->pipe->set_shader_images)
@@ -171,16 +174,45 @@ st_bind_images(struct st_context *st, struct gl_program *prog,
    for (i = 0; i < prog->info.num_images; i++) {
       struct pipe_image_view *img = &images[i];
 
+      /* Clear the padding, so that images can be compared with memcmp. */
+      memset(img, 0, sizeof(*img));
       st_convert_image_from_unit(st, img, prog->sh.ImageUnits[i],
                                  prog->sh.ImageAccess[i]);
+
+      /* Writable images are always rebound, because drivers track
+       * writes when they are bound.
+       */
+      if (img->access & PIPE_IMAGE_ACCESS_WRITE ||
+          !(*valid & BITFIELD_BIT(i)) || memcmp(&bound[i], img, sizeof(*img))) {
+         /* Take the reference before copying, which also copies the
+          * resource pointer.
+          */
+         pipe_resource_reference(&bound[i].resource, img->resource);
+         bound[i] = *img;
+         dirty |= BITFIELD_BIT(i);
+      }
    }
-   cso_set_shader_images(st->cso_context, shader_type, 0,
-                         prog->info.num_images, images);
+
+   /* Only rebind the ranges of slots that changed. */
+   while (dirty) {
+      int start, count;
+
+      u_bit_scan_consecutive_range(&dirty, &start, &count);
+      cso_set_shader_images(st->cso_context, shader_type, start, count,
+                            images + start);
+   }
+
    /* clear out any stale shader images */
-   if (prog->info.num_images < c->MaxImageUniforms)
+   if (prog->info.num_images < c->MaxImageUniforms &&
+       (*valid & ~BITFIELD_MASK(prog->info.num_images))) {
       cso_set_shader_images(
             st->cso_context, shader_type, prog->info.num_images,
             c->MaxImageUniforms - prog->info.num_images, NULL);
+
+      for (i = prog->info.num_images; i < MAX_IMAGE_UNIFORMS; i++)
+         pipe_resource_reference(&bound[i].resource, NULL);
+   }
+   *valid = BITFIELD_MASK(prog->info.num_images);
 }
 
 void st_bind_vs_images(struct st_context *st)
@@ -257,27 +257,23 @@ st_convert_sampler_from_unit(const struct st_context *st,
 static void
 update_shader_samplers(struct st_context *st,
                        enum pipe_shader_type shader_stage,
-                       const struct gl_program *prog,
-                       struct pipe_sampler_state *samplers,
-                       unsigned *out_num_samplers)
+                       const struct gl_program *prog)
 {
    struct gl_context *ctx = st->ctx;
+   struct pipe_sampler_state *samplers = st->state.samplers[shader_stage];
+   uint32_t *valid = &st->state.valid_samplers[shader_stage];
    GLbitfield samplers_used = prog->SamplersUsed;
    GLbitfield free_slots = ~prog->SamplersUsed;
    GLbitfield external_samplers_used = prog->ExternalSamplersUsed;
    unsigned unit, num_samplers;
-   struct pipe_sampler_state local_samplers[PIPE_MAX_SAMPLERS];
    const struct pipe_sampler_state *states[PIPE_MAX_SAMPLERS];
+   uint32_t dirty = 0, extra_slots = 0;
 
    if (samplers_used == 0x0) {
-      if (out_num_samplers)
-         *out_num_samplers = 0;
+      st->state.num_samplers[shader_stage] = 0;
       return;
    }
 
-   if (!samplers)
-      samplers = local_samplers;
-
    num_samplers = util_last_bit(samplers_used);
 
    /* loop over sampler units (aka tex image units) */
@@ -290,7 +286,14 @@ update_shader_samplers(struct st_context *st,
        */
       if (samplers_used & 1 &&
           ctx->Texture.Unit[tex_unit]._Current->Target != GL_TEXTURE_BUFFER) {
-         st_convert_sampler_from_unit(st, sampler, tex_unit);
+         struct pipe_sampler_state tmp;
+
+         st_convert_sampler_from_unit(st, &tmp, tex_unit);
+         if (!(*valid & BITFIELD_BIT(unit)) ||
+             memcmp(sampler, &tmp, sizeof(tmp))) {
+            *sampler = tmp;
+            dirty |= BITFIELD_BIT(unit);
+         }
          states[unit] = sampler;
       } else {
          states[unit] = NULL;
@@ -322,13 +325,16 @@ update_shader_samplers(struct st_context *st,
          /* we need one additional sampler: */
          extra = u_bit_scan(&free_slots);
          states[extra] = sampler;
+         extra_slots |= BITFIELD_BIT(extra);
          break;
       case PIPE_FORMAT_IYUV:
          /* we need two additional samplers: */
          extra = u_bit_scan(&free_slots);
          states[extra] = sampler;
+         extra_slots |= BITFIELD_BIT(extra);
          extra = u_bit_scan(&free_slots);
          states[extra] = sampler;
+         extra_slots |= BITFIELD_BIT(extra);
          break;
       default:
          break;
@@ -337,10 +343,19 @@ update_shader_samplers(struct st_context *st,
       num_samplers = MAX2(num_samplers, extra + 1);
    }
 
-   cso_set_samplers(st->cso_context, shader_stage, num_samplers, states);
+   /* If no slot changed, the driver still has the same samplers bound.
+    * Otherwise cso_context binds them all, but it only looks up the states
+    * of the dirty slots.
+    */
+   if (dirty || extra_slots ||
+       num_samplers != st->state.num_samplers[shader_stage]) {
+      cso_set_samplers(st->cso_context, shader_stage, num_samplers, states);
+
+      /* The extra slots aren't shadowed in st->state.samplers. */
+      *valid = (*valid | dirty) & ~extra_slots;
+   }
 
-   if (out_num_samplers)
-      *out_num_samplers = num_samplers;
+   st->state.num_samplers[shader_stage] = num_samplers;
 }
 
 
@@ -351,9 +366,7 @@ st_update_vertex_samplers(struct st_context *st)
 
    update_shader_samplers(st,
                           PIPE_SHADER_VERTEX,
-                          ctx->VertexProgram._Current,
-                          st->state.vert_samplers,
-                          &st->state.num_vert_samplers);
+                          ctx->VertexProgram._Current);
 }
 
 
@@ -365,7 +378,7 @@ st_update_tessctrl_samplers(struct st_context *st)
    if (ctx->TessCtrlProgram._Current) {
       update_shader_samplers(st,
                              PIPE_SHADER_TESS_CTRL,
-                             ctx->TessCtrlProgram._Current, NULL, NULL);
+                             ctx->TessCtrlProgram._Current);
    }
 }
 
@@ -378,7 +391,7 @@ st_update_tesseval_samplers(struct st_context *st)
    if (ctx->TessEvalProgram._Current) {
       update_shader_samplers(st,
                              PIPE_SHADER_TESS_EVAL,
-                             ctx->TessEvalProgram._Current, NULL, NULL);
+                             ctx->TessEvalProgram._Current);
    }
 }
 
@@ -391,7 +404,7 @@ st_update_geometry_samplers(struct st_context *st)
    if (ctx->GeometryProgram._Current) {
       update_shader_samplers(st,
                              PIPE_SHADER_GEOMETRY,
-                             ctx->GeometryProgram._Current, NULL, NULL);
+                             ctx->GeometryProgram._Current);
    }
 }
 
@@ -403,9 +416,7 @@ st_update_fragment_samplers(struct st_context *st)
 
    update_shader_samplers(st,
                           PIPE_SHADER_FRAGMENT,
-                          ctx->FragmentProgram._Current,
-                          st->state.frag_samplers,
-                          &st->state.num_frag_samplers);
+                          ctx->FragmentProgram._Current);
 }
 
 
@@ -417,6 +428,6 @@ st_update_compute_samplers(struct st_context *st)
    if (ctx->ComputeProgram._Current) {
       update_shader_samplers(st,
                              PIPE_SHADER_COMPUTE,
-                             ctx->ComputeProgram._Current, NULL, NULL);
+                             ctx->ComputeProgram._Current);
    }
 }
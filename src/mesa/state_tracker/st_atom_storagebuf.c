@@ -46,9 +46,15 @@ st_bind_ssbos(struct st_context *st, struct gl_program *prog,
 {
    unsigned i;
    struct pipe_shader_buffer buffers[MAX_SHADER_STORAGE_BUFFERS];
+   struct pipe_shader_buffer *bound = st->state.ssbos[shader_type];
+   uint32_t *valid = &st->state.valid_ssbos[shader_type];
+   unsigned writable, dirty = 0;
+
    if (!prog || !st->pipe->set_shader_buffers)
       return;
 
+   writable = prog->sh.ShaderStorageBlocksWriteAccess;
+
    for (i = 0; i < prog->info.num_ssbos; i++) {
       struct gl_buffer_binding *binding;
       struct st_buffer_object *st_obj;
@@ -74,10 +80,37 @@ st_bind_ssbos(struct st_context *st, struct gl_program *prog,
          sb->buffer_offset = 0;
          sb->buffer_size = 0;
       }
+
+      /* Writable buffers are always rebound, because drivers track
+       * writes when they are bound.
+       */
+      if (writable & BITFIELD_BIT(i) || !(*valid & BITFIELD_BIT(i)) ||
+          memcmp(&bound[i], sb, sizeof(*sb))) {
+         pipe_resource_reference(&bound[i].buffer, sb->buffer);
+         bound[i].buffer_offset = sb->buffer_offset;
+         bound[i].buffer_size = sb->buffer_size;
+         dirty |= BITFIELD_BIT(i);
+      }
+   }
+
+   /* Only rebind the ranges of slots that changed. */
+   while (dirty) {
+      int start, count;
+
+      u_bit_scan_consecutive_range(&dirty, &start, &count);
+      st->pipe->set_shader_buffers(st->pipe, shader_type, start, count,
+                                   buffers + start,
+                                   (writable >> start) & BITFIELD_MASK(count));
+   }
+
+   /* The slots above the SSBOs can be used by lowered atomic counters,
+    * so they are no longer known.
+    */
+   if (*valid & ~BITFIELD_MASK(prog->info.num_ssbos)) {
+      for (i = prog->info.num_ssbos; i < MAX_SHADER_STORAGE_BUFFERS; i++)
+         pipe_resource_reference(&bound[i].buffer, NULL);
    }
-   st->pipe->set_shader_buffers(st->pipe, shader_type, 0,
-                                prog->info.num_ssbos, buffers,
-                                prog->sh.ShaderStorageBlocksWriteAccess);
+   *valid = BITFIELD_MASK(prog->info.num_ssbos);
 
    /* Clear out any stale shader buffers (or lowered atomic counters). */
    int num_ssbos = prog->info.num_ssbos;
@@ -100,9 +100,11 @@ st_update_single_texture(struct st_context *st,
 static void
 update_textures(struct st_context *st,
                 enum pipe_shader_type shader_stage,
-                const struct gl_program *prog,
-                struct pipe_sampler_view **sampler_views)
+                const struct gl_program *prog)
 {
+   struct pipe_sampler_view **bound = st->state.sampler_views[shader_stage];
+   struct pipe_sampler_view *sampler_views[PIPE_MAX_SAMPLERS] = {0};
+   GLbitfield extra_views = 0;
    const GLuint old_max = st->state.num_sampler_views[shader_stage];
    GLbitfield samplers_used = prog->SamplersUsed;
    GLbitfield texel_fetch_samplers = prog->info.textures_used_by_txf;
@@ -158,7 +160,7 @@ update_textures(struct st_context *st,
          num_textures = unit + 1;
       }
 
-      pipe_sampler_view_reference(&(sampler_views[unit]), sampler_view);
+      sampler_views[unit] = sampler_view;
    }
 
    /* For any external samplers with multiplaner YUV, stuff the additional
@@ -192,6 +194,7 @@ update_textures(struct st_context *st,
          tmpl.format = PIPE_FORMAT_RG88_UNORM;
          tmpl.swizzle_g = PIPE_SWIZZLE_Y;   /* tmpl from Y plane is R8 */
          extra = u_bit_scan(&free_slots);
+         extra_views |= BITFIELD_BIT(extra);
          sampler_views[extra] =
                st->pipe->create_sampler_view(st->pipe, stObj->pt->next, &tmpl);
          break;
@@ -201,6 +204,7 @@ update_textures(struct st_context *st,
          tmpl.format = PIPE_FORMAT_RG1616_UNORM;
          tmpl.swizzle_g = PIPE_SWIZZLE_Y;   /* tmpl from Y plane is R16 */
          extra = u_bit_scan(&free_slots);
+         extra_views |= BITFIELD_BIT(extra);
          sampler_views[extra] =
                st->pipe->create_sampler_view(st->pipe, stObj->pt->next, &tmpl);
          break;
@@ -208,9 +212,11 @@ update_textures(struct st_context *st,
          /* we need two additional R8 views: */
          tmpl.format = PIPE_FORMAT_R8_UNORM;
          extra = u_bit_scan(&free_slots);
+         extra_views |= BITFIELD_BIT(extra);
          sampler_views[extra] =
                st->pipe->create_sampler_view(st->pipe, stObj->pt->next, &tmpl);
          extra = u_bit_scan(&free_slots);
+         extra_views |= BITFIELD_BIT(extra);
          sampler_views[extra] =
                st->pipe->create_sampler_view(st->pipe, stObj->pt->next->next, &tmpl);
          break;
@@ -220,6 +226,7 @@ update_textures(struct st_context *st,
          tmpl.swizzle_b = PIPE_SWIZZLE_Z;
          tmpl.swizzle_a = PIPE_SWIZZLE_W;
          extra = u_bit_scan(&free_slots);
+         extra_views |= BITFIELD_BIT(extra);
          sampler_views[extra] =
                st->pipe->create_sampler_view(st->pipe, stObj->pt->next, &tmpl);
          break;
@@ -229,6 +236,7 @@ update_textures(struct st_context *st,
          tmpl.swizzle_b = PIPE_SWIZZLE_Z;
          tmpl.swizzle_a = PIPE_SWIZZLE_W;
          extra = u_bit_scan(&free_slots);
+         extra_views |= BITFIELD_BIT(extra);
          sampler_views[extra] =
                st->pipe->create_sampler_view(st->pipe, stObj->pt->next, &tmpl);
          break;
@@ -239,26 +247,35 @@ update_textures(struct st_context *st,
       num_textures = MAX2(num_textures, extra + 1);
    }
 
-   cso_set_sampler_views(st->cso_context,
-                         shader_stage,
-                         num_textures,
-                         sampler_views);
-   st->state.num_sampler_views[shader_stage] = num_textures;
-}
+   /* Only rebind if a slot changed.  Unchanged views are usually found in
+    * the per-context cache of the texture object, so they compare equal.
+    */
+   GLuint num_slots = MAX2(num_textures, old_max);
+   bool changed = false;
 
-/* Same as update_textures, but don't store the views in st_context. */
-static void
-update_textures_local(struct st_context *st,
-                      enum pipe_shader_type shader_stage,
-                      const struct gl_program *prog)
-{
-   struct pipe_sampler_view *local_views[PIPE_MAX_SAMPLERS] = {0};
+   for (unit = 0; unit < num_slots; unit++) {
+      struct pipe_sampler_view *view =
+         unit < num_textures ? sampler_views[unit] : NULL;
 
-   update_textures(st, shader_stage, prog, local_views);
+      if (bound[unit] != view) {
+         pipe_sampler_view_reference(&bound[unit], view);
+         changed = true;
+      }
+   }
+
+   /* The extra views were created above, so drop the creation reference. */
+   while (unlikely(extra_views)) {
+      unit = u_bit_scan(&extra_views);
+      pipe_sampler_view_reference(&sampler_views[unit], NULL);
+   }
 
-   unsigned num = st->state.num_sampler_views[shader_stage];
-   for (unsigned i = 0; i < num; i++)
-      pipe_sampler_view_reference(&local_views[i], NULL);
+   if (changed) {
+      cso_set_sampler_views(st->cso_context,
+                            shader_stage,
+                            num_textures,
+                            bound);
+   }
+   st->state.num_sampler_views[shader_stage] = num_textures;
 }
 
 void
@@ -269,8 +286,7 @@ st_update_vertex_textures(struct st_context *st)
    if (ctx->Const.Program[MESA_SHADER_VERTEX].MaxTextureImageUnits > 0) {
       update_textures(st,
                       PIPE_SHADER_VERTEX,
-                      ctx->VertexProgram._Current,
-                      st->state.vert_sampler_views);
+                      ctx->VertexProgram._Current);
    }
 }
 
@@ -282,8 +298,7 @@ st_update_fragment_textures(struct st_context *st)
 
    update_textures(st,
                    PIPE_SHADER_FRAGMENT,
-                   ctx->FragmentProgram._Current,
-                   st->state.frag_sampler_views);
+                   ctx->FragmentProgram._Current);
 }
 
 
@@ -293,7 +308,7 @@ st_update_geometry_textures(struct st_context *st)
    const struct gl_context *ctx = st->ctx;
 
    if (ctx->GeometryProgram._Current) {
-      update_textures_local(st, PIPE_SHADER_GEOMETRY,
+      update_textures(st, PIPE_SHADER_GEOMETRY,
                             ctx->GeometryProgram._Current);
    }
 }
@@ -305,7 +320,7 @@ st_update_tessctrl_textures(struct st_context *st)
    const struct gl_context *ctx = st->ctx;
 
    if (ctx->TessCtrlProgram._Current) {
-      update_textures_local(st, PIPE_SHADER_TESS_CTRL,
+      update_textures(st, PIPE_SHADER_TESS_CTRL,
                             ctx->TessCtrlProgram._Current);
    }
 }
@@ -317,7 +332,7 @@ st_update_tesseval_textures(struct st_context *st)
    const struct gl_context *ctx = st->ctx;
 
    if (ctx->TessEvalProgram._Current) {
-      update_textures_local(st, PIPE_SHADER_TESS_EVAL,
+      update_textures(st, PIPE_SHADER_TESS_EVAL,
                             ctx->TessEvalProgram._Current);
    }
 }
@@ -329,7 +344,7 @@ st_update_compute_textures(struct st_context *st)
    const struct gl_context *ctx = st->ctx;
 
    if (ctx->ComputeProgram._Current) {
-      update_textures_local(st, PIPE_SHADER_COMPUTE,
+      update_textures(st, PIPE_SHADER_COMPUTE,
                             ctx->ComputeProgram._Current);
    }
 }
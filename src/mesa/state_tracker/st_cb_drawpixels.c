@@ -854,11 +854,11 @@ draw_textured_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
          const struct pipe_sampler_state *samplers[PIPE_MAX_SAMPLERS];
          uint num = MAX3(fpv->drawpix_sampler + 1,
                          fpv->pixelmap_sampler + 1,
-                         st->state.num_frag_samplers);
+                         st->state.num_samplers[PIPE_SHADER_FRAGMENT]);
          uint i;
 
-         for (i = 0; i < st->state.num_frag_samplers; i++)
-            samplers[i] = &st->state.frag_samplers[i];
+         for (i = 0; i < st->state.num_samplers[PIPE_SHADER_FRAGMENT]; i++)
+            samplers[i] = &st->state.samplers[PIPE_SHADER_FRAGMENT][i];
 
          samplers[fpv->drawpix_sampler] = &sampler;
          if (sv[1])
@@ -881,7 +881,7 @@ draw_textured_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
                       fpv->pixelmap_sampler + 1,
                       st->state.num_sampler_views[PIPE_SHADER_FRAGMENT]);
 
-      memcpy(sampler_views, st->state.frag_sampler_views,
+      memcpy(sampler_views, st->state.sampler_views[PIPE_SHADER_FRAGMENT],
              sizeof(sampler_views));
 
       sampler_views[fpv->drawpix_sampler] = sv[0];
@@ -457,9 +457,15 @@ st_destroy_context_priv(struct st_context *st, bool destroy_pipe)
    st_destroy_bound_texture_handles(st);
    st_destroy_bound_image_handles(st);
 
-   for (i = 0; i < ARRAY_SIZE(st->state.frag_sampler_views); i++) {
-      pipe_sampler_view_reference(&st->state.vert_sampler_views[i], NULL);
-      pipe_sampler_view_reference(&st->state.frag_sampler_views[i], NULL);
+   for (unsigned sh = 0; sh < PIPE_SHADER_TYPES; sh++) {
+      for (i = 0; i < PIPE_MAX_SAMPLERS; i++)
+         pipe_sampler_view_reference(&st->state.sampler_views[sh][i], NULL);
+      for (i = 0; i < MAX_UNIFORM_BUFFERS; i++)
+         pipe_resource_reference(&st->state.ubos[sh][i].buffer, NULL);
+      for (i = 0; i < MAX_SHADER_STORAGE_BUFFERS; i++)
+         pipe_resource_reference(&st->state.ssbos[sh][i].buffer, NULL);
+      for (i = 0; i < MAX_IMAGE_UNIFORMS; i++)
+         pipe_resource_reference(&st->state.images[sh][i].resource, NULL);
    }
 
    /* free glReadPixels cache data */
@@ -193,13 +193,23 @@ struct st_context
       struct pipe_blend_state               blend;
       struct pipe_depth_stencil_alpha_state depth_stencil;
       struct pipe_rasterizer_state          rasterizer;
-      struct pipe_sampler_state vert_samplers[PIPE_MAX_SAMPLERS];
-      struct pipe_sampler_state frag_samplers[PIPE_MAX_SAMPLERS];
-      GLuint num_vert_samplers;
-      GLuint num_frag_samplers;
-      struct pipe_sampler_view *vert_sampler_views[PIPE_MAX_SAMPLERS];
-      struct pipe_sampler_view *frag_sampler_views[PIPE_MAX_SAMPLERS];
+      struct pipe_sampler_state samplers[PIPE_SHADER_TYPES][PIPE_MAX_SAMPLERS];
+      GLuint num_samplers[PIPE_SHADER_TYPES];
+      struct pipe_sampler_view *sampler_views[PIPE_SHADER_TYPES][PIPE_MAX_SAMPLERS];
       GLuint num_sampler_views[PIPE_SHADER_TYPES];
+
+      /* What was last bound per slot, so that state validation only rebinds
+       * the slots that changed.  A slot is only compared when its bit is set
+       * in the valid mask; all other slots are bound unconditionally.
+       * Constant buffer 0 isn't included, it holds the default uniforms.
+       */
+      uint32_t valid_samplers[PIPE_SHADER_TYPES];
+      struct pipe_constant_buffer ubos[PIPE_SHADER_TYPES][MAX_UNIFORM_BUFFERS];
+      uint32_t valid_ubos[PIPE_SHADER_TYPES];
+      struct pipe_shader_buffer ssbos[PIPE_SHADER_TYPES][MAX_SHADER_STORAGE_BUFFERS];
+      uint32_t valid_ssbos[PIPE_SHADER_TYPES];
+      struct pipe_image_view images[PIPE_SHADER_TYPES][MAX_IMAGE_UNIFORMS];
+      uint32_t valid_images[PIPE_SHADER_TYPES];
       struct pipe_clip_state clip;
       struct {
          void *ptr;
@@ -156,6 +156,65 @@ prepare_draw(struct st_context *st, struct gl_context *ctx)
    }
 }
 
+/**
+ * Draw runs of prims that only differ in start, count and basevertex with
+ * one cso_multi_draw call each, so that the driver sees a single draw.
+ */
+static void
+st_draw_multi(struct st_context *st, struct pipe_draw_info *info,
+              unsigned start, const struct _mesa_prim *prims,
+              unsigned nr_prims)
+{
+   struct pipe_draw_start_count draws[256];
+   unsigned i, j;
+
+   info->start = 0;
+   info->count = 0;
+   info->index_bias = 0;
+   info->increment_draw_id = true;
+
+   for (i = 0; i < nr_prims; i = j) {
+      unsigned min_index = ~0u, max_index = 0;
+      unsigned num = 0;
+
+      /* drawid is implicitly incremented by one per draw. */
+      for (j = i; j < nr_prims && num < ARRAY_SIZE(draws); j++, num++) {
+         if (prims[j].mode != prims[i].mode ||
+             prims[j].draw_id != prims[i].draw_id + num)
+            break;
+
+         draws[num].start = start + prims[j].start;
+         draws[num].count = prims[j].count;
+         draws[num].index_bias = prims[j].basevertex;
+
+         if (!info->index_size && prims[j].count) {
+            min_index = MIN2(min_index, draws[num].start);
+            max_index = MAX2(max_index,
+                             draws[num].start + prims[j].count - 1);
+         }
+      }
+
+      if (!info->index_size) {
+         /* Skip runs of no-op draw calls. */
+         if (min_index > max_index)
+            continue;
+
+         info->min_index = min_index;
+         info->max_index = max_index;
+      }
+
+      info->mode = translate_prim(st->ctx, prims[i].mode);
+      info->drawid = prims[i].draw_id;
+
+      if (ST_DEBUG & DEBUG_DRAW) {
+         debug_printf("st/draw: mode %s  %u draws  index_size %d\n",
+                      u_prim_name(info->mode), num, info->index_size);
+      }
+
+      cso_multi_draw(st->cso_context, info, draws, num);
+   }
+}
+
 /**
  * This function gets plugged into the VBO module and is called when
  * we have something to render.
@@ -237,6 +296,12 @@ st_draw_vbo(struct gl_context *ctx,
       }
    }
 
+   /* Let the driver validate state once for all prims. */
+   if (nr_prims > 1 && !tfb_vertcount) {
+      st_draw_multi(st, &info, start, prims, nr_prims);
+      return;
+   }
+
    /* do actual drawing */
    for (i = 0; i < nr_prims; i++) {
       info.count = prims[i].count;
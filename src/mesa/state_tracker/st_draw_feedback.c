@@ -289,21 +289,22 @@ st_feedback_draw_vbo(struct gl_context *ctx,
 
    /* samplers */
    struct pipe_sampler_state *samplers[PIPE_MAX_SAMPLERS];
-   for (unsigned i = 0; i < st->state.num_vert_samplers; i++)
-      samplers[i] = &st->state.vert_samplers[i];
+   for (unsigned i = 0; i < st->state.num_samplers[PIPE_SHADER_VERTEX]; i++)
+      samplers[i] = &st->state.samplers[PIPE_SHADER_VERTEX][i];
 
    draw_set_samplers(draw, PIPE_SHADER_VERTEX, samplers,
-                     st->state.num_vert_samplers);
+                     st->state.num_samplers[PIPE_SHADER_VERTEX]);
 
    /* sampler views */
    draw_set_sampler_views(draw, PIPE_SHADER_VERTEX,
-                          st->state.vert_sampler_views,
+                          st->state.sampler_views[PIPE_SHADER_VERTEX],
                           st->state.num_sampler_views[PIPE_SHADER_VERTEX]);
 
    struct pipe_transfer *sv_transfer[PIPE_MAX_SAMPLERS][PIPE_MAX_TEXTURE_LEVELS];
 
    for (unsigned i = 0; i < st->state.num_sampler_views[PIPE_SHADER_VERTEX]; i++) {
-      struct pipe_sampler_view *view = st->state.vert_sampler_views[i];
+      struct pipe_sampler_view *view =
+         st->state.sampler_views[PIPE_SHADER_VERTEX][i];
       if (!view)
          continue;
 
@@ -453,7 +454,8 @@ st_feedback_draw_vbo(struct gl_context *ctx,
 
    /* unmap sampler views */
    for (unsigned i = 0; i < st->state.num_sampler_views[PIPE_SHADER_VERTEX]; i++) {
-      struct pipe_sampler_view *view = st->state.vert_sampler_views[i];
+      struct pipe_sampler_view *view =
+         st->state.sampler_views[PIPE_SHADER_VERTEX][i];
 
       if (view) {
          if (view->texture->target != PIPE_BUFFER) {